@@ -0,0 +1,179 @@
+#ifndef UNAPPROVED_CCS_SPMV_H_
+#define UNAPPROVED_CCS_SPMV_H_
+
+// y = A x and Y = A X (k right-hand sides) for a matrix stored by columns
+// (CCS), shared by the TBB modules that keep CCS matrices; the module
+// links TBB. Every product runs on tbb::parallel_for (*_tbb) or on one
+// std::thread per hardware thread (*_std).
+//
+// A column j adds A(:, j) X(j, :) to Y, so the columns scatter into Y and
+// two threads may hit the same row. Rather than atomics, the columns are
+// cut into chunks of about the same nonzeros and every chunk scatters
+// into its own copy of Y (the first one into Y itself); the copies are
+// then summed by rows in parallel. The chunks are fixed by the matrix and
+// the worker count, not by the scheduler, so the result is the same from
+// run to run. A matrix with few nonzeros is done by the calling thread.
+//
+// X (cols x k) and Y (rows x k) are stored row by row, so every nonzero
+// updates k contiguous values. For k = 4, 8, 16, 32 and 64 the kernel is
+// instantiated with the width known at compile time: the row of X a
+// column scatters is held in registers and the update is unrolled.
+//
+// Every index may be 0- or 1-based: base is subtracted from the column
+// pointers and the row numbers.
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>  // NOLINT [build/c++11]
+#include <vector>
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+namespace pspmv {
+
+// products with fewer updates (nonzeros times k) are done by the calling
+// thread
+const std::size_t kSequential = 1 << 14;
+
+enum class Backend { Tbb, Thread };
+
+// adds the columns [from, to) of A times X to Y. K > 0: k == K known at
+// compile time; K == 0: any k
+template <int K, class Index>
+void ccs_spmm_chunk(const Index* ptr, const Index* row, const double* val,
+                    Index base, const double* X, int k, double* Y,
+                    Index from, Index to) {
+  const std::size_t width = K > 0 ? K : k;
+  double fixed[K > 0 ? K : 1];
+  for (Index j = from; j < to; j++) {
+    const double* x = X + static_cast<std::size_t>(j) * width;
+    if (K > 0) {
+      std::copy(x, x + width, fixed);
+      x = fixed;
+    }
+    for (Index p = ptr[j] - base; p < ptr[j + 1] - base; p++) {
+      const double v = val[p];
+      double* y = Y + static_cast<std::size_t>(row[p] - base) * width;
+      for (std::size_t c = 0; c < width; c++) y[c] += v * x[c];
+    }
+  }
+}
+
+// body(c) for c < n on the back-end
+template <class Body>
+void for_each_chunk(Backend backend, std::size_t n, const Body& body) {
+  if (backend == Backend::Tbb) {
+    tbb::parallel_for(std::size_t(0), n, body);
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (std::size_t c = 1; c < n; c++) threads.emplace_back(body, c);
+  body(0);
+  for (auto& thread : threads) thread.join();
+}
+
+inline std::size_t worker_count(Backend backend) {
+  return backend == Backend::Tbb
+             ? tbb::this_task_arena::max_concurrency()
+             : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Y[0, rows * k) = A X, A is rows x cols with ptr[cols + 1], row[nnz],
+// val[nnz]; k == K unless K == 0
+template <int K, class Index>
+void ccs_spmm(Backend backend, Index rows, Index cols, const Index* ptr,
+              const Index* row, const double* val, Index base,
+              const double* X, int k, double* Y) {
+  const std::size_t width = K > 0 ? K : k;
+  std::fill(Y, Y + rows * width, 0.0);
+  const std::size_t nnz = cols > 0 ? ptr[cols] - ptr[0] : 0;
+  const std::size_t chunks =
+      std::min(worker_count(backend), nnz * width / kSequential);
+  if (chunks < 2) {
+    ccs_spmm_chunk<K>(ptr, row, val, base, X, k, Y, Index(0), cols);
+    return;
+  }
+
+  // first column of every chunk, so that they get about the same nonzeros
+  std::vector<Index> first(chunks + 1, cols);
+  first[0] = 0;
+  for (std::size_t c = 1; c < chunks; c++)
+    first[c] = static_cast<Index>(
+        std::upper_bound(ptr, ptr + cols + 1,
+                         ptr[0] + static_cast<Index>(nnz / chunks * c)) -
+        ptr - 1);
+
+  std::vector<std::vector<double>> partial(chunks - 1);
+  for_each_chunk(backend, chunks, [&](std::size_t c) {
+    double* out = Y;
+    if (c > 0) {
+      partial[c - 1].assign(rows * width, 0.0);
+      out = partial[c - 1].data();
+    }
+    ccs_spmm_chunk<K>(ptr, row, val, base, X, k, out, first[c],
+                      first[c + 1]);
+  });
+  // the copies are summed over equal slices of Y
+  const std::size_t size = rows * width;
+  for_each_chunk(backend, chunks, [&](std::size_t c) {
+    const std::size_t begin = size * c / chunks;
+    const std::size_t end = size * (c + 1) / chunks;
+    for (const auto& part : partial)
+      for (std::size_t i = begin; i < end; i++) Y[i] += part[i];
+  });
+}
+
+// the width dispatch of ccs_spmm for a k known only at run time
+template <class Index>
+void ccs_spmm_any(Backend backend, Index rows, Index cols, const Index* ptr,
+                  const Index* row, const double* val, Index base,
+                  const double* X, int k, double* Y) {
+  switch (k) {
+    case 1:
+      return ccs_spmm<1>(backend, rows, cols, ptr, row, val, base, X, k, Y);
+    case 4:
+      return ccs_spmm<4>(backend, rows, cols, ptr, row, val, base, X, k, Y);
+    case 8:
+      return ccs_spmm<8>(backend, rows, cols, ptr, row, val, base, X, k, Y);
+    case 16:
+      return ccs_spmm<16>(backend, rows, cols, ptr, row, val, base, X, k, Y);
+    case 32:
+      return ccs_spmm<32>(backend, rows, cols, ptr, row, val, base, X, k, Y);
+    case 64:
+      return ccs_spmm<64>(backend, rows, cols, ptr, row, val, base, X, k, Y);
+    default:
+      return ccs_spmm<0>(backend, rows, cols, ptr, row, val, base, X, k, Y);
+  }
+}
+
+template <class Index>
+void ccs_spmv_tbb(Index rows, Index cols, const Index* ptr, const Index* row,
+                  const double* val, Index base, const double* x, double* y) {
+  ccs_spmm<1>(Backend::Tbb, rows, cols, ptr, row, val, base, x, 1, y);
+}
+
+template <class Index>
+void ccs_spmv_std(Index rows, Index cols, const Index* ptr, const Index* row,
+                  const double* val, Index base, const double* x, double* y) {
+  ccs_spmm<1>(Backend::Thread, rows, cols, ptr, row, val, base, x, 1, y);
+}
+
+template <int K, class Index>
+void ccs_spmm_tbb(Index rows, Index cols, const Index* ptr, const Index* row,
+                  const double* val, Index base, const double* X, double* Y) {
+  static_assert(K > 0, "the width of ccs_spmm_tbb is fixed");
+  ccs_spmm<K>(Backend::Tbb, rows, cols, ptr, row, val, base, X, K, Y);
+}
+
+template <int K, class Index>
+void ccs_spmm_std(Index rows, Index cols, const Index* ptr, const Index* row,
+                  const double* val, Index base, const double* X, double* Y) {
+  static_assert(K > 0, "the width of ccs_spmm_std is fixed");
+  ccs_spmm<K>(Backend::Thread, rows, cols, ptr, row, val, base, X, K, Y);
+}
+
+}  // namespace pspmv
+
+#endif  // UNAPPROVED_CCS_SPMV_H_
@@ -0,0 +1,126 @@
+#ifndef UNAPPROVED_DOUBLE_KEYS_H_
+#define UNAPPROVED_DOUBLE_KEYS_H_
+
+// Radix sorting of doubles by their IEEE-754 bit pattern. The keys are
+// kept in the double buffers themselves as raw 64-bit patterns mapped by
+// to_key, so that their unsigned order is the order of the doubles, and
+// are mapped back by from_key once sorted.
+//
+// lsd_sort_keys is the sequential building block: the parallel sorts
+// partition the keys by one digit first (top_digit_shift) and then sort
+// every bucket with it.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace dkeys {
+
+const int kDigitBits = 11;
+const int kDigitSize = 1 << kDigitBits;
+const uint64_t kDigitMask = kDigitSize - 1;
+const int kMaxPasses = (64 + kDigitBits - 1) / kDigitBits;
+const uint64_t kSignBit = 1ull << 63;
+const std::size_t kInsertionThreshold = 64;
+
+// memcpy keeps the accesses free of strict aliasing problems
+inline uint64_t load_key(const double* buf, std::size_t i) {
+  uint64_t key;
+  std::memcpy(&key, buf + i, sizeof(key));
+  return key;
+}
+inline void store_key(double* buf, std::size_t i, uint64_t key) {
+  std::memcpy(buf + i, &key, sizeof(key));
+}
+
+// Unsigned order of the keys matches the order of the doubles: negatives
+// get all bits inverted, positives get the sign bit set. -0.0 goes right
+// before +0.0, NaNs with the sign bit go before -inf, the others after +inf
+inline uint64_t to_key(uint64_t bits) {
+  return (bits & kSignBit) ? ~bits : bits | kSignBit;
+}
+inline uint64_t from_key(uint64_t key) {
+  return (key & kSignBit) ? key & ~kSignBit : ~key;
+}
+
+inline void insertion_sort_keys(double* buf, std::size_t n) {
+  for (std::size_t i = 1; i < n; i++) {
+    uint64_t key = load_key(buf, i);
+    std::size_t j = i;
+    for (; j > 0 && load_key(buf, j - 1) > key; j--)
+      store_key(buf, j, load_key(buf, j - 1));
+    store_key(buf, j, key);
+  }
+}
+
+// Sorts n keys by their low `bits` bits with 11-bit LSD passes, moving
+// between src and tmp. count must hold kMaxPasses * kDigitSize entries.
+// Returns the buffer that holds the sorted keys
+inline double* lsd_sort_keys(double* src, double* tmp, std::size_t n,
+                             int bits, std::size_t* count) {
+  if (n < kInsertionThreshold) {
+    insertion_sort_keys(src, n);
+    return src;
+  }
+
+  int passes = (bits + kDigitBits - 1) / kDigitBits;
+  std::fill(count, count + passes * kDigitSize, 0);
+  for (std::size_t i = 0; i < n; i++) {
+    uint64_t key = load_key(src, i);
+    for (int p = 0; p < passes; p++)
+      count[p * kDigitSize + ((key >> (p * kDigitBits)) & kDigitMask)]++;
+  }
+
+  for (int p = 0; p < passes; p++) {
+    std::size_t* cursor = count + p * kDigitSize;
+    int shift = p * kDigitBits;
+    // Every key has the same digit, the pass would be a plain copy
+    if (cursor[(load_key(src, 0) >> shift) & kDigitMask] == n)
+      continue;
+
+    std::size_t offset = 0;
+    for (int d = 0; d < kDigitSize; d++) {
+      std::size_t tmp_count = cursor[d];
+      cursor[d] = offset;
+      offset += tmp_count;
+    }
+    for (std::size_t i = 0; i < n; i++) {
+      uint64_t key = load_key(src, i);
+      store_key(tmp, cursor[(key >> shift) & kDigitMask]++, key);
+    }
+    std::swap(src, tmp);
+  }
+  return src;
+}
+
+// In place sort of data[0, n), scratch must hold n doubles
+inline void sort(double* data, std::size_t n, double* scratch) {
+  if (n < 2)
+    return;
+  for (std::size_t i = 0; i < n; i++)
+    store_key(data, i, to_key(load_key(data, i)));
+
+  std::vector<std::size_t> count(kMaxPasses * kDigitSize);
+  double* sorted = lsd_sort_keys(data, scratch, n, 64, count.data());
+
+  for (std::size_t i = 0; i < n; i++)
+    store_key(data, i, from_key(load_key(sorted, i)));
+}
+
+// Shift of the partitioning digit of keys in [lo, hi]. Bits above the
+// highest one that differs between lo and hi are equal for every key, so
+// the digit is taken right below it. This keeps data like [1, 2) from
+// landing in one bucket
+inline int top_digit_shift(uint64_t lo, uint64_t hi) {
+  uint64_t diff = lo ^ hi;
+  int top_bits = 0;
+  while (top_bits < 64 && (diff >> top_bits) != 0)
+    top_bits++;
+  return std::max(0, top_bits - kDigitBits);
+}
+
+}  // namespace dkeys
+
+#endif  // UNAPPROVED_DOUBLE_KEYS_H_
@@ -0,0 +1,497 @@
+#ifndef UNAPPROVED_MATRIX_MARKET_H_
+#define UNAPPROVED_MATRIX_MARKET_H_
+
+// Parallel reading of Matrix Market coordinate files into CRS arrays,
+// shared by the sparse modules whatever their index and value types.
+//
+// The file is mapped (mmap where there is one, read into memory
+// otherwise) and the body is cut at line ends into one piece per thread;
+// every thread parses its piece with a Cursor into coordinates. The
+// entries are then put in row order by a counting sort (atomic row
+// counters, a scan, a scatter) and every row is sorted by column. The
+// mirrored half of a symmetric file is added; duplicate entries are kept
+// as they are.
+//
+// A module reads the header with read_header, rejects the fields its
+// value type cannot hold and passes read_entries a parser of one value:
+//
+//   mmarket::FileMap file(path);
+//   mmarket::Header header = mmarket::read_header(file, path);
+//   mmarket::Csr<int, int> csr = mmarket::read_entries<int, int>(
+//       file, header, threads,
+//       [](mmarket::Cursor& in, mmarket::Field f) { ... });
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT [build/c++11]
+#include <vector>
+
+#include "parallel_scan.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MATRIX_MARKET_MMAP
+#endif
+
+namespace mmarket {
+
+// A whole file, read-only: mapped with mmap where there is one, read into
+// memory otherwise
+class FileMap {
+  const char* data_;
+  std::size_t size_;
+  std::vector<char> buffer_;
+  bool mapped_;
+
+ public:
+  explicit FileMap(const std::string& path)
+      : data_(nullptr), size_(0), mapped_(false) {
+#ifdef MATRIX_MARKET_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      throw std::runtime_error("Cannot stat " + path);
+    }
+    size_ = st.st_size;
+    if (size_ > 0) {
+      void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (p == MAP_FAILED) throw std::runtime_error("Cannot map " + path);
+      data_ = static_cast<const char*>(p);
+      mapped_ = true;
+    } else {
+      close(fd);
+    }
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot open " + path);
+    in.seekg(0, std::ios::end);
+    size_ = static_cast<std::size_t>(in.tellg());
+    in.seekg(0, std::ios::beg);
+    buffer_.resize(size_);
+    in.read(buffer_.data(), size_);
+    data_ = buffer_.data();
+#endif
+  }
+  FileMap(const FileMap&) = delete;
+  FileMap& operator=(const FileMap&) = delete;
+  ~FileMap() {
+#ifdef MATRIX_MARKET_MMAP
+    if (mapped_) munmap(const_cast<char*>(data_), size_);
+#endif
+  }
+  const char* data() const { return data_; }
+  std::size_t size() const { return size_; }
+};
+
+inline unsigned thread_count(unsigned threads) {
+  return threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// f(t) for t < n, t = 0 on the calling thread; the first exception thrown
+// by a worker is rethrown after all of them have finished
+template <class F>
+void run_threads(unsigned n, const F& f) {
+  std::vector<std::exception_ptr> errors(n);
+  auto guarded = [&](unsigned t) {
+    try {
+      f(t);
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < n; ++t) threads.emplace_back(guarded, t);
+  guarded(0);
+  for (auto& thread : threads) thread.join();
+  for (auto& error : errors)
+    if (error) std::rethrow_exception(error);
+}
+
+// first row of every thread so that they get about the same nonzeros
+template <class Index>
+std::vector<std::size_t> split_rows(const Index* row_index, std::size_t rows,
+                                    unsigned threads) {
+  std::vector<std::size_t> first(threads + 1, rows);
+  first[0] = 0;
+  for (unsigned t = 1; t < threads; ++t)
+    first[t] = std::upper_bound(row_index, row_index + rows + 1,
+                                row_index[rows] / threads * t) -
+               row_index - 1;
+  return first;
+}
+
+enum class Field { Real, Integer, Complex, Pattern };
+enum class Symmetry { General, Symmetric, SkewSymmetric, Hermitian };
+
+// the C library versions depend on the locale and are not inlined
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+inline bool is_space(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' ||
+         c == '\f';
+}
+
+// parses numbers out of [p, end), which is not zero-terminated
+class Cursor {
+  const char* p_;
+  const char* end_;
+
+  void fail() const {
+    throw std::runtime_error("Malformed Matrix Market entry");
+  }
+
+ public:
+  Cursor(const char* begin, const char* end) : p_(begin), end_(end) {}
+  const char* position() const { return p_; }
+  bool at_end() const { return p_ == end_; }
+  char peek() const { return *p_; }
+
+  void skip_blanks() {
+    while (p_ != end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r')) ++p_;
+  }
+  void skip_line() {
+    p_ = std::find(p_, end_, '\n');
+    if (p_ != end_) ++p_;
+  }
+  // the rest of the line must be blank
+  void end_line() {
+    skip_blanks();
+    if (p_ != end_ && *p_ != '\n') fail();
+    skip_line();
+  }
+  std::string word() {
+    skip_blanks();
+    const char* begin = p_;
+    while (p_ != end_ && !is_space(*p_)) ++p_;
+    std::string w(begin, p_);
+    for (char& c : w) c = std::tolower(static_cast<unsigned char>(c));
+    return w;
+  }
+  std::size_t index() {
+    skip_blanks();
+    if (p_ == end_ || !is_digit(*p_)) fail();
+    std::size_t value = 0;
+    while (p_ != end_ && is_digit(*p_))
+      value = value * 10 + (*p_++ - '0');
+    return value;
+  }
+  // an optionally signed decimal integer that fits T
+  template <class T>
+  T integer() {
+    skip_blanks();
+    bool negative = p_ != end_ && *p_ == '-';
+    if (p_ != end_ && (*p_ == '-' || *p_ == '+')) ++p_;
+    if (p_ == end_ || !is_digit(*p_)) fail();
+    // the magnitude is accumulated negated, -min does not fit T
+    const T low = std::numeric_limits<T>::min();
+    const T high = std::numeric_limits<T>::max();
+    T value = 0;
+    while (p_ != end_ && is_digit(*p_)) {
+      const T digit = *p_++ - '0';
+      if (value < (low + digit) / 10) fail();
+      value = value * 10 - digit;
+    }
+    if (p_ != end_ && !is_space(*p_)) fail();
+    if (negative) return value;
+    if (value < -high) fail();
+    return -value;
+  }
+  double number() {
+    skip_blanks();
+    const char* begin = p_;
+    while (p_ != end_ && !is_space(*p_)) ++p_;
+    double value;
+    if (!fast_number(begin, p_, &value)) value = slow_number(begin, p_);
+    return value;
+  }
+
+ private:
+  // Clinger's fast path: up to 15 significant digits and a decimal
+  // exponent within 22 make both the mantissa and the power of ten exact
+  // doubles, so one multiplication or division rounds correctly
+  static bool fast_number(const char* p, const char* end, double* value) {
+    static const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                    1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                    1e18, 1e19, 1e20, 1e21, 1e22};
+    bool negative = p != end && *p == '-';
+    if (p != end && (*p == '-' || *p == '+')) ++p;
+    int64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false, dot = false;
+    for (; p != end; ++p) {
+      if (*p == '.' && !dot) {
+        dot = true;
+      } else if (is_digit(*p)) {
+        any = true;
+        if (mantissa == 0 && *p == '0') {
+          if (dot) --exponent;
+          continue;
+        }
+        if (++digits > 15) return false;
+        mantissa = mantissa * 10 + (*p - '0');
+        if (dot) --exponent;
+      } else {
+        break;
+      }
+    }
+    if (!any) return false;
+    if (p != end) {
+      if (*p != 'e' && *p != 'E') return false;
+      ++p;
+      bool minus = p != end && *p == '-';
+      if (p != end && (*p == '-' || *p == '+')) ++p;
+      if (p == end) return false;
+      int e = 0;
+      for (; p != end; ++p) {
+        if (!is_digit(*p) || e > 1000)
+          return false;
+        e = e * 10 + (*p - '0');
+      }
+      exponent += minus ? -e : e;
+    }
+    if (exponent < -22 || exponent > 22) return false;
+    double x = static_cast<double>(mantissa);
+    x = exponent < 0 ? x / kPow10[-exponent] : x * kPow10[exponent];
+    *value = negative ? -x : x;
+    return true;
+  }
+
+  // strtod needs a terminated string, a number is short
+  double slow_number(const char* begin, const char* end) const {
+    char token[64];
+    std::size_t n = std::min<std::size_t>(end - begin, sizeof(token) - 1);
+    std::copy(begin, begin + n, token);
+    token[n] = '\0';
+    char* stop = nullptr;
+    double value = std::strtod(token, &stop);
+    if (n == 0 || stop != token + (end - begin)) fail();
+    return value;
+  }
+};
+
+struct Header {
+  Field field;
+  Symmetry symmetry;
+  std::size_t rows, cols, entries;
+  // the first byte after the size line
+  const char* body;
+};
+
+inline Field parse_field(const std::string& field) {
+  if (field == "real") return Field::Real;
+  if (field == "integer") return Field::Integer;
+  if (field == "complex") return Field::Complex;
+  if (field == "pattern") return Field::Pattern;
+  throw std::runtime_error("Unknown Matrix Market field " + field);
+}
+
+inline Symmetry parse_symmetry(const std::string& symmetry) {
+  if (symmetry == "general") return Symmetry::General;
+  if (symmetry == "symmetric") return Symmetry::Symmetric;
+  if (symmetry == "skew-symmetric") return Symmetry::SkewSymmetric;
+  if (symmetry == "hermitian") return Symmetry::Hermitian;
+  throw std::runtime_error("Unknown Matrix Market symmetry " + symmetry);
+}
+
+// the banner, the comments and the size line
+inline Header read_header(const FileMap& file, const std::string& path) {
+  Cursor in(file.data(), file.data() + file.size());
+  if (in.word() != "%%matrixmarket" || in.word() != "matrix")
+    throw std::runtime_error(path + " is not a Matrix Market file");
+  if (in.word() != "coordinate")
+    throw std::runtime_error("Only coordinate Matrix Market files are read");
+  Header header;
+  header.field = parse_field(in.word());
+  const std::string symmetry = in.word();
+  header.symmetry = parse_symmetry(symmetry);
+  in.skip_line();
+  while (true) {
+    in.skip_blanks();
+    if (in.at_end()) throw std::runtime_error("No size line in " + path);
+    if (in.peek() != '%' && in.peek() != '\n') break;
+    in.skip_line();
+  }
+  header.rows = in.index();
+  header.cols = in.index();
+  header.entries = in.index();
+  in.end_line();
+  // a mirrored entry (j, i) of a non-square matrix may fall outside it
+  if (header.symmetry != Symmetry::General && header.rows != header.cols)
+    throw std::runtime_error("Only a square Matrix Market matrix can be " +
+                             symmetry);
+  header.body = in.position();
+  return header;
+}
+
+// the value stored at (j, i) for the one read at (i, j); a real
+// hermitian matrix is a symmetric one
+template <class T>
+T conjugate(const T& value) {
+  return value;
+}
+template <class T>
+std::complex<T> conjugate(const std::complex<T>& value) {
+  return std::conj(value);
+}
+template <class Value>
+Value mirror(Symmetry symmetry, const Value& value) {
+  if (symmetry == Symmetry::SkewSymmetric) return -value;
+  if (symmetry == Symmetry::Hermitian) return conjugate(value);
+  return value;
+}
+
+// 0-based CRS arrays, row_index has rows + 1 entries
+template <class Index, class Value>
+struct Csr {
+  std::size_t rows, cols;
+  std::vector<Index> row_index, col_index;
+  std::vector<Value> val;
+};
+
+// Reads the entries after header, parse(cursor, field) reads the value
+// of one of them (the indices are read already). The sizes and the
+// number of nonzeros must fit Index. threads == 0 means
+// std::thread::hardware_concurrency()
+template <class Index, class Value, class Parse>
+Csr<Index, Value> read_entries(const FileMap& file, const Header& header,
+                               unsigned threads, const Parse& parse) {
+  const std::size_t rows = header.rows, cols = header.cols;
+  const std::size_t limit =
+      static_cast<std::size_t>(std::numeric_limits<Index>::max());
+  if (rows > limit || cols > limit)
+    throw std::runtime_error("Matrix Market size does not fit the index");
+
+  struct Coordinates {
+    std::vector<Index> row, col;
+    std::vector<Value> val;
+  };
+  struct Entry {
+    Index col;
+    Value val;
+  };
+
+  // <Parsing>
+  const char* body = header.body;
+  const char* end = file.data() + file.size();
+  const unsigned threadNum = thread_count(threads);
+  std::vector<Coordinates> parts(threadNum);
+  auto pieceBegin = [&](unsigned t) {
+    const char* p = body + (end - body) * static_cast<int64_t>(t) / threadNum;
+    while (p != body && p != end && p[-1] != '\n') ++p;
+    return p;
+  };
+  run_threads(threadNum, [&](unsigned t) {
+    Cursor in(pieceBegin(t), pieceBegin(t + 1));
+    Coordinates& part = parts[t];
+    // the share of the declared entries that the piece's bytes suggest
+    // (a line takes at least 4 bytes, which bounds a wrong header)
+    const int64_t bytes = pieceBegin(t + 1) - pieceBegin(t);
+    std::size_t guess = static_cast<std::size_t>(std::min<double>(
+        bytes / 4, static_cast<double>(header.entries) * bytes /
+                       std::max<int64_t>(1, end - body) * 1.05)) + 16;
+    part.row.reserve(guess);
+    part.col.reserve(guess);
+    part.val.reserve(guess);
+    while (!in.at_end()) {
+      in.skip_blanks();
+      if (in.at_end()) break;
+      if (in.peek() == '\n' || in.peek() == '%') {
+        in.skip_line();
+        continue;
+      }
+      std::size_t i = in.index(), j = in.index();
+      if (i < 1 || i > rows || j < 1 || j > cols)
+        throw std::runtime_error("Matrix Market entry out of range");
+      Value value = parse(in, header.field);
+      in.end_line();
+      part.row.push_back(static_cast<Index>(i - 1));
+      part.col.push_back(static_cast<Index>(j - 1));
+      part.val.push_back(value);
+    }
+  });
+  std::size_t entries = 0;
+  for (const auto& part : parts) entries += part.row.size();
+  if (entries != header.entries)
+    throw std::runtime_error("Matrix Market entry count does not match");
+  // </Parsing>
+
+  // <Counting sort>
+  // the mirrored half of a symmetric matrix is counted and scattered
+  // along with the stored one
+  const Symmetry s = header.symmetry;
+  const bool mirrored = s != Symmetry::General;
+  std::vector<std::atomic<std::size_t>> counter(rows);
+  for (auto& c : counter) c.store(0, std::memory_order_relaxed);
+  run_threads(threadNum, [&](unsigned t) {
+    const Coordinates& part = parts[t];
+    for (std::size_t k = 0; k < part.row.size(); ++k) {
+      counter[part.row[k]].fetch_add(1, std::memory_order_relaxed);
+      if (mirrored && part.row[k] != part.col[k])
+        counter[part.col[k]].fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+  std::vector<std::size_t> offset(rows + 1, 0);
+  for (std::size_t i = 0; i < rows; ++i)
+    offset[i] = counter[i].load(std::memory_order_relaxed);
+  const std::size_t nonZeros =
+      pscan::exclusive_scan_std(offset.data(), offset.data(), rows + 1);
+  if (nonZeros > limit)
+    throw std::runtime_error("Matrix Market nonzeros do not fit the index");
+  for (std::size_t i = 0; i < rows; ++i)
+    counter[i].store(offset[i], std::memory_order_relaxed);
+
+  std::vector<Entry> sorted(nonZeros);
+  run_threads(threadNum, [&](unsigned t) {
+    Coordinates& part = parts[t];
+    for (std::size_t k = 0; k < part.row.size(); ++k) {
+      Index i = part.row[k], j = part.col[k];
+      sorted[counter[i].fetch_add(1, std::memory_order_relaxed)] = {
+          j, part.val[k]};
+      if (mirrored && i != j)
+        sorted[counter[j].fetch_add(1, std::memory_order_relaxed)] = {
+            i, mirror(s, part.val[k])};
+    }
+    part = Coordinates();
+  });
+  // </Counting sort>
+
+  // the scatter leaves the entries of a row in any order
+  Csr<Index, Value> csr;
+  csr.rows = rows;
+  csr.cols = cols;
+  csr.row_index.assign(offset.begin(), offset.end());
+  csr.col_index.resize(nonZeros);
+  csr.val.resize(nonZeros);
+  std::vector<std::size_t> first = split_rows(offset.data(), rows, threadNum);
+  run_threads(threadNum, [&](unsigned t) {
+    for (std::size_t i = first[t]; i < first[t + 1]; ++i) {
+      std::sort(sorted.begin() + offset[i], sorted.begin() + offset[i + 1],
+                [](const Entry& a, const Entry& b) { return a.col < b.col; });
+      for (std::size_t k = offset[i]; k < offset[i + 1]; ++k) {
+        csr.col_index[k] = sorted[k].col;
+        csr.val[k] = sorted[k].val;
+      }
+    }
+  });
+  return csr;
+}
+
+}  // namespace mmarket
+
+#endif  // UNAPPROVED_MATRIX_MARKET_H_
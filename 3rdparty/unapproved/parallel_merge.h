@@ -0,0 +1,177 @@
+#ifndef UNAPPROVED_PARALLEL_MERGE_H_
+#define UNAPPROVED_PARALLEL_MERGE_H_
+
+// k-way merging of sorted runs on std::threads, shared by the merge sorts
+// that sort chunks in parallel and then need them merged.
+//
+// The output is cut into one equal slice per thread. For the first rank
+// of its slice every thread finds how many elements of each run come
+// before it (merge path / co-rank split, a binary search for the element
+// of that rank over all the runs), then merges its slice on its own with
+// a heap of run heads. The slices are disjoint, so the threads do not
+// synchronize. Equal keys come out from the runs with lower indices
+// first, the merge is stable across the runs.
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <thread>  // NOLINT [build/c++11]
+#include <utility>
+#include <vector>
+
+namespace pmerge {
+
+// Read-only view of a sorted run, nothing is copied
+template <class T>
+struct sorted_span {
+  const T* data;
+  std::size_t size;
+};
+
+// How many elements of every run go to the first rank elements of the
+// output: out[0, rank) = merge of spans[i].data[0, splits[i]).
+// The element of that rank is found by binary search inside each run,
+// every step ranking its candidate with a binary search in all k runs
+// (O(k^2 log^2 n) in all), equal keys are given to the runs with lower
+// indices first, so splits of growing ranks never move backwards
+template <class T>
+std::vector<std::size_t> merge_path_splits(
+    const std::vector<sorted_span<T>>& spans, std::size_t rank) {
+  const std::size_t k = spans.size();
+  std::vector<std::size_t> splits(k, 0);
+  std::size_t total = 0;
+  for (const auto& span : spans) {
+    total += span.size;
+  }
+  if (rank == 0) {
+    return splits;
+  }
+  if (rank >= total) {
+    for (std::size_t i = 0; i < k; i++) {
+      splits[i] = spans[i].size;
+    }
+    return splits;
+  }
+
+  auto lower_rank = [&spans](const T& value) {
+    std::size_t r = 0;
+    for (const auto& span : spans) {
+      r += std::lower_bound(span.data, span.data + span.size, value) -
+           span.data;
+    }
+    return r;
+  };
+  auto upper_rank = [&spans](const T& value) {
+    std::size_t r = 0;
+    for (const auto& span : spans) {
+      r += std::upper_bound(span.data, span.data + span.size, value) -
+           span.data;
+    }
+    return r;
+  };
+
+  // Element with lower_rank <= rank < upper_rank is in one of the runs
+  const T* pivot = nullptr;
+  for (std::size_t j = 0; j < k && pivot == nullptr; j++) {
+    std::size_t lo = 0, hi = spans[j].size;
+    while (lo < hi) {
+      std::size_t mid = lo + (hi - lo) / 2;
+      const T& value = spans[j].data[mid];
+      if (upper_rank(value) <= rank) {
+        lo = mid + 1;
+      } else if (lower_rank(value) > rank) {
+        hi = mid;
+      } else {
+        pivot = &spans[j].data[mid];
+        break;
+      }
+    }
+  }
+
+  std::size_t taken = 0;
+  for (std::size_t i = 0; i < k; i++) {
+    splits[i] = std::lower_bound(spans[i].data,
+                                 spans[i].data + spans[i].size, *pivot) -
+                spans[i].data;
+    taken += splits[i];
+  }
+  for (std::size_t i = 0; i < k && taken < rank; i++) {
+    std::size_t equal = std::upper_bound(spans[i].data,
+                                         spans[i].data + spans[i].size,
+                                         *pivot) -
+                        spans[i].data - splits[i];
+    std::size_t add = std::min(equal, rank - taken);
+    splits[i] += add;
+    taken += add;
+  }
+  return splits;
+}
+
+// Sequential k-way merge of spans[i].data[begin[i], end[i]) into out
+template <class T>
+void multiway_merge(const std::vector<sorted_span<T>>& spans,
+                    const std::vector<std::size_t>& begin,
+                    const std::vector<std::size_t>& end, T* out) {
+  // heap of (head value, run index), the smallest head on top
+  typedef std::pair<T, std::size_t> head;
+  std::vector<head> heads;
+  std::vector<std::size_t> pos(begin);
+  for (std::size_t i = 0; i < spans.size(); i++) {
+    if (pos[i] < end[i]) {
+      heads.push_back(head(spans[i].data[pos[i]], i));
+    }
+  }
+  std::greater<head> later;
+  std::make_heap(heads.begin(), heads.end(), later);
+  while (heads.size() > 1) {
+    std::pop_heap(heads.begin(), heads.end(), later);
+    std::size_t i = heads.back().second;
+    *out++ = heads.back().first;
+    if (++pos[i] < end[i]) {
+      heads.back().first = spans[i].data[pos[i]];
+      std::push_heap(heads.begin(), heads.end(), later);
+    } else {
+      heads.pop_back();
+    }
+  }
+  if (!heads.empty()) {
+    std::size_t i = heads.back().second;
+    std::copy(spans[i].data + pos[i], spans[i].data + end[i], out);
+  }
+}
+
+// Merges k sorted runs into out on num_threads threads. Every thread
+// finds where its equal share of the output starts in each run (merge
+// path / co-rank split) and writes a disjoint slice of out
+template <class T>
+void parallel_merge(const std::vector<sorted_span<T>>& spans, T* out,
+                    std::size_t num_threads) {
+  std::size_t total = 0;
+  for (const auto& span : spans) {
+    total += span.size;
+  }
+  if (num_threads == 0) {
+    num_threads = 1;
+  }
+  num_threads = std::min(num_threads, std::max<std::size_t>(total, 1));
+
+  auto work = [&spans, out, total, num_threads](std::size_t t) {
+    std::size_t first = total * t / num_threads;
+    std::size_t last = total * (t + 1) / num_threads;
+    multiway_merge(spans, merge_path_splits(spans, first),
+                   merge_path_splits(spans, last), out + first);
+  };
+
+  std::vector<std::thread> thrds;
+  for (std::size_t t = 1; t < num_threads; t++) {
+    thrds.push_back(std::thread(work, t));
+  }
+  work(0);
+  for (auto& thrd : thrds) {
+    thrd.join();
+  }
+}
+
+}  // namespace pmerge
+
+#endif  // UNAPPROVED_PARALLEL_MERGE_H_
@@ -0,0 +1,181 @@
+#ifndef UNAPPROVED_PARALLEL_SCAN_H_
+#define UNAPPROVED_PARALLEL_SCAN_H_
+
+// Prefix sums (scans) over int32_t, int64_t, double or any other
+// arithmetic type, shared by the modules that turn counts into offsets
+// (radix sort digit tables, CRS/CCS row and column pointers).
+//
+// Every scan is two-pass and blocked: the input is cut into one chunk
+// per thread, the chunk sums are computed in parallel, scanned serially
+// (there are only as many as threads) and every chunk is then scanned in
+// parallel starting from its carry. The chunk sums are accumulated in 8
+// independent lanes, which the compiler vectorizes. in and out may be the
+// same array. Every function returns init plus the sum of all n keys.
+//
+// Back-ends: *_seq always, *_std (std::thread) always, *_omp when the
+// translation unit is built with OpenMP, *_tbb when PARALLEL_SCAN_TBB is
+// defined before this header is included (the module links TBB then).
+// Floating point sums are reassociated, so double results may differ
+// from a serial loop in the last bits.
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>  // NOLINT [build/c++11]
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef PARALLEL_SCAN_TBB
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+#endif
+
+namespace pscan {
+
+// inputs shorter than this are scanned by the calling thread alone
+const std::size_t kSequential = 1 << 15;
+const std::size_t kLane = 8;
+
+template <class T>
+T sum_block(const T* in, std::size_t n) {
+  T lane[kLane] = {};
+  std::size_t i = 0;
+  for (; i + kLane <= n; i += kLane)
+    for (std::size_t k = 0; k < kLane; k++) lane[k] += in[i + k];
+  T sum = T();
+  for (std::size_t k = 0; k < kLane; k++) sum += lane[k];
+  for (; i < n; i++) sum += in[i];
+  return sum;
+}
+
+// scans in[0, n) into out starting from carry, returns the new carry.
+// One add per key: this pass streams in and out and is bound by memory,
+// a log-step scan in vector lanes does three times the adds for nothing
+template <class T>
+T scan_block(const T* in, T* out, std::size_t n, T carry, bool inclusive) {
+  if (inclusive) {
+    for (std::size_t i = 0; i < n; i++) {
+      carry += in[i];
+      out[i] = carry;
+    }
+  } else {
+    for (std::size_t i = 0; i < n; i++) {
+      T x = in[i];
+      out[i] = carry;
+      carry += x;
+    }
+  }
+  return carry;
+}
+
+// for_each(chunks, f) must call f(c) once for every c < chunks, in
+// parallel, and return when all calls are done
+template <class T, class ForEach>
+T scan_chunks(const T* in, T* out, std::size_t n, T init, bool inclusive,
+              std::size_t threads, ForEach for_each) {
+  std::size_t chunks = std::min(threads, n / (kSequential / 2));
+  if (chunks < 2) return scan_block(in, out, n, init, inclusive);
+
+  auto begin = [n, chunks](std::size_t c) { return n / chunks * c +
+                                            std::min(c, n % chunks); };
+  std::vector<T> carry(chunks);
+  for_each(chunks, [&](std::size_t c) {
+    carry[c] = sum_block(in + begin(c), begin(c + 1) - begin(c));
+  });
+  T total = init;
+  for (std::size_t c = 0; c < chunks; c++) {
+    T sum = carry[c];
+    carry[c] = total;
+    total += sum;
+  }
+  for_each(chunks, [&](std::size_t c) {
+    scan_block(in + begin(c), out + begin(c), begin(c + 1) - begin(c),
+               carry[c], inclusive);
+  });
+  return total;
+}
+
+struct for_each_std {
+  template <class F>
+  void operator()(std::size_t chunks, const F& f) const {
+    std::vector<std::thread> workers;
+    for (std::size_t c = 1; c < chunks; c++) workers.emplace_back(f, c);
+    f(0);
+    for (auto& w : workers) w.join();
+  }
+};
+
+inline std::size_t std_threads() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+template <class T>
+T inclusive_scan_seq(const T* in, T* out, std::size_t n, T init = T()) {
+  return scan_block(in, out, n, init, true);
+}
+
+template <class T>
+T exclusive_scan_seq(const T* in, T* out, std::size_t n, T init = T()) {
+  return scan_block(in, out, n, init, false);
+}
+
+template <class T>
+T inclusive_scan_std(const T* in, T* out, std::size_t n, T init = T()) {
+  return scan_chunks(in, out, n, init, true, std_threads(), for_each_std());
+}
+
+template <class T>
+T exclusive_scan_std(const T* in, T* out, std::size_t n, T init = T()) {
+  return scan_chunks(in, out, n, init, false, std_threads(), for_each_std());
+}
+
+#ifdef _OPENMP
+struct for_each_omp {
+  template <class F>
+  void operator()(std::size_t chunks, const F& f) const {
+    int count = static_cast<int>(chunks);
+#pragma omp parallel for num_threads(count) schedule(static, 1)
+    for (int c = 0; c < count; c++) f(static_cast<std::size_t>(c));
+  }
+};
+
+template <class T>
+T inclusive_scan_omp(const T* in, T* out, std::size_t n, T init = T()) {
+  return scan_chunks(in, out, n, init, true, omp_get_max_threads(),
+                     for_each_omp());
+}
+
+template <class T>
+T exclusive_scan_omp(const T* in, T* out, std::size_t n, T init = T()) {
+  return scan_chunks(in, out, n, init, false, omp_get_max_threads(),
+                     for_each_omp());
+}
+#endif  // _OPENMP
+
+#ifdef PARALLEL_SCAN_TBB
+struct for_each_tbb {
+  template <class F>
+  void operator()(std::size_t chunks, const F& f) const {
+    tbb::parallel_for(std::size_t(0), chunks, f);
+  }
+};
+
+inline std::size_t tbb_threads() {
+  return std::max(1, tbb::this_task_arena::max_concurrency());
+}
+
+template <class T>
+T inclusive_scan_tbb(const T* in, T* out, std::size_t n, T init = T()) {
+  return scan_chunks(in, out, n, init, true, tbb_threads(), for_each_tbb());
+}
+
+template <class T>
+T exclusive_scan_tbb(const T* in, T* out, std::size_t n, T init = T()) {
+  return scan_chunks(in, out, n, init, false, tbb_threads(), for_each_tbb());
+}
+#endif  // PARALLEL_SCAN_TBB
+
+}  // namespace pscan
+
+#endif  // UNAPPROVED_PARALLEL_SCAN_H_
@@ -0,0 +1,141 @@
+#ifndef UNAPPROVED_PARALLEL_TRANSPOSE_H_
+#define UNAPPROVED_PARALLEL_TRANSPOSE_H_
+
+// Transpose of a sparse matrix in compressed rows (CRS) or, which is the
+// same, compressed columns (CCS). ptr[rows + 1] (ptr[0] == 0), idx[nnz]
+// and val[nnz] describe rows x cols; tptr[cols + 1], tidx[nnz] and
+// tval[nnz] receive the cols x rows transpose, with the entries of every
+// output row in increasing order.
+//
+// The rows are cut into one range per thread with equal nonzero counts.
+// Every thread counts the columns of its range into its own histogram,
+// the histograms are merged by a 2D prefix sum (over the threads for
+// every column, then over the columns) into one write cursor per thread
+// and column, and every thread scatters its range through its cursors.
+// No atomics: two threads never write the same slot.
+//
+// Back-ends as in parallel_scan.h: *_seq, *_std, *_omp with OpenMP,
+// *_tbb with PARALLEL_SCAN_TBB defined.
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+#include "parallel_scan.h"
+
+namespace ptranspose {
+
+// ranges with fewer nonzeros are not worth a thread
+const std::size_t kMinNonZeros = 1 << 15;
+
+template <class Index, class Value, class ForEach>
+void transpose_chunks(std::size_t rows, std::size_t cols, const Index* ptr,
+                      const Index* idx, const Value* val, Index* tptr,
+                      Index* tidx, Value* tval, std::size_t threads,
+                      ForEach for_each) {
+  if (rows == 0) {
+    std::fill(tptr, tptr + cols + 1, Index());
+    return;
+  }
+  const std::size_t nnz = ptr[rows];
+  // the histograms take chunks * cols counts, keep them within a few
+  // times the matrix
+  std::size_t chunks = std::min(threads, nnz / kMinNonZeros);
+  chunks = std::max<std::size_t>(1, std::min(chunks, 4 * nnz / (cols + 1)));
+
+  std::unique_ptr<std::size_t[]> first(new std::size_t[chunks + 1]);
+  first[0] = 0;
+  first[chunks] = rows;
+  for (std::size_t t = 1; t < chunks; t++)
+    first[t] = std::upper_bound(ptr, ptr + rows + 1,
+                                static_cast<Index>(nnz / chunks * t)) -
+               ptr - 1;
+  auto column_begin = [cols, chunks](std::size_t t) {
+    return cols / chunks * t + std::min(t, cols % chunks);
+  };
+
+  // every thread clears its own histogram, so the pages start near it
+  std::unique_ptr<Index[]> hist(new Index[chunks * cols]);
+  for_each(chunks, [&](std::size_t t) {
+    Index* h = hist.get() + t * cols;
+    std::fill(h, h + cols, Index());
+    for (Index k = ptr[first[t]]; k < ptr[first[t + 1]]; k++) h[idx[k]]++;
+  });
+
+  // cursor of thread t in column c: entries of c in the ranges before t
+  for_each(chunks, [&](std::size_t t) {
+    for (std::size_t c = column_begin(t); c < column_begin(t + 1); c++) {
+      Index total = Index();
+      for (std::size_t s = 0; s < chunks; s++) {
+        Index count = hist[s * cols + c];
+        hist[s * cols + c] = total;
+        total += count;
+      }
+      tptr[c] = total;
+    }
+  });
+  tptr[cols] = Index();
+  pscan::scan_chunks(tptr, tptr, cols + 1, Index(), false, chunks, for_each);
+  for_each(chunks, [&](std::size_t t) {
+    for (std::size_t c = column_begin(t); c < column_begin(t + 1); c++)
+      for (std::size_t s = 0; s < chunks; s++) hist[s * cols + c] += tptr[c];
+  });
+
+  for_each(chunks, [&](std::size_t t) {
+    Index* cursor = hist.get() + t * cols;
+    for (std::size_t r = first[t]; r < first[t + 1]; r++) {
+      for (Index k = ptr[r]; k < ptr[r + 1]; k++) {
+        Index at = cursor[idx[k]]++;
+        tidx[at] = static_cast<Index>(r);
+        tval[at] = val[k];
+      }
+    }
+  });
+}
+
+struct for_each_seq {
+  template <class F>
+  void operator()(std::size_t chunks, const F& f) const {
+    for (std::size_t c = 0; c < chunks; c++) f(c);
+  }
+};
+
+template <class Index, class Value>
+void transpose_seq(std::size_t rows, std::size_t cols, const Index* ptr,
+                   const Index* idx, const Value* val, Index* tptr,
+                   Index* tidx, Value* tval) {
+  transpose_chunks(rows, cols, ptr, idx, val, tptr, tidx, tval, 1,
+                   for_each_seq());
+}
+
+template <class Index, class Value>
+void transpose_std(std::size_t rows, std::size_t cols, const Index* ptr,
+                   const Index* idx, const Value* val, Index* tptr,
+                   Index* tidx, Value* tval) {
+  transpose_chunks(rows, cols, ptr, idx, val, tptr, tidx, tval,
+                   pscan::std_threads(), pscan::for_each_std());
+}
+
+#ifdef _OPENMP
+template <class Index, class Value>
+void transpose_omp(std::size_t rows, std::size_t cols, const Index* ptr,
+                   const Index* idx, const Value* val, Index* tptr,
+                   Index* tidx, Value* tval) {
+  transpose_chunks(rows, cols, ptr, idx, val, tptr, tidx, tval,
+                   omp_get_max_threads(), pscan::for_each_omp());
+}
+#endif  // _OPENMP
+
+#ifdef PARALLEL_SCAN_TBB
+template <class Index, class Value>
+void transpose_tbb(std::size_t rows, std::size_t cols, const Index* ptr,
+                   const Index* idx, const Value* val, Index* tptr,
+                   Index* tidx, Value* tval) {
+  transpose_chunks(rows, cols, ptr, idx, val, tptr, tidx, tval,
+                   pscan::tbb_threads(), pscan::for_each_tbb());
+}
+#endif  // PARALLEL_SCAN_TBB
+
+}  // namespace ptranspose
+
+#endif  // UNAPPROVED_PARALLEL_TRANSPOSE_H_
@@ -0,0 +1,136 @@
+#ifndef UNAPPROVED_ROW_ACCUMULATOR_H_
+#define UNAPPROVED_ROW_ACCUMULATOR_H_
+
+// Accumulation of one row of a Gustavson sparse product C = A B with
+// complex values kept as separate re/im arrays of T (double, int, ...),
+// shared by the CRS multiplications.
+//
+// Every row picks its accumulator by its product count (the sum of the
+// lengths of the rows of B its entries select), an upper bound on its
+// nonzeros. A row with at least cols / kDenseFraction products uses a
+// dense sparse accumulator (SPA): re/im arrays over all columns plus the
+// list of touched columns. A lighter row uses an open addressing hash
+// table with at least twice as many slots as products, so that a short
+// row does not pay for the columns it never touches. The dense arrays
+// are allocated only by an accumulator that meets a heavy row.
+//
+// Per row: begin(products), add() for every entry a(i, k) with the
+// products of a(i, k) and the row k of B, finish(emit), which calls
+// emit(column, re, im) for the nonzero sums in column order.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rowacc {
+
+// a row whose product count reaches cols / kDenseFraction goes to the
+// dense accumulator, lighter rows to the hash table
+const std::size_t kDenseFraction = 16;
+
+template <class Index, class T>
+class RowAccumulator {
+  static const Index kEmptySlot = static_cast<Index>(-1);
+
+  std::size_t cols;
+  bool dense;
+  std::vector<T> spaRe, spaIm;
+  std::vector<char> spaUsed;
+  std::vector<Index> touched;
+  std::vector<Index> keys, sorted;
+  std::vector<T> hashRe, hashIm;
+  std::size_t mask;
+
+  std::size_t slotOf(Index column) {
+    std::size_t slot = static_cast<std::size_t>(
+        static_cast<uint64_t>(column) * 0x9E3779B97F4A7C15ull >> 32) & mask;
+    while (keys[slot] != kEmptySlot && keys[slot] != column)
+      slot = (slot + 1) & mask;
+    if (keys[slot] == kEmptySlot) {
+      keys[slot] = column;
+      hashRe[slot] = 0;
+      hashIm[slot] = 0;
+      touched.push_back(static_cast<Index>(slot));
+    }
+    return slot;
+  }
+
+ public:
+  explicit RowAccumulator(std::size_t _cols)
+      : cols(_cols), dense(false), mask(0) {}
+
+  void begin(std::size_t products) {
+    dense = products * kDenseFraction >= cols;
+    if (dense) {
+      if (spaUsed.empty()) {
+        spaRe.assign(cols, 0);
+        spaIm.assign(cols, 0);
+        spaUsed.assign(cols, 0);
+      }
+      return;
+    }
+    std::size_t capacity = 16;
+    while (capacity < 2 * products) capacity *= 2;
+    if (keys.size() < capacity) {
+      keys.assign(capacity, kEmptySlot);
+      hashRe.resize(capacity);
+      hashIm.resize(capacity);
+    }
+    mask = capacity - 1;
+  }
+
+  // adds re[j] + i im[j] at columns[j] for j < n
+  void add(const Index* columns, const T* re, const T* im, std::size_t n) {
+    if (dense) {
+      for (std::size_t j = 0; j < n; ++j) {
+        Index c = columns[j];
+        if (!spaUsed[c]) {
+          spaUsed[c] = 1;
+          touched.push_back(c);
+        }
+        spaRe[c] += re[j];
+        spaIm[c] += im[j];
+      }
+    } else {
+      for (std::size_t j = 0; j < n; ++j) {
+        std::size_t slot = slotOf(columns[j]);
+        hashRe[slot] += re[j];
+        hashIm[slot] += im[j];
+      }
+    }
+  }
+
+  // emits the nonzero sums in column order and resets the row
+  template <class Emit>
+  void finish(const Emit& emit) {
+    if (dense) {
+      std::sort(touched.begin(), touched.end());
+      for (Index c : touched) {
+        if (spaRe[c] != 0 || spaIm[c] != 0) emit(c, spaRe[c], spaIm[c]);
+        spaRe[c] = 0;
+        spaIm[c] = 0;
+        spaUsed[c] = 0;
+      }
+    } else {
+      // plain column numbers sort faster than slots compared by key
+      sorted.clear();
+      for (Index slot : touched) sorted.push_back(keys[slot]);
+      std::sort(sorted.begin(), sorted.end());
+      for (Index c : sorted) {
+        std::size_t slot = slotOf(c);
+        if (hashRe[slot] != 0 || hashIm[slot] != 0)
+          emit(c, hashRe[slot], hashIm[slot]);
+      }
+      for (Index slot : touched) keys[slot] = kEmptySlot;
+    }
+    touched.clear();
+  }
+};
+
+template <class Index, class T>
+const Index RowAccumulator<Index, T>::kEmptySlot;
+
+}  // namespace rowacc
+
+#endif  // UNAPPROVED_ROW_ACCUMULATOR_H_
@@ -0,0 +1,434 @@
+#ifndef UNAPPROVED_SPARSE_REORDER_H_
+#define UNAPPROVED_SPARSE_REORDER_H_
+
+// Symmetric reorderings of a square sparse matrix, for better locality
+// of SpMV and SpGEMM. The matrix is taken in 0-based compressed rows,
+// ptr[n + 1] and idx[nnz] (compressed columns work the same, only the
+// pattern of A + A^T is used). Every ordering is a vector order with
+// order[new] = old.
+//
+// rcm_order: reverse Cuthill-McKee. Every connected component is
+// numbered breadth first from a pseudo-peripheral vertex (George, Liu),
+// the children of a vertex by increasing degree. A level is built in
+// parallel: every frontier vertex claims its unvisited neighbours with
+// an atomic minimum of its position, so a vertex goes to the earliest
+// frontier vertex that reaches it, exactly as in the serial algorithm;
+// the claimed vertices are counted, the counts scanned and every
+// frontier vertex writes its children to its own slots. Levels too
+// narrow to split are built in one serial pass.
+//
+// partition_order: recursive bisection by graph growing. A part is
+// numbered breadth first from a far vertex of its subgraph and cut in
+// two halves of that order; the parts of a round are cut in parallel.
+// The result keeps the vertices of a part together, which bounds the
+// part of x a block of rows touches.
+//
+// Back-ends as in parallel_scan.h: *_seq, *_std, *_omp with OpenMP,
+// *_tbb with PARALLEL_SCAN_TBB defined.
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "parallel_scan.h"
+#include "parallel_transpose.h"
+
+namespace preorder {
+
+// rows or frontier vertices per chunk below which threads do not pay
+const std::size_t kMinVertices = 1 << 12;
+// pseudo-peripheral vertex search: breadth-first sweeps at most
+const int kMaxSweeps = 8;
+
+// pattern of A + A^T without the diagonal, rows sorted
+struct graph {
+  std::vector<std::size_t> ptr;
+  std::vector<int> adj;
+  int size() const { return static_cast<int>(ptr.size()) - 1; }
+  int degree(int v) const { return static_cast<int>(ptr[v + 1] - ptr[v]); }
+};
+
+inline std::size_t chunk_count(std::size_t items, std::size_t threads) {
+  return std::max<std::size_t>(1, std::min(threads, items / kMinVertices));
+}
+
+inline std::size_t chunk_begin(std::size_t items, std::size_t chunks,
+                               std::size_t c) {
+  return items / chunks * c + std::min(c, items % chunks);
+}
+
+template <class ForEach>
+graph symmetric_graph(int n, const int* ptr, const int* idx,
+                      std::size_t threads, ForEach for_each) {
+  const std::size_t nnz = ptr[n];
+  std::vector<int> tptr(n + 1), tidx(nnz);
+  std::vector<char> none(nnz), tnone(nnz);
+  ptranspose::transpose_chunks(n, n, ptr, idx, none.data(), tptr.data(),
+                               tidx.data(), tnone.data(), threads, for_each);
+
+  // row i of A and of A^T are merged at ptr[i] + tptr[i], then packed
+  std::vector<int> merged(2 * nnz);
+  std::vector<std::size_t> length(n);
+  const std::size_t chunks = chunk_count(n, threads);
+  for_each(chunks, [&](std::size_t c) {
+    for (std::size_t i = chunk_begin(n, chunks, c);
+         i < chunk_begin(n, chunks, c + 1); i++) {
+      int* row = merged.data() + ptr[i] + tptr[i];
+      int* end = std::copy(idx + ptr[i], idx + ptr[i + 1], row);
+      end = std::copy(tidx.data() + tptr[i], tidx.data() + tptr[i + 1], end);
+      std::sort(row, end);
+      end = std::unique(row, end);
+      end = std::remove(row, end, static_cast<int>(i));
+      length[i] = end - row;
+    }
+  });
+
+  graph g;
+  g.ptr.resize(n + 1);
+  g.ptr[n] = pscan::scan_chunks(length.data(), g.ptr.data(), n,
+                                std::size_t(0), false, chunks, for_each);
+  g.adj.resize(g.ptr[n]);
+  for_each(chunks, [&](std::size_t c) {
+    for (std::size_t i = chunk_begin(n, chunks, c);
+         i < chunk_begin(n, chunks, c + 1); i++) {
+      const int* row = merged.data() + ptr[i] + tptr[i];
+      std::copy(row, row + length[i], g.adj.begin() + g.ptr[i]);
+    }
+  });
+  return g;
+}
+
+namespace detail {
+
+inline void fetch_min(std::atomic<int>* a, int value) {
+  int current = a->load(std::memory_order_relaxed);
+  while (current > value &&
+         !a->compare_exchange_weak(current, value,
+                                   std::memory_order_relaxed)) {
+  }
+}
+
+// order[begin, end) is a breadth-first numbering with levels,
+// order[last, end) its last level
+struct levels {
+  std::size_t end;
+  std::size_t last;
+  int depth;
+};
+
+// Numbers the component of root breadth first into order[start, ...),
+// Cuthill-McKee style. parent[v] is INT_MAX for an unnumbered vertex and
+// holds the position of the vertex that numbered v otherwise.
+template <class ForEach>
+levels cuthill_mckee(const graph& g, int root, int* order, std::size_t start,
+                     std::atomic<int>* parent, std::size_t threads,
+                     ForEach for_each) {
+  parent[root].store(-1, std::memory_order_relaxed);
+  order[start] = root;
+  levels l = {start + 1, start, 1};
+  std::vector<std::size_t> count;
+  for (;;) {
+    const std::size_t lo = l.last, width = l.end - l.last;
+    const std::size_t chunks = chunk_count(width, threads);
+    auto by_degree = [&g](int a, int b) {
+      return g.degree(a) < g.degree(b) ||
+             (g.degree(a) == g.degree(b) && a < b);
+    };
+    if (chunks == 1) {
+      // one pass in order: the first vertex to see a neighbour takes it
+      std::size_t end = l.end;
+      for (std::size_t p = lo; p < l.end; p++) {
+        const int v = order[p];
+        const std::size_t first = end;
+        for (std::size_t k = g.ptr[v]; k < g.ptr[v + 1]; k++) {
+          const int u = g.adj[k];
+          if (parent[u].load(std::memory_order_relaxed) == INT_MAX) {
+            parent[u].store(static_cast<int>(p), std::memory_order_relaxed);
+            order[end++] = u;
+          }
+        }
+        std::sort(order + first, order + end, by_degree);
+      }
+      if (end == l.end) return l;
+      l.last = l.end;
+      l.end = end;
+      l.depth++;
+      continue;
+    }
+    // vertices numbered earlier have smaller parents than any position
+    // of this level, the minimum leaves them alone
+    for_each(chunks, [&](std::size_t c) {
+      for (std::size_t p = lo + chunk_begin(width, chunks, c);
+           p < lo + chunk_begin(width, chunks, c + 1); p++) {
+        const int v = order[p];
+        for (std::size_t k = g.ptr[v]; k < g.ptr[v + 1]; k++)
+          fetch_min(&parent[g.adj[k]], static_cast<int>(p));
+      }
+    });
+    count.resize(width);
+    for_each(chunks, [&](std::size_t c) {
+      for (std::size_t p = chunk_begin(width, chunks, c);
+           p < chunk_begin(width, chunks, c + 1); p++) {
+        const int v = order[lo + p];
+        std::size_t n = 0;
+        for (std::size_t k = g.ptr[v]; k < g.ptr[v + 1]; k++)
+          n += parent[g.adj[k]].load(std::memory_order_relaxed) ==
+               static_cast<int>(lo + p);
+        count[p] = n;
+      }
+    });
+    const std::size_t total = pscan::scan_chunks(
+        count.data(), count.data(), width, std::size_t(0), false, chunks,
+        for_each);
+    if (total == 0) return l;
+    for_each(chunks, [&](std::size_t c) {
+      for (std::size_t p = chunk_begin(width, chunks, c);
+           p < chunk_begin(width, chunks, c + 1); p++) {
+        const int v = order[lo + p];
+        int* child = order + l.end + count[p];
+        int n = 0;
+        for (std::size_t k = g.ptr[v]; k < g.ptr[v + 1]; k++)
+          if (parent[g.adj[k]].load(std::memory_order_relaxed) ==
+              static_cast<int>(lo + p))
+            child[n++] = g.adj[k];
+        std::sort(child, child + n, by_degree);
+      }
+    });
+    l.last = l.end;
+    l.end += total;
+    l.depth++;
+  }
+}
+
+// a vertex of the component of start far from the others: the root of
+// the deepest level structure found by restarting from the thinnest
+// vertex of the last level while the depth grows
+template <class ForEach>
+int peripheral(const graph& g, int start, int* scratch,
+               std::atomic<int>* trial, std::size_t threads,
+               ForEach for_each) {
+  auto sweep = [&](int root) {
+    levels l = cuthill_mckee(g, root, scratch, 0, trial, threads, for_each);
+    for (std::size_t p = 0; p < l.end; p++)
+      trial[scratch[p]].store(INT_MAX, std::memory_order_relaxed);
+    return l;
+  };
+  int root = start;
+  levels l = sweep(root);
+  for (int s = 1; s < kMaxSweeps; s++) {
+    int x = scratch[l.last];
+    for (std::size_t p = l.last; p < l.end; p++)
+      if (g.degree(scratch[p]) < g.degree(x)) x = scratch[p];
+    levels lx = sweep(x);
+    if (lx.depth <= l.depth) break;
+    root = x;
+    l = lx;
+  }
+  return root;
+}
+
+// Cuts order[begin, end) in two: the subgraph of the vertices with
+// owner == id is numbered breadth first, every connected piece from the
+// end of a first sweep, and the first `split` vertices go to left, the
+// others to right. The sweeps mark with negative values of their own,
+// owner of the other parts is only read.
+inline void bisect(const graph& g, int* order, std::size_t begin,
+                   std::size_t end, std::size_t split, int id, int left,
+                   int right, std::atomic<int>* owner) {
+  const int kFirst = -2 * id - 1, kSecond = -2 * id - 2;
+  std::vector<int> queue(end - begin);
+  auto sweep = [&](int root, int from, int to, std::size_t head) {
+    std::size_t tail = head;
+    queue[tail++] = root;
+    owner[root].store(to, std::memory_order_relaxed);
+    for (; head < tail; head++) {
+      const int v = queue[head];
+      for (std::size_t k = g.ptr[v]; k < g.ptr[v + 1]; k++) {
+        const int u = g.adj[k];
+        if (owner[u].load(std::memory_order_relaxed) == from) {
+          owner[u].store(to, std::memory_order_relaxed);
+          queue[tail++] = u;
+        }
+      }
+    }
+    return tail;
+  };
+  std::size_t done = 0;
+  for (std::size_t p = begin; p < end; p++) {
+    if (owner[order[p]].load(std::memory_order_relaxed) != id) continue;
+    std::size_t tail = sweep(order[p], id, kFirst, done);
+    sweep(queue[tail - 1], kFirst, kSecond, done);
+    done = tail;
+  }
+  std::copy(queue.begin(), queue.end(), order + begin);
+  for (std::size_t p = begin; p < end; p++)
+    owner[order[p]].store(p < begin + split ? left : right,
+                          std::memory_order_relaxed);
+}
+
+}  // namespace detail
+
+template <class ForEach>
+std::vector<int> rcm_order(const graph& g, std::size_t threads,
+                           ForEach for_each) {
+  const int n = g.size();
+  std::unique_ptr<std::atomic<int>[]> parent(new std::atomic<int>[n]);
+  std::unique_ptr<std::atomic<int>[]> trial(new std::atomic<int>[n]);
+  for (int v = 0; v < n; v++) {
+    parent[v].store(INT_MAX, std::memory_order_relaxed);
+    trial[v].store(INT_MAX, std::memory_order_relaxed);
+  }
+  // components are started from their thinnest vertex: the vertices by
+  // increasing degree, by a counting sort
+  std::vector<int> first(n + 1, 0), by_degree(n);
+  for (int v = 0; v < n; v++) first[g.degree(v)]++;
+  pscan::scan_block(first.data(), first.data(), n + 1, 0, false);
+  for (int v = 0; v < n; v++) by_degree[first[g.degree(v)]++] = v;
+
+  std::vector<int> order(n), scratch(n);
+  std::size_t done = 0;
+  for (int s : by_degree) {
+    if (parent[s].load(std::memory_order_relaxed) != INT_MAX) continue;
+    int root = detail::peripheral(g, s, scratch.data(), trial.get(), threads,
+                                  for_each);
+    done = detail::cuthill_mckee(g, root, order.data(), done, parent.get(),
+                                 threads, for_each)
+               .end;
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+template <class ForEach>
+std::vector<int> partition_order(const graph& g, int parts,
+                                 std::size_t threads, ForEach for_each) {
+  struct part {
+    std::size_t begin, end;
+    int parts;
+  };
+  const int n = g.size();
+  std::vector<int> order(n);
+  std::unique_ptr<std::atomic<int>[]> owner(new std::atomic<int>[n]);
+  for (int v = 0; v < n; v++) {
+    order[v] = v;
+    owner[v].store(0, std::memory_order_relaxed);
+  }
+  std::vector<part> all(1, part{0, static_cast<std::size_t>(n),
+                                std::max(1, parts)});
+  std::vector<int> active;
+  if (all[0].parts > 1) active.push_back(0);
+  while (!active.empty()) {
+    // children 2k and 2k + 1 of active[k] are added behind
+    const int first = static_cast<int>(all.size());
+    all.resize(all.size() + 2 * active.size());
+    const std::size_t chunks = std::min(threads, active.size());
+    for_each(chunks, [&](std::size_t c) {
+      for (std::size_t k = c; k < active.size(); k += chunks) {
+        const part p = all[active[k]];
+        const int half = p.parts / 2;
+        const std::size_t split = (p.end - p.begin) * half / p.parts;
+        const int left = first + 2 * static_cast<int>(k), right = left + 1;
+        detail::bisect(g, order.data(), p.begin, p.end, split, active[k],
+                       left, right, owner.get());
+        all[left] = part{p.begin, p.begin + split, half};
+        all[right] = part{p.begin + split, p.end, p.parts - half};
+      }
+    });
+    active.clear();
+    for (int id = first; id < static_cast<int>(all.size()); id++)
+      if (all[id].parts > 1) active.push_back(id);
+  }
+  return order;
+}
+
+// max |i - j| over the entries (i, j)
+inline int bandwidth(int n, const int* ptr, const int* idx) {
+  int band = 0;
+  for (int i = 0; i < n; i++)
+    for (int k = ptr[i]; k < ptr[i + 1]; k++)
+      band = std::max(band, i > idx[k] ? i - idx[k] : idx[k] - i);
+  return band;
+}
+
+// sum over the rows of the distance from the diagonal to the first entry
+// left of it (the lower envelope)
+inline int64_t profile(int n, const int* ptr, const int* idx) {
+  int64_t sum = 0;
+  for (int i = 0; i < n; i++) {
+    int first = i;
+    for (int k = ptr[i]; k < ptr[i + 1]; k++) first = std::min(first, idx[k]);
+    sum += i - first;
+  }
+  return sum;
+}
+
+// inverse[order[i]] = i; false if order is not a permutation of 0..n-1
+inline bool invert(const std::vector<int>& order, int n,
+                   std::vector<int>* inverse) {
+  if (static_cast<int>(order.size()) != n) return false;
+  inverse->assign(n, -1);
+  for (int i = 0; i < n; i++) {
+    if (order[i] < 0 || order[i] >= n || (*inverse)[order[i]] >= 0)
+      return false;
+    (*inverse)[order[i]] = i;
+  }
+  return true;
+}
+
+inline std::vector<int> rcm_order_seq(const graph& g) {
+  return rcm_order(g, 1, ptranspose::for_each_seq());
+}
+
+inline std::vector<int> rcm_order_std(const graph& g) {
+  return rcm_order(g, pscan::std_threads(), pscan::for_each_std());
+}
+
+inline std::vector<int> partition_order_std(const graph& g, int parts) {
+  return partition_order(g, parts, pscan::std_threads(),
+                         pscan::for_each_std());
+}
+
+inline graph symmetric_graph_std(int n, const int* ptr, const int* idx) {
+  return symmetric_graph(n, ptr, idx, pscan::std_threads(),
+                         pscan::for_each_std());
+}
+
+#ifdef _OPENMP
+inline std::vector<int> rcm_order_omp(const graph& g) {
+  return rcm_order(g, omp_get_max_threads(), pscan::for_each_omp());
+}
+
+inline std::vector<int> partition_order_omp(const graph& g, int parts) {
+  return partition_order(g, parts, omp_get_max_threads(),
+                         pscan::for_each_omp());
+}
+
+inline graph symmetric_graph_omp(int n, const int* ptr, const int* idx) {
+  return symmetric_graph(n, ptr, idx, omp_get_max_threads(),
+                         pscan::for_each_omp());
+}
+#endif  // _OPENMP
+
+#ifdef PARALLEL_SCAN_TBB
+inline std::vector<int> rcm_order_tbb(const graph& g) {
+  return rcm_order(g, pscan::tbb_threads(), pscan::for_each_tbb());
+}
+
+inline std::vector<int> partition_order_tbb(const graph& g, int parts) {
+  return partition_order(g, parts, pscan::tbb_threads(),
+                         pscan::for_each_tbb());
+}
+
+inline graph symmetric_graph_tbb(int n, const int* ptr, const int* idx) {
+  return symmetric_graph(n, ptr, idx, pscan::tbb_threads(),
+                         pscan::for_each_tbb());
+}
+#endif  // PARALLEL_SCAN_TBB
+
+}  // namespace preorder
+
+#endif  // UNAPPROVED_SPARSE_REORDER_H_
@@ -1,7 +1,129 @@
 // Copyright 2022 Yashin Kirill
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>  // NOLINT [build/c++11]
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
 #include <vector>
 #include "../../modules/task_1/yashin_k_crs_mult_double/sparse_matrix_multiplication_crs.h"
+#include "../../modules/task_1/yashin_k_crs_mult_double/sell_c_sigma.h"
+
+#define USE_EFFICIENCY_TESTS 0
+
+namespace {
+// rows of the SELL-C-sigma versus CRS tests: by default they only check
+// every kernel against CRS; with USE_EFFICIENCY_TESTS they also time them
+#if USE_EFFICIENCY_TESTS == 1
+const int kBenchRows = 200000;
+#else
+const int kBenchRows = 2000;
+#endif
+
+// CRS matrix with len(i) nonzeros in row i at columns col(i, j)
+template <class Length, class Column>
+sparse_matrix generate(int n, Length len, Column col) {
+    std::vector<double> values;
+    std::vector<int> col_index;
+    std::vector<int> row_index(1, 0);
+    std::mt19937 gen(n);
+    std::uniform_real_distribution<double> value(-1.0, 1.0);
+    for (int i = 0; i < n; i++) {
+        std::vector<int> cols;
+        for (int j = len(i); j > 0; j--)
+            cols.push_back(col(i));
+        std::sort(cols.begin(), cols.end());
+        cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+        for (int c : cols) {
+            values.push_back(value(gen));
+            col_index.push_back(c);
+        }
+        row_index.push_back(values.size());
+    }
+    return sparse_matrix(n, n, values, col_index, row_index);
+}
+
+sparse_matrix banded_matrix(int n, int half_width) {
+    int k = 0;
+    return generate(n, [&](int i) {
+        k = std::max(0, i - half_width);
+        return std::min(n - 1, i + half_width) - k + 1;
+    }, [&](int) { return k++; });
+}
+
+// row lengths follow a Pareto law: most rows are short, a few are long
+sparse_matrix power_law_matrix(int n) {
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::uniform_int_distribution<int> any(0, n - 1);
+    return generate(n, [&](int) {
+        return std::min(2000, static_cast<int>(2 / std::pow(1 - u(gen),
+          1 / 1.5)));
+    }, [&](int) { return any(gen); });
+}
+
+sparse_matrix uniform_random_matrix(int n, int max_row) {
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> len(0, max_row);
+    std::uniform_int_distribution<int> any(0, n - 1);
+    return generate(n, [&](int) { return len(gen); },
+      [&](int) { return any(gen); });
+}
+
+std::vector<double> random_vector(int n) {
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> value(-1.0, 1.0);
+    std::vector<double> x(n);
+    for (double& v : x)
+        v = value(gen);
+    return x;
+}
+
+#if USE_EFFICIENCY_TESTS == 1
+template <class F>
+double best_time(F f) {
+    double best = 1e30;
+    for (int repeat = 0; repeat < 10; repeat++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double> time =
+            std::chrono::steady_clock::now() - start;
+        best = std::min(best, time.count());
+    }
+    return best;
+}
+#endif  // USE_EFFICIENCY_TESTS
+
+// checks SELL-C-sigma against CRS with every kernel this CPU has and, with
+// USE_EFFICIENCY_TESTS, prints the times
+void compare_with_crs(const std::string& name, const sparse_matrix& A,
+  int n) {
+    std::vector<double> x = random_vector(n);
+    std::vector<double> expected = crs_spmv(A, x);
+    sell_c_sigma S(A, 8, 256);
+#if USE_EFFICIENCY_TESTS == 1
+    std::cout << name << ": fill " << S.fill_ratio() << ", CRS "
+              << best_time([&] { crs_spmv(A, x); }) << " s";
+#endif  // USE_EFFICIENCY_TESTS
+    for (spmv_kernel kernel : {spmv_kernel::scalar, spmv_kernel::avx2,
+                               spmv_kernel::avx512}) {
+        if (!spmv_kernel_supported(kernel))
+            continue;
+        std::vector<double> y = S.multiply(x, kernel);
+        for (int i = 0; i < n; i++)
+            ASSERT_NEAR(expected[i], y[i], 1e-10);
+#if USE_EFFICIENCY_TESTS == 1
+        static const char* names[] = {"", "scalar", "AVX2", "AVX-512"};
+        std::cout << ", " << names[static_cast<int>(kernel)] << " "
+                  << best_time([&] { S.multiply(x, kernel); }) << " s";
+#endif  // USE_EFFICIENCY_TESTS
+    }
+#if USE_EFFICIENCY_TESTS == 1
+    std::cout << std::endl;
+#endif  // USE_EFFICIENCY_TESTS
+}
+}  // namespace
 
 TEST(Yashin_Kirill_Sparse_Matrix, Can_Create_Matrix) {
     Matrix matrix{{0.0, 1.1, 0.0, 0.0, 2.2},
@@ -98,3 +220,64 @@ TEST(Yashin_Kirill_Sparse_Matrix, Can_Multiply_Random) {
 
     ASSERT_EQ(_result, result_sparse);
 }
+
+TEST(Yashin_Kirill_Sparse_Matrix, Sell_Converts_To_And_From_Crs) {
+    for (int C : {1, 4, 8}) {
+        for (int sigma : {1, 8, 64}) {
+            sparse_matrix A(random_matrix(50, 37));
+            sell_c_sigma S(A, C, sigma);
+            ASSERT_EQ(A, S.to_crs());
+        }
+    }
+}
+
+TEST(Yashin_Kirill_Sparse_Matrix, Sell_Sorts_And_Pads_Chunks) {
+    std::vector<double> values = {1.1, 2.2, 3.3, 4.4, 5.5, 6.6, 7.7};
+    std::vector<int> col_index = {1, 4, 2, 3, 1, 3, 0};
+    std::vector<int> row_index = {0, 1, 1, 5, 6, 7};
+    sparse_matrix A(5, 5, values, col_index, row_index);
+    sell_c_sigma S(A, 2, 4);
+
+    ASSERT_EQ(std::vector<int>({2, 0, 3, 1, 4}), S.perm);
+    ASSERT_EQ(std::vector<int>({4, 1, 1}), S.chunk_len);
+    ASSERT_EQ(std::vector<int>({0, 8, 10, 12}), S.chunk_ptr);
+    ASSERT_DOUBLE_EQ(12.0 / 7.0, S.fill_ratio());
+    ASSERT_EQ(std::vector<double>({2.2, 1.1, 3.3, 0.0, 4.4, 0.0, 5.5, 0.0,
+                                   6.6, 0.0, 7.7, 0.0}), S.values);
+    ASSERT_EQ(std::vector<int>({4, 1, 2, 1, 3, 1, 1, 1, 3, 0, 0, 0}),
+              S.col_index);
+}
+
+TEST(Yashin_Kirill_Sparse_Matrix, Sell_Multiply_Matches_Crs) {
+    sparse_matrix A(random_matrix(101, 67));
+    std::vector<double> x = random_vector(67);
+    std::vector<double> expected = crs_spmv(A, x);
+    for (int C : {3, 4, 8, 16, 24}) {
+        sell_c_sigma S(A, C, 32);
+        std::vector<double> y = S.multiply(x);
+        for (int i = 0; i < 101; i++)
+            ASSERT_NEAR(expected[i], y[i], 1e-10);
+    }
+}
+
+TEST(Yashin_Kirill_Sparse_Matrix, Sell_Throws_On_Wrong_Arguments) {
+    sparse_matrix A(random_matrix(10, 10));
+    ASSERT_ANY_THROW(sell_c_sigma(A, 0, 4));
+    ASSERT_ANY_THROW(sell_c_sigma(A, 4, 0));
+    sell_c_sigma S(A, 3, 4);
+    ASSERT_ANY_THROW(S.multiply(std::vector<double>(9)));
+    ASSERT_ANY_THROW(S.multiply(std::vector<double>(10), spmv_kernel::avx2));
+}
+
+TEST(Yashin_Kirill_Sparse_Matrix, Sell_Versus_Crs_Banded) {
+    compare_with_crs("banded", banded_matrix(kBenchRows, 3), kBenchRows);
+}
+
+TEST(Yashin_Kirill_Sparse_Matrix, Sell_Versus_Crs_Power_Law) {
+    compare_with_crs("power law", power_law_matrix(kBenchRows), kBenchRows);
+}
+
+TEST(Yashin_Kirill_Sparse_Matrix, Sell_Versus_Crs_Random) {
+    compare_with_crs("random", uniform_random_matrix(kBenchRows, 16),
+      kBenchRows);
+}
@@ -0,0 +1,229 @@
+// Copyright 2022 Yashin Kirill
+#include "../../modules/task_1/yashin_k_crs_mult_double/sell_c_sigma.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SELL_C_SIGMA_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+// Every kernel computes the C sums of one chunk into out. Entry j of the
+// stored row r of the chunk sits at j * C + r.
+
+void chunk_scalar(const double* val, const int* col, int len, int C,
+  const double* x, double* out) {
+    std::fill(out, out + C, 0.0);
+    for (int j = 0; j < len; j++, val += C, col += C)
+        for (int r = 0; r < C; r++)
+            out[r] += val[r] * x[col[r]];
+}
+
+#ifdef SELL_C_SIGMA_X86
+// sums of the G groups of 4 (AVX2) or 8 (AVX-512) rows starting at val
+// and col; the sums stay in registers
+template <int G>
+__attribute__((target("avx2,fma")))
+void groups_avx2(const double* val, const int* col, int len, int C,
+  const double* x, double* out) {
+    // the masked gathers start from a zeroed register, the plain ones
+    // trip -Wmaybe-uninitialized in GCC headers
+    const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    __m256d acc[G];
+    for (int g = 0; g < G; g++)
+        acc[g] = _mm256_setzero_pd();
+    for (int j = 0; j < len; j++, val += C, col += C) {
+        for (int g = 0; g < G; g++) {
+            __m128i idx = _mm_loadu_si128(
+              reinterpret_cast<const __m128i*>(col + 4 * g));
+            __m256d xs = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x,
+              idx, all, 8);
+            acc[g] = _mm256_fmadd_pd(_mm256_loadu_pd(val + 4 * g), xs,
+              acc[g]);
+        }
+    }
+    for (int g = 0; g < G; g++)
+        _mm256_storeu_pd(out + 4 * g, acc[g]);
+}
+
+template <int G>
+__attribute__((target("avx512f")))
+void groups_avx512(const double* val, const int* col, int len, int C,
+  const double* x, double* out) {
+    __m512d acc[G];
+    for (int g = 0; g < G; g++)
+        acc[g] = _mm512_setzero_pd();
+    for (int j = 0; j < len; j++, val += C, col += C) {
+        for (int g = 0; g < G; g++) {
+            __m256i idx = _mm256_loadu_si256(
+              reinterpret_cast<const __m256i*>(col + 8 * g));
+            __m512d xs = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF,
+              idx, x, 8);
+            acc[g] = _mm512_fmadd_pd(_mm512_loadu_pd(val + 8 * g), xs,
+              acc[g]);
+        }
+    }
+    for (int g = 0; g < G; g++)
+        _mm512_storeu_pd(out + 8 * g, acc[g]);
+}
+
+// any C divisible by the vector width: one group after the other
+void chunk_avx2(const double* val, const int* col, int len, int C,
+  const double* x, double* out) {
+    for (int g = 0; g < C; g += 4)
+        groups_avx2<1>(val + g, col + g, len, C, x, out + g);
+}
+
+void chunk_avx512(const double* val, const int* col, int len, int C,
+  const double* x, double* out) {
+    for (int g = 0; g < C; g += 8)
+        groups_avx512<1>(val + g, col + g, len, C, x, out + g);
+}
+#endif  // SELL_C_SIGMA_X86
+
+typedef void (*chunk_kernel)(const double*, const int*, int, int,
+  const double*, double*);
+
+chunk_kernel pick_kernel(spmv_kernel kernel, int C) {
+    if (kernel == spmv_kernel::automatic) {
+        if (C % 8 == 0 && spmv_kernel_supported(spmv_kernel::avx512))
+            kernel = spmv_kernel::avx512;
+        else if (C % 4 == 0 && spmv_kernel_supported(spmv_kernel::avx2))
+            kernel = spmv_kernel::avx2;
+        else
+            kernel = spmv_kernel::scalar;
+    }
+    if (!spmv_kernel_supported(kernel))
+        throw std::runtime_error("SpMV kernel is not supported by this CPU");
+#ifdef SELL_C_SIGMA_X86
+    if (kernel == spmv_kernel::avx2) {
+        if (C % 4 != 0)
+            throw std::runtime_error("AVX2 kernel needs C divisible by 4");
+        return C == 4 ? groups_avx2<1> : C == 8 ? groups_avx2<2> : chunk_avx2;
+    }
+    if (kernel == spmv_kernel::avx512) {
+        if (C % 8 != 0)
+            throw std::runtime_error("AVX-512 kernel needs C divisible by 8");
+        return C == 8 ? groups_avx512<1> : C == 16 ? groups_avx512<2>
+                                                    : chunk_avx512;
+    }
+#endif
+    return chunk_scalar;
+}
+}  // namespace
+
+bool spmv_kernel_supported(spmv_kernel kernel) {
+    switch (kernel) {
+    case spmv_kernel::automatic:
+    case spmv_kernel::scalar:
+        return true;
+#ifdef SELL_C_SIGMA_X86
+    case spmv_kernel::avx2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case spmv_kernel::avx512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+sell_c_sigma::sell_c_sigma(const sparse_matrix& A, int C, int _sigma)
+  : rows(A.rows), columns(A.columns), chunk_rows(C), sigma(_sigma) {
+    if (C < 1 || _sigma < 1)
+        throw std::runtime_error("C and sigma must be positive");
+
+    // <Sorting>
+    perm.resize(rows);
+    std::iota(perm.begin(), perm.end(), 0);
+    auto length = [&A](int i) {
+        return A.row_index[i + 1] - A.row_index[i];
+    };
+    for (int w = 0; w < rows; w += sigma) {
+        std::stable_sort(perm.begin() + w,
+          perm.begin() + std::min(rows, w + sigma),
+          [&length](int a, int b) { return length(a) > length(b); });
+    }
+    // </Sorting>
+
+    const int chunks = (rows + C - 1) / C;
+    row_len.assign(static_cast<size_t>(chunks) * C, 0);
+    for (int s = 0; s < rows; s++)
+        row_len[s] = length(perm[s]);
+    chunk_len.resize(chunks);
+    chunk_ptr.resize(chunks + 1);
+    chunk_ptr[0] = 0;
+    for (int c = 0; c < chunks; c++) {
+        chunk_len[c] = *std::max_element(row_len.begin() + c * C,
+          row_len.begin() + (c + 1) * C);
+        chunk_ptr[c + 1] = chunk_ptr[c] + chunk_len[c] * C;
+    }
+
+    // <Packing>
+    values.assign(chunk_ptr[chunks], 0.0);
+    col_index.assign(chunk_ptr[chunks], 0);
+    for (int s = 0; s < rows; s++) {
+        const int c = s / C, r = s % C;
+        const int first = A.row_index[perm[s]];
+        int last_col = 0;
+        for (int j = 0; j < chunk_len[c]; j++) {
+            const int at = chunk_ptr[c] + j * C + r;
+            if (j < row_len[s]) {
+                values[at] = A.values[first + j];
+                last_col = A.col_index[first + j];
+            }
+            col_index[at] = last_col;
+        }
+    }
+    // </Packing>
+}
+
+sparse_matrix sell_c_sigma::to_crs() const {
+    std::vector<int> slot(rows);
+    for (int s = 0; s < rows; s++)
+        slot[perm[s]] = s;
+
+    std::vector<int> crs_row(rows + 1, 0);
+    for (int i = 0; i < rows; i++)
+        crs_row[i + 1] = crs_row[i] + row_len[slot[i]];
+    std::vector<double> crs_values(crs_row[rows]);
+    std::vector<int> crs_col(crs_row[rows]);
+    for (int i = 0; i < rows; i++) {
+        const int s = slot[i];
+        const int c = s / chunk_rows, r = s % chunk_rows;
+        for (int j = 0; j < row_len[s]; j++) {
+            const int at = chunk_ptr[c] + j * chunk_rows + r;
+            crs_values[crs_row[i] + j] = values[at];
+            crs_col[crs_row[i] + j] = col_index[at];
+        }
+    }
+    return sparse_matrix(rows, columns, crs_values, crs_col, crs_row);
+}
+
+double sell_c_sigma::fill_ratio() const {
+    const double nonzeros = std::accumulate(row_len.begin(), row_len.end(),
+      0.0);
+    return nonzeros > 0 ? values.size() / nonzeros : 1.0;
+}
+
+std::vector<double> sell_c_sigma::multiply(const std::vector<double>& x,
+  spmv_kernel kernel) const {
+    if (static_cast<int>(x.size()) != columns)
+        throw std::runtime_error("vector size does not match the matrix");
+    const chunk_kernel chunk = pick_kernel(kernel, chunk_rows);
+    std::vector<double> y(rows);
+    std::vector<double> out(chunk_rows);
+    const int chunks = static_cast<int>(chunk_len.size());
+    for (int c = 0; c < chunks; c++) {
+        chunk(values.data() + chunk_ptr[c], col_index.data() + chunk_ptr[c],
+          chunk_len[c], chunk_rows, x.data(), out.data());
+        const int stored = std::min(chunk_rows, rows - c * chunk_rows);
+        for (int r = 0; r < stored; r++)
+            y[perm[c * chunk_rows + r]] = out[r];
+    }
+    return y;
+}
@@ -0,0 +1,44 @@
+// Copyright 2022 Yashin Kirill
+#ifndef MODULES_TASK_1_YASHIN_K_CRS_MULT_DOUBLE_SELL_C_SIGMA_H_
+#define MODULES_TASK_1_YASHIN_K_CRS_MULT_DOUBLE_SELL_C_SIGMA_H_
+
+#include <vector>
+#include "../../modules/task_1/yashin_k_crs_mult_double/sparse_matrix_multiplication_crs.h"
+
+enum class spmv_kernel { automatic, scalar, avx2, avx512 };
+
+// SELL-C-sigma (Kreutzer et al.): the rows are sorted by length inside
+// windows of sigma rows and cut into chunks of C rows. A chunk is stored
+// column by column and padded to its longest row, so one step of the SpMV
+// handles one nonzero of C rows at once: C values, C column numbers and
+// a gather of C entries of x. Sorting keeps the padding small, sigma
+// bounds how far a row moves away from its neighbours in x and y.
+class sell_c_sigma {
+ public:
+     int rows;
+     int columns;
+     int chunk_rows;  // C
+     int sigma;
+     std::vector<int> chunk_ptr;  // start of each chunk in values/col_index
+     std::vector<int> chunk_len;  // longest row of each chunk
+     std::vector<int> perm;       // original number of each stored row
+     std::vector<int> row_len;    // nonzeros of each stored row
+     std::vector<double> values;  // padding holds 0.0
+     std::vector<int> col_index;  // padding repeats the last column of a row
+
+     sell_c_sigma(const sparse_matrix& A, int C = 8, int _sigma = 256);
+
+     sparse_matrix to_crs() const;
+
+     // stored entries (padding included) per nonzero, 1.0 means no padding
+     double fill_ratio() const;
+
+     // spmv_kernel::automatic takes the widest kernel this CPU runs and C
+     // allows: AVX-512 for C a multiple of 8, AVX2 for a multiple of 4
+     std::vector<double> multiply(const std::vector<double>& x,
+       spmv_kernel kernel = spmv_kernel::automatic) const;
+};
+
+bool spmv_kernel_supported(spmv_kernel kernel);
+
+#endif  // MODULES_TASK_1_YASHIN_K_CRS_MULT_DOUBLE_SELL_C_SIGMA_H_
@@ -1,4 +1,5 @@
 // Copyright 2022 Yashin Kirill
+#include <stdexcept>
 #include <vector>
 
 #include "../../modules/task_1/yashin_k_crs_mult_double/sparse_matrix_multiplication_crs.h"
@@ -54,6 +55,20 @@ sparse_matrix sparse_multiplication(const sparse_matrix& A, const sparse_matrix&
     return result;
 }
 
+std::vector<double> crs_spmv(const sparse_matrix& A,
+  const std::vector<double>& x) {
+    if (static_cast<int>(x.size()) != A.columns)
+        throw std::runtime_error("vector size does not match the matrix");
+    std::vector<double> y(A.rows);
+    for (int i = 0; i < A.rows; i++) {
+        double sum = 0;
+        for (int j = A.row_index[i]; j < A.row_index[i + 1]; j++)
+            sum += A.values[j] * x[A.col_index[j]];
+        y[i] = sum;
+    }
+    return y;
+}
+
 Matrix matrix_multiplication(const Matrix& A, const Matrix& B) {
     Matrix result(A.size());
     for (size_t i = 0; i < result.size(); i++)
@@ -58,7 +58,7 @@ class sparse_matrix {
       }
      }
 
-     sparse_matrix(const sparse_matrix& matrix) {}
+     sparse_matrix(const sparse_matrix& matrix) = default;
 
      ~sparse_matrix() {}
 
@@ -71,10 +71,16 @@ class sparse_matrix {
 
      friend sparse_matrix sparse_multiplication(const sparse_matrix& A,
       const sparse_matrix& B);
+     friend std::vector<double> crs_spmv(const sparse_matrix& A,
+      const std::vector<double>& x);
+     friend class sell_c_sigma;
 };
 
 sparse_matrix sparse_multiplication(const sparse_matrix& A,
   const sparse_matrix& B);
+// y = A x straight from the CRS arrays
+std::vector<double> crs_spmv(const sparse_matrix& A,
+  const std::vector<double>& x);
 Matrix matrix_multiplication(const Matrix& A, const Matrix& B);
 Matrix random_matrix(const int& rows, const int& columns);
 
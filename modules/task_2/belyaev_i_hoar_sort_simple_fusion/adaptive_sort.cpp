@@ -0,0 +1,394 @@
+// Copyright 2022 Belyaev Ilya
+#include "../../../modules/task_2/belyaev_i_hoar_sort_simple_fusion/adaptive_sort.h"
+
+#include <omp.h>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../../../3rdparty/unapproved/parallel_scan.h"
+#include "../../../modules/task_2/belyaev_i_hoar_sort_simple_fusion/hoar_sort_simple_fusion.h"
+
+namespace {
+const int kSampleSize = 1024;
+// runs shorter than this are extended by insertion sort (TimSort minrun)
+const int kMinRun = 32;
+// merges are cut into pieces of about this many output elements
+const int kMergePiece = 1 << 16;
+// below this size radix and counting sort do not pay off
+const int kSmallInput = 1 << 15;
+const int kRadix = 256;
+// nearly sorted: at most one descent per this many keys
+const int kNearlySortedRatio = 16;
+
+struct merge_piece {
+    int a_begin, a_end;
+    int b_begin, b_end;
+    int out;
+};
+
+void insertion_sort(int* a, int lo, int hi) {
+    for (int i = lo + 1; i < hi; i++) {
+        int key = a[i];
+        int j = i;
+        for (; j > lo && a[j - 1] > key; j--)
+            a[j] = a[j - 1];
+        a[j] = key;
+    }
+}
+
+// How many of the first k elements of the stable merge of x[0, nx) and
+// y[0, ny) come from x
+int co_rank(int k, const int* x, int nx, const int* y, int ny) {
+    int lo = std::max(0, k - ny), hi = std::min(k, nx);
+    while (lo < hi) {
+        int i = lo + (hi - lo) / 2;
+        int j = k - i;
+        if (j > 0 && y[j - 1] >= x[i])
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+// number of bytes the radix sort has to look at
+int radix_passes(uint32_t range) {
+    int passes = 0;
+    for (; range > 0; range >>= 8)
+        passes++;
+    return passes;
+}
+
+int ceil_log2(int64_t x) {
+    int log = 0;
+    for (int64_t v = 1; v < x; v <<= 1)
+        log++;
+    return log;
+}
+
+// Merges the sorted runs a[bounds[i], bounds[i + 1]) pairwise, round by
+// round, until a single run is left
+void merge_runs(int* a, int n, std::vector<int> bounds) {
+    std::vector<int> buffer(n);
+    int* src = a;
+    int* dst = buffer.data();
+    while (bounds.size() > 2) {
+        // every pair of neighbouring runs is cut into pieces of similar
+        // size, so even the last rounds with two long runs keep all
+        // threads busy
+        std::vector<merge_piece> pieces;
+        std::vector<int> next_bounds(1, 0);
+        for (size_t r = 0; r + 1 < bounds.size(); r += 2) {
+            int lo = bounds[r], mid = bounds[r + 1];
+            int hi = r + 2 < bounds.size() ? bounds[r + 2] : mid;
+            int parts = (hi - lo + kMergePiece - 1) / kMergePiece;
+            int prev_a = 0, prev_b = 0;
+            for (int p = 1; p <= parts; p++) {
+                int k = static_cast<int>(
+                    static_cast<int64_t>(hi - lo) * p / parts);
+                int ka = co_rank(k, src + lo, mid - lo, src + mid, hi - mid);
+                merge_piece piece = { lo + prev_a, lo + ka,
+                                      mid + prev_b, mid + k - ka,
+                                      lo + prev_a + prev_b };
+                pieces.push_back(piece);
+                prev_a = ka;
+                prev_b = k - ka;
+            }
+            next_bounds.push_back(hi);
+        }
+
+        int count = static_cast<int>(pieces.size());
+        #pragma omp parallel for schedule(dynamic)
+        for (int p = 0; p < count; p++) {
+            const merge_piece& piece = pieces[p];
+            std::merge(src + piece.a_begin, src + piece.a_end,
+                       src + piece.b_begin, src + piece.b_end,
+                       dst + piece.out);
+        }
+        std::swap(src, dst);
+        bounds.swap(next_bounds);
+    }
+
+    if (src != a) {
+        #pragma omp parallel for
+        for (int i = 0; i < n; i++)
+            a[i] = src[i];
+    }
+}
+}  // namespace
+
+input_profile profile_input(const int* a, int n) {
+    input_profile profile = { n, 0, 0, 0, 0, 0, 0, 0 };
+    if (n == 0)
+        return profile;
+    profile.min_key = profile.max_key = a[0];
+
+    #pragma omp parallel
+    {
+        int lo = a[0], hi = a[0];
+        int64_t descents = 0, ascents = 0, turns = 0;
+        #pragma omp for nowait
+        for (int i = 0; i < n - 1; i++) {
+            lo = std::min(lo, a[i + 1]);
+            hi = std::max(hi, a[i + 1]);
+            descents += a[i] > a[i + 1];
+            ascents += a[i] < a[i + 1];
+            if (i > 0)
+                turns += (a[i - 1] < a[i] && a[i] > a[i + 1]) ||
+                         (a[i - 1] > a[i] && a[i] < a[i + 1]);
+        }
+        #pragma omp critical
+        {
+            profile.min_key = std::min(profile.min_key, lo);
+            profile.max_key = std::max(profile.max_key, hi);
+            profile.descents += descents;
+            profile.ascents += ascents;
+            profile.turns += turns;
+        }
+    }
+
+    std::vector<int> sample;
+    int step = std::max(1, n / kSampleSize);
+    for (int i = 0; i < n; i += step)
+        sample.push_back(a[i]);
+    std::sort(sample.begin(), sample.end());
+    profile.sample_size = static_cast<int>(sample.size());
+    profile.sample_distinct = static_cast<int>(
+        std::unique(sample.begin(), sample.end()) - sample.begin());
+    return profile;
+}
+
+// The costs are counted in passes over the data: a merge round streams
+// the data once, a radix pass costs about two (histogram and a scattered
+// write), counting sort about two in total
+sort_algorithm choose_algorithm(const input_profile& p) {
+    if (p.descents == 0)
+        return sort_algorithm::none;
+    if (p.ascents == 0)
+        return sort_algorithm::reverse;
+    if (p.size < kSmallInput)
+        return sort_algorithm::quicksort;
+
+    uint32_t range = static_cast<uint32_t>(p.max_key) -
+                     static_cast<uint32_t>(p.min_key);
+    int threads = omp_get_max_threads();
+    if (static_cast<int64_t>(range) * threads < p.size)
+        return sort_algorithm::counting;
+
+    // every monotone run ends at a turn, runs shorter than kMinRun are
+    // glued together by insertion sort
+    int64_t runs = std::min<int64_t>(p.turns + 1, p.size / kMinRun + 1);
+    if (ceil_log2(runs) <= 2 * radix_passes(range))
+        return sort_algorithm::natural_merge;
+    // at most two keys per descent leave the sorted sequence
+    if (p.descents * kNearlySortedRatio <= p.size)
+        return sort_algorithm::nearly_sorted;
+
+    // few distinct keys: the three-way partition of hoar_sort_omp is done
+    // after a handful of levels
+    if (p.sample_distinct * 16 <= p.sample_size)
+        return sort_algorithm::quicksort;
+    return sort_algorithm::radix;
+}
+
+sort_algorithm adaptive_sort(std::vector<int>* arr) {
+    int n = static_cast<int>(arr->size());
+    if (n < 2)
+        return sort_algorithm::none;
+    int* a = arr->data();
+    input_profile profile = profile_input(a, n);
+    sort_algorithm algorithm = choose_algorithm(profile);
+    switch (algorithm) {
+    case sort_algorithm::none:
+        break;
+    case sort_algorithm::reverse:
+        std::reverse(a, a + n);
+        break;
+    case sort_algorithm::natural_merge:
+        natural_merge_sort(a, n);
+        break;
+    case sort_algorithm::nearly_sorted:
+        nearly_sorted_sort(arr);
+        break;
+    case sort_algorithm::counting:
+        counting_sort(a, n, profile.min_key, profile.max_key);
+        break;
+    case sort_algorithm::radix:
+        radix_sort(a, n, profile.min_key, profile.max_key);
+        break;
+    case sort_algorithm::quicksort:
+        hoar_sort_omp(0, n - 1, arr);
+        break;
+    }
+    return algorithm;
+}
+
+void natural_merge_sort(int* a, int n) {
+    // <Run detection>
+    // ascending runs are kept, strictly descending ones are reversed,
+    // short ones are extended to kMinRun by insertion sort
+    std::vector<int> bounds(1, 0);
+    for (int i = 0; i < n;) {
+        int j = i + 1;
+        if (j < n && a[j] < a[j - 1]) {
+            while (j < n && a[j] < a[j - 1])
+                j++;
+            std::reverse(a + i, a + j);
+        } else {
+            while (j < n && a[j] >= a[j - 1])
+                j++;
+        }
+        if (j - i < kMinRun) {
+            j = std::min(n, i + kMinRun);
+            insertion_sort(a, i, j);
+        }
+        bounds.push_back(j);
+        i = j;
+    }
+    // </Run detection>
+
+    merge_runs(a, n, bounds);
+}
+
+void nearly_sorted_sort(std::vector<int>* arr) {
+    int n = static_cast<int>(arr->size());
+    int* a = arr->data();
+    int threads = std::max(1, std::min(omp_get_max_threads(),
+                                       n / kMergePiece));
+    std::vector<int> residue(n);
+    std::vector<int> kept_size(threads), residue_size(threads);
+
+    // <Extraction>
+    // every thread keeps a sorted subsequence of its chunk in place (a
+    // stack: a key smaller than the top removes both of them) and moves
+    // the removed keys to residue
+    #pragma omp parallel num_threads(threads)
+    {
+        int t = omp_get_thread_num();
+        int begin = static_cast<int>(static_cast<int64_t>(n) * t / threads);
+        int end = static_cast<int>(
+            static_cast<int64_t>(n) * (t + 1) / threads);
+        int top = begin, out = begin;
+        for (int i = begin; i < end; i++) {
+            if (top == begin || a[top - 1] <= a[i]) {
+                a[top++] = a[i];
+            } else {
+                residue[out++] = a[--top];
+                residue[out++] = a[i];
+            }
+        }
+        kept_size[t] = top - begin;
+        residue_size[t] = out - begin;
+    }
+    // </Extraction>
+
+    // kept chunks first, all residue keys after them
+    std::vector<int> kept_at(threads + 1, 0), residue_at(threads + 1, 0);
+    for (int t = 0; t < threads; t++) {
+        kept_at[t + 1] = kept_at[t] + kept_size[t];
+        residue_at[t + 1] = residue_at[t] + residue_size[t];
+    }
+    std::vector<int> packed(n);
+    #pragma omp parallel for num_threads(threads)
+    for (int t = 0; t < threads; t++) {
+        int begin = static_cast<int>(static_cast<int64_t>(n) * t / threads);
+        std::copy(a + begin, a + begin + kept_size[t],
+                  packed.begin() + kept_at[t]);
+        std::copy(residue.begin() + begin,
+                  residue.begin() + begin + residue_size[t],
+                  packed.begin() + kept_at[threads] + residue_at[t]);
+    }
+    residue.clear();
+    residue.shrink_to_fit();
+    if (kept_at[threads] < n - 1)
+        hoar_sort_omp(kept_at[threads], n - 1, &packed);
+    arr->swap(packed);
+
+    std::vector<int> bounds(kept_at);
+    bounds.push_back(n);
+    merge_runs(arr->data(), n, bounds);
+}
+
+void counting_sort(int* a, int n, int min_key, int max_key) {
+    int range = static_cast<int>(static_cast<uint32_t>(max_key) -
+                                 static_cast<uint32_t>(min_key)) + 1;
+    int threads = omp_get_max_threads();
+    std::vector<int> counts(static_cast<size_t>(threads) * range, 0);
+    std::vector<int> start(range + 1, 0);
+
+    #pragma omp parallel num_threads(threads)
+    {
+        int* cnt = counts.data() +
+                   static_cast<size_t>(omp_get_thread_num()) * range;
+        #pragma omp for
+        for (int i = 0; i < n; i++)
+            cnt[a[i] - min_key]++;
+        // implicit barrier: all histograms are complete
+        #pragma omp for
+        for (int v = 0; v < range; v++) {
+            int total = 0;
+            for (int t = 0; t < threads; t++)
+                total += counts[static_cast<size_t>(t) * range + v];
+            start[v] = total;
+        }
+    }
+    // the range can be as long as the input, so the offsets are a
+    // parallel scan too
+    pscan::exclusive_scan_omp(start.data(), start.data(), start.size());
+    #pragma omp parallel for schedule(dynamic, 64) num_threads(threads)
+    for (int v = 0; v < range; v++)
+        std::fill(a + start[v], a + start[v + 1], min_key + v);
+}
+
+void radix_sort(int* a, int n, int min_key, int max_key) {
+    // keys are sorted as unsigned offsets from min_key, so only the bytes
+    // the key range actually uses are processed
+    uint32_t base = static_cast<uint32_t>(min_key);
+    int passes = radix_passes(static_cast<uint32_t>(max_key) - base);
+    int threads = omp_get_max_threads();
+    // digit-major: entry d * team + t counts digit d in the range of
+    // thread t, its exclusive scan puts those keys right after the ones
+    // of the same digit from threads 0..t-1, which keeps every pass stable
+    std::vector<int> counts(threads * kRadix);
+    std::vector<int> buffer(n);
+    int* src = a;
+    int* dst = buffer.data();
+
+    #pragma omp parallel num_threads(threads)
+    {
+        int id = omp_get_thread_num();
+        int team = omp_get_num_threads();
+        int begin = static_cast<int>(static_cast<int64_t>(n) * id / team);
+        int end = static_cast<int>(static_cast<int64_t>(n) * (id + 1) / team);
+        int cnt[kRadix];
+
+        for (int pass = 0; pass < passes; pass++) {
+            int shift = 8 * pass;
+            std::fill(cnt, cnt + kRadix, 0);
+            for (int i = begin; i < end; i++)
+                cnt[((static_cast<uint32_t>(src[i]) - base) >> shift) &
+                    (kRadix - 1)]++;
+            for (int d = 0; d < kRadix; d++)
+                counts[d * team + id] = cnt[d];
+            #pragma omp barrier
+            // the team is already running, the table is scanned by one
+            // of its threads
+            #pragma omp single
+            pscan::exclusive_scan_seq(counts.data(), counts.data(),
+                                      static_cast<size_t>(team) * kRadix);
+            for (int d = 0; d < kRadix; d++)
+                cnt[d] = counts[d * team + id];
+            for (int i = begin; i < end; i++)
+                dst[cnt[((static_cast<uint32_t>(src[i]) - base) >> shift) &
+                        (kRadix - 1)]++] = src[i];
+            #pragma omp barrier
+            #pragma omp single
+            std::swap(src, dst);
+        }
+        if (src != a)
+            std::copy(src + begin, src + end, a + begin);
+    }
+}
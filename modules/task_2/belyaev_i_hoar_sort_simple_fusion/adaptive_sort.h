@@ -0,0 +1,43 @@
+// Copyright 2022 Belyaev Ilya
+#ifndef MODULES_TASK_2_BELYAEV_I_HOAR_SORT_SIMPLE_FUSION_ADAPTIVE_SORT_H_
+#define MODULES_TASK_2_BELYAEV_I_HOAR_SORT_SIMPLE_FUSION_ADAPTIVE_SORT_H_
+
+#include <cstdint>
+#include <vector>
+
+// What adaptive_sort learns about the input in one parallel pass plus a
+// small sample
+struct input_profile {
+    int size;
+    int min_key, max_key;
+    int64_t descents;     // pairs with a[i] > a[i + 1]
+    int64_t ascents;      // pairs with a[i] < a[i + 1]
+    int64_t turns;        // a[i] is a strict local maximum or minimum
+    int sample_size;
+    int sample_distinct;  // distinct keys in an evenly spaced sample
+};
+
+enum class sort_algorithm {
+    none,           // already sorted
+    reverse,        // non-increasing input, only reversed
+    natural_merge,  // few runs, merged TimSort-style
+    nearly_sorted,  // few keys out of place, sorted apart and merged in
+    counting,       // key range not larger than the input
+    radix,          // wide integer keys
+    quicksort       // hoar_sort_omp: small inputs, few distinct keys
+};
+
+input_profile profile_input(const int* a, int n);
+sort_algorithm choose_algorithm(const input_profile& profile);
+
+// Profiles the input, picks the cheapest algorithm for it and sorts.
+// Returns the algorithm that was used
+sort_algorithm adaptive_sort(std::vector<int>* arr);
+
+// Back-ends, usable on their own
+void natural_merge_sort(int* a, int n);
+void nearly_sorted_sort(std::vector<int>* arr);
+void counting_sort(int* a, int n, int min_key, int max_key);
+void radix_sort(int* a, int n, int min_key, int max_key);
+
+#endif  // MODULES_TASK_2_BELYAEV_I_HOAR_SORT_SIMPLE_FUSION_ADAPTIVE_SORT_H_
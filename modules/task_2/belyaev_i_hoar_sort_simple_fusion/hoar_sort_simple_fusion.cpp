@@ -1,11 +1,14 @@
 // Copyright 2022 Belyaev Ilya
 #include "../../../modules/task_2/belyaev_i_hoar_sort_simple_fusion/hoar_sort_simple_fusion.h"
 
+#include <omp.h>
 #include <random>
 #include <algorithm>
 #include <ctime>
 #include <utility>
 #include <vector>
+#include <atomic>
+#include <stdexcept>
 
 std::vector<int> random_gen(int size) {
     std::random_device dev;
@@ -75,42 +78,284 @@ std::vector<int>merge(const std::vector<int>& a, const std::vector<int>& b) {
 
     return result;
 }
-void hoar_sort_omp(int left, int right, std::vector <int>*arr) {
-        while (right > left) {
-            int it_l = left;
-            int it_r = right;
-            double pivot = arr->at((left + right) / 2);
-
-            while (it_l <= it_r) {
-                while (arr->at(it_l) < pivot) {
-                    it_l++;
-                }
-                while (arr->at(it_r) > pivot) {
-                    it_r--;
-                }
-                if (it_l <= it_r) {
-                    std::swap(arr->at(it_l), arr->at(it_r));
-                    it_l++;
-                    it_r--;
+namespace {
+const int kInsertionCutoff = 16;
+const int kNintherCutoff = 128;
+const int kTaskCutoff = 1 << 12;
+const int kBlockSize = 1 << 12;
+// A segment is partitioned by the whole team while it holds at least
+// this many blocks per thread
+const int kParallelBlocksPerThread = 16;
+
+void insertion_sort(int* a, int lo, int hi) {
+    for (int i = lo + 1; i < hi; i++) {
+        int key = a[i];
+        int j = i;
+        for (; j > lo && a[j - 1] > key; j--)
+            a[j] = a[j - 1];
+        a[j] = key;
+    }
+}
+
+void heap_sort(int* a, int lo, int hi) {
+    std::make_heap(a + lo, a + hi);
+    std::sort_heap(a + lo, a + hi);
+}
+
+int median_of_3(int* a, int i, int j, int k) {
+    if (a[i] < a[j])
+        return a[j] < a[k] ? a[j] : (a[i] < a[k] ? a[k] : a[i]);
+    return a[i] < a[k] ? a[i] : (a[j] < a[k] ? a[k] : a[j]);
+}
+
+// median-of-3 for short segments, Tukey's ninther for long ones
+int choose_pivot(int* a, int lo, int hi) {
+    int n = hi - lo;
+    int mid = lo + n / 2;
+    if (n < kNintherCutoff)
+        return median_of_3(a, lo, mid, hi - 1);
+    int s = n / 8;
+    int m1 = median_of_3(a, lo, lo + s, lo + 2 * s);
+    int m2 = median_of_3(a, mid - s, mid, mid + s);
+    int m3 = median_of_3(a, hi - 1 - 2 * s, hi - 1 - s, hi - 1);
+    return m1 < m2 ? (m2 < m3 ? m2 : (m1 < m3 ? m3 : m1))
+                   : (m1 < m3 ? m1 : (m2 < m3 ? m3 : m2));
+}
+
+struct less_than {
+    int pivot;
+    bool operator()(int x) const { return x < pivot; }
+};
+
+struct not_greater_than {
+    int pivot;
+    bool operator()(int x) const { return x <= pivot; }
+};
+
+// Moves elements for which less(x) holds to the front of [lo, hi),
+// returns the first position of the rest
+template <class Less>
+int sequential_partition(int* a, int lo, int hi, Less less) {
+    int i = lo, j = hi - 1;
+    while (true) {
+        while (i <= j && less(a[i]))
+            i++;
+        while (i <= j && !less(a[j]))
+            j--;
+        if (i >= j)
+            return i;
+        std::swap(a[i++], a[j--]);
+    }
+}
+
+int depth_limit(int n) {
+    int depth = 0;
+    while (n > 1) {
+        n >>= 1;
+        depth++;
+    }
+    return 2 * depth;
+}
+
+// Splits [lo, hi) by the pivot value so that no side is empty: when no
+// element is less than the pivot, the elements equal to it (which are
+// already in place) are split off instead
+template <class Partitioner>
+void split_by_pivot(int* a, int lo, int hi, Partitioner partition,
+                    int* left_end, int* right_begin) {
+    int pivot = choose_pivot(a, lo, hi);
+    int split = partition(a, lo, hi, less_than{pivot});
+    *left_end = split;
+    *right_begin = split;
+    if (split == lo)
+        *right_begin = partition(a, lo, hi, not_greater_than{pivot});
+}
+
+struct sequential_partitioner {
+    template <class Less>
+    int operator()(int* a, int lo, int hi, Less less) const {
+        return sequential_partition(a, lo, hi, less);
+    }
+};
+
+void sort_segment(int* a, int lo, int hi, int depth) {
+    while (hi - lo > kInsertionCutoff) {
+        if (depth-- == 0) {
+            heap_sort(a, lo, hi);
+            return;
+        }
+        int left_end, right_begin;
+        split_by_pivot(a, lo, hi, sequential_partitioner(),
+                       &left_end, &right_begin);
+
+        // the smaller side goes to a task or recursion, the larger one
+        // stays in the loop, so the stack never grows beyond O(log n)
+        int sl = lo, sh = left_end;
+        if (left_end - lo > hi - right_begin) {
+            sl = right_begin;
+            sh = hi;
+            hi = left_end;
+        } else {
+            lo = right_begin;
+        }
+        if (sh - sl > kTaskCutoff) {
+            #pragma omp task firstprivate(sl, sh, depth)
+            sort_segment(a, sl, sh, depth);
+        } else {
+            sort_segment(a, sl, sh, depth);
+        }
+    }
+    insertion_sort(a, lo, hi);
+}
+
+// Block-based parallel partition in the style of Tsigas and Zhang.
+// Threads claim blocks from both ends of [lo, hi) and neutralize them
+// pairwise: a left block is done when it holds only elements for which
+// less() holds, a right block when it holds none. Each thread is left
+// with at most one unfinished block, those are swapped next to the gap
+// in the middle that no block covered, and that small region is
+// partitioned sequentially
+template <class Less>
+int parallel_partition(int* a, int lo, int hi, Less less) {
+    const int n = hi - lo;
+    const int num_blocks = n / kBlockSize;
+    std::atomic<int> claimed(0), left_claims(0), right_claims(0);
+    std::vector<char> left_done(num_blocks, 0), right_done(num_blocks, 0);
+
+    #pragma omp parallel
+    {
+        // block k from the left is [lo + kB, lo + (k + 1)B), from the
+        // right it is [hi - (k + 1)B, hi - kB)
+        auto claim = [&](bool left, int* block) {
+            if (claimed.fetch_add(1) >= num_blocks)
+                return false;
+            *block = left ? left_claims.fetch_add(1)
+                          : right_claims.fetch_add(1);
+            return true;
+        };
+        int lb = -1, rb = -1, li = 0, le = 0, ri = 0, re = 0;
+        while (true) {
+            if (li == le) {
+                if (lb >= 0)
+                    left_done[lb] = 1;
+                if (!claim(true, &lb)) {
+                    lb = -1;
+                    break;
                 }
+                li = lo + lb * kBlockSize;
+                le = li + kBlockSize;
             }
-#pragma omp parallel sections
-            {
-#pragma omp section
-                {
-                    if (2 * it_l > left + right) {
-                        hoar_sort(it_l, right, arr);
-                        right = it_l - 1;
-                    }
-                }
-#pragma omp section
-                {
-                    if (2 * it_l <= left + right) {
-                        hoar_sort(left, it_l - 1, arr);
-                        left = it_l;
-                    }
+            if (ri == re) {
+                if (rb >= 0)
+                    right_done[rb] = 1;
+                if (!claim(false, &rb)) {
+                    rb = -1;
+                    break;
                 }
+                re = hi - rb * kBlockSize;
+                ri = re - kBlockSize;
             }
+            while (li < le && less(a[li]))
+                li++;
+            while (ri < re && !less(a[ri]))
+                ri++;
+            if (li < le && ri < re)
+                std::swap(a[li++], a[ri++]);
         }
-    return;
+        if (lb >= 0 && li == le)
+            left_done[lb] = 1;
+        if (rb >= 0 && ri == re)
+            right_done[rb] = 1;
+    }
+
+    // Unfinished left blocks are swapped with finished ones closest to
+    // the middle, same for the right side
+    const int lc = left_claims.load(), rc = right_claims.load();
+    int to = lc - 1;
+    for (int k = 0; k < to; k++) {
+        if (left_done[k])
+            continue;
+        while (to > k && !left_done[to])
+            to--;
+        if (to > k) {
+            std::swap_ranges(a + lo + k * kBlockSize,
+                             a + lo + (k + 1) * kBlockSize,
+                             a + lo + to * kBlockSize);
+            std::swap(left_done[k], left_done[to]);
+        }
+    }
+    to = rc - 1;
+    for (int k = 0; k < to; k++) {
+        if (right_done[k])
+            continue;
+        while (to > k && !right_done[to])
+            to--;
+        if (to > k) {
+            std::swap_ranges(a + hi - (k + 1) * kBlockSize,
+                             a + hi - k * kBlockSize,
+                             a + hi - (to + 1) * kBlockSize);
+            std::swap(right_done[k], right_done[to]);
+        }
+    }
+
+    int mid_lo = lo, mid_hi = hi;
+    for (int k = 0; k < lc && left_done[k]; k++)
+        mid_lo += kBlockSize;
+    for (int k = 0; k < rc && right_done[k]; k++)
+        mid_hi -= kBlockSize;
+    return sequential_partition(a, mid_lo, mid_hi, less);
+}
+
+struct parallel_partitioner {
+    template <class Less>
+    int operator()(int* a, int lo, int hi, Less less) const {
+        return parallel_partition(a, lo, hi, less);
+    }
+};
+
+// Partitions with the whole team while segments are large, collects the
+// rest for the task phase
+void sort_top(int* a, int lo, int hi, int depth, int threads,
+              std::vector<std::pair<int, int>>* segments,
+              std::vector<int>* depths) {
+    while (hi - lo >= kParallelBlocksPerThread * kBlockSize * threads &&
+           depth > 0) {
+        depth--;
+        int left_end, right_begin;
+        split_by_pivot(a, lo, hi, parallel_partitioner(),
+                       &left_end, &right_begin);
+        if (left_end - lo < hi - right_begin) {
+            sort_top(a, lo, left_end, depth, threads, segments, depths);
+            lo = right_begin;
+        } else {
+            sort_top(a, right_begin, hi, depth, threads, segments, depths);
+            hi = left_end;
+        }
+    }
+    segments->push_back(std::make_pair(lo, hi));
+    depths->push_back(depth);
+}
+}  // namespace
+
+void hoar_sort_omp(int left, int right, std::vector <int>* arr) {
+    if (right <= left)
+        return;
+    if (left < 0 || right >= static_cast<int>(arr->size()))
+        throw std::out_of_range("hoar_sort_omp: range out of vector");
+
+    int* a = arr->data();
+    int lo = left, hi = right + 1;
+    std::vector<std::pair<int, int>> segments;
+    std::vector<int> depths;
+    sort_top(a, lo, hi, depth_limit(hi - lo), omp_get_max_threads(),
+             &segments, &depths);
+
+    #pragma omp parallel
+    #pragma omp single
+    for (size_t i = 0; i < segments.size(); i++) {
+        int sl = segments[i].first, sh = segments[i].second;
+        int depth = depths[i];
+        #pragma omp task firstprivate(sl, sh, depth)
+        sort_segment(a, sl, sh, depth);
+    }
 }
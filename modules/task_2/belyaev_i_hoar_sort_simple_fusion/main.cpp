@@ -4,7 +4,23 @@
 
 
 
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <random>
+#include <vector>
+
 #include "./hoar_sort_simple_fusion.h"
+#include "./adaptive_sort.h"
+
+#define USE_EFFICIENCY_TESTS 0
+
+bool sorts_like_std(std::vector<int> vect) {
+    std::vector<int> expected = vect;
+    std::sort(expected.begin(), expected.end());
+    hoar_sort_omp(0, static_cast<int>(vect.size()) - 1, &vect);
+    return vect == expected;
+}
 
 TEST(randomgen, run) {
     ASSERT_NO_THROW(random_gen(100));
@@ -132,7 +148,157 @@ TEST(merging, runwithsize1000tosize2000) {
     }
 }
 
+TEST(hoarsort_adversarial, sorted_and_reversed) {
+    int size = 2000000;
+    std::vector<int> vect(size);
+    for (int i = 0; i < size; i++)
+        vect[i] = i;
+    ASSERT_TRUE(sorts_like_std(vect));
+    std::reverse(vect.begin(), vect.end());
+    ASSERT_TRUE(sorts_like_std(vect));
+}
+
+TEST(hoarsort_adversarial, all_equal_and_few_distinct) {
+    ASSERT_TRUE(sorts_like_std(std::vector<int>(2000000, 7)));
+    std::vector<int> vect = random_gen(2000000);
+    for (int& val : vect)
+        val %= 3;
+    ASSERT_TRUE(sorts_like_std(vect));
+}
+
+TEST(hoarsort_adversarial, organ_pipe_and_sawtooth) {
+    int size = 1500000;
+    std::vector<int> vect(size);
+    for (int i = 0; i < size; i++)
+        vect[i] = i < size / 2 ? i : size - i;
+    ASSERT_TRUE(sorts_like_std(vect));
+    for (int i = 0; i < size; i++)
+        vect[i] = i % 1000;
+    ASSERT_TRUE(sorts_like_std(vect));
+}
+
+TEST(hoarsort_adversarial, random_big_and_subrange) {
+    std::vector<int> vect = random_gen(3000000);
+    for (int& val : vect)
+        val = val * 100003 - 5000000;
+    ASSERT_TRUE(sorts_like_std(vect));
+
+    std::vector<int> part = random_gen(1000);
+    std::vector<int> expected = part;
+    std::sort(expected.begin() + 100, expected.begin() + 900);
+    hoar_sort_omp(100, 899, &part);
+    ASSERT_EQ(expected, part);
+}
+
+std::vector<int> wide_random(int size) {
+    std::mt19937 gen(size);
+    std::vector<int> vect(size);
+    for (int& val : vect)
+        val = static_cast<int>(gen());
+    return vect;
+}
+
+bool adaptive_sorts_like_std(std::vector<int> vect,
+                             sort_algorithm expected_algorithm) {
+    std::vector<int> expected = vect;
+    std::sort(expected.begin(), expected.end());
+    sort_algorithm algorithm = adaptive_sort(&vect);
+    return vect == expected && algorithm == expected_algorithm;
+}
+
+TEST(adaptive_sort, sorted_and_reversed) {
+    std::vector<int> vect = wide_random(1000000);
+    std::sort(vect.begin(), vect.end());
+    ASSERT_TRUE(adaptive_sorts_like_std(vect, sort_algorithm::none));
+    std::reverse(vect.begin(), vect.end());
+    ASSERT_TRUE(adaptive_sorts_like_std(vect, sort_algorithm::reverse));
+}
+
+TEST(adaptive_sort, few_runs_use_natural_merge) {
+    std::vector<int> vect = wide_random(1000000);
+    // 95% sorted: a sorted array followed by an unsorted tail
+    std::sort(vect.begin(), vect.begin() + 950000);
+    std::sort(vect.begin() + 950000, vect.end(), std::greater<int>());
+    ASSERT_TRUE(adaptive_sorts_like_std(vect,
+                                        sort_algorithm::natural_merge));
+
+    // organ pipe: one ascending and one descending run
+    int size = 500000;
+    for (int i = 0; i < size; i++)
+        vect[i] = (i < size / 2 ? i : size - i) * 4099;
+    vect.resize(size);
+    ASSERT_TRUE(adaptive_sorts_like_std(vect,
+                                        sort_algorithm::natural_merge));
+}
+
+TEST(adaptive_sort, small_range_and_wide_keys) {
+    std::vector<int> vect = random_gen(1000000);
+    for (int& val : vect)
+        val = val % 1000 - 500;
+    ASSERT_TRUE(adaptive_sorts_like_std(vect, sort_algorithm::counting));
+
+    ASSERT_TRUE(adaptive_sorts_like_std(wide_random(1000000),
+                                        sort_algorithm::radix));
+}
+
+TEST(adaptive_sort, few_distinct_wide_keys_use_quicksort) {
+    std::vector<int> vect = random_gen(1000000);
+    for (int& val : vect)
+        val = (val % 5 - 2) * 400000000;
+    ASSERT_TRUE(adaptive_sorts_like_std(vect, sort_algorithm::quicksort));
+    ASSERT_TRUE(adaptive_sorts_like_std(wide_random(1000),
+                                        sort_algorithm::quicksort));
+}
+
+TEST(adaptive_sort, nearly_sorted_keys_out_of_place) {
+    std::vector<int> vect = wide_random(1000000);
+    std::sort(vect.begin(), vect.end());
+    std::vector<int> noise = wide_random(20000);
+    for (int i = 0; i < 20000; i++)
+        vect[i * 50] = noise[i];
+    vect[0] = INT_MAX;
+    ASSERT_TRUE(adaptive_sorts_like_std(vect,
+                                        sort_algorithm::nearly_sorted));
+}
+
+// sorted keys with 5% of them replaced by random ones
+std::vector<int> five_percent_noise(int size) {
+    std::vector<int> vect = wide_random(size);
+    std::sort(vect.begin(), vect.end());
+    std::vector<int> noise = wide_random(size / 20);
+    for (int i = 0; i < size / 20; i++)
+        vect[i * 20 + 7] = noise[i];
+    return vect;
+}
+
+TEST(adaptive_sort, nearly_sorted_matches_hoar_sort) {
+    std::vector<int> vect = five_percent_noise(1000000);
+    std::vector<int> copy = vect;
+    sort_algorithm algorithm = adaptive_sort(&vect);
+    hoar_sort_omp(0, static_cast<int>(copy.size()) - 1, &copy);
+    ASSERT_EQ(copy, vect);
+    ASSERT_EQ(sort_algorithm::nearly_sorted, algorithm);
+}
 
+#if USE_EFFICIENCY_TESTS == 1
+TEST(adaptive_sort, nearly_sorted_faster_than_hoar_sort) {
+    int size = 8000000;
+    std::vector<int> vect = five_percent_noise(size);
+    std::vector<int> copy = vect;
+    double start = omp_get_wtime();
+    sort_algorithm algorithm = adaptive_sort(&vect);
+    double adaptive_time = omp_get_wtime() - start;
+    start = omp_get_wtime();
+    hoar_sort_omp(0, size - 1, &copy);
+    double hoar_time = omp_get_wtime() - start;
+
+    std::cout << "adaptive: " << adaptive_time << " s, hoar_sort_omp: "
+              << hoar_time << " s" << std::endl;
+    ASSERT_EQ(copy, vect);
+    ASSERT_EQ(sort_algorithm::nearly_sorted, algorithm);
+    ASSERT_LT(adaptive_time, hoar_time);
+}
+#endif  // USE_EFFICIENCY_TESTS
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -1,7 +1,11 @@
 // Copyright 2022 Denisova Julia
 #include <gtest/gtest.h>
 #include <vector>
+#include <algorithm>
+#include <random>
+#include <utility>
 #include "./radix_sort_omp.h"
+#include "./radix_sort_kv.h"
 
 
 TEST(OpenMP_RadixSort, 321) {
@@ -44,6 +48,60 @@ TEST(OpenMP_RadixSort, random) {
     // cout<<seq<<"  "<<par<<"  "<<seq/par<<endl;
 }
 
+TEST(OpenMP_RadixSort, pairs_stable_int_keys) {
+    std::vector<int> keys = getRandomVector(200000, 1000);
+    std::vector<uint32_t> rows(keys.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        rows[i] = static_cast<uint32_t>(i);
+    }
+    std::vector<std::pair<int, uint32_t>> expected;
+    for (size_t i = 0; i < keys.size(); i++) {
+        expected.push_back({ keys[i], rows[i] });
+    }
+    std::stable_sort(expected.begin(), expected.end(),
+        [](const std::pair<int, uint32_t>& a,
+            const std::pair<int, uint32_t>& b) { return a.first < b.first; });
+
+    radixSortPairs(keys.data(), rows.data(), keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        ASSERT_EQ(expected[i].first, keys[i]);
+        ASSERT_EQ(expected[i].second, rows[i]);
+    }
+}
+
+TEST(OpenMP_RadixSort, pairs_unstable_double_keys) {
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> dist(-1e9, 1e9);
+    std::vector<double> keys(300000);
+    for (double& k : keys) {
+        k = dist(gen);
+    }
+    keys[7] = -0.0;
+    keys[8] = 0.0;
+    std::vector<double> original = keys;
+    std::vector<uint64_t> payload(keys.size());
+    for (size_t i = 0; i < payload.size(); i++) {
+        payload[i] = i;
+    }
+
+    radixSortPairs(keys.data(), payload.data(), keys.size(), false);
+    ASSERT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    for (size_t i = 0; i < keys.size(); i++) {
+        ASSERT_EQ(original[payload[i]], keys[i]);
+    }
+}
+
+TEST(OpenMP_RadixSort, argsort_int_and_double) {
+    std::vector<int> a = { 5, -3, 5, 0, -3, 9 };
+    ASSERT_EQ(radixArgsort(a.data(), a.size()),
+        std::vector<uint32_t>({ 1, 4, 3, 0, 2, 5 }));
+    ASSERT_EQ(a, std::vector<int>({ 5, -3, 5, 0, -3, 9 }));
+
+    std::vector<double> d = { 2.5, -1e300, 0.0, -7.0, 1e-300 };
+    ASSERT_EQ(radixArgsort(d.data(), d.size(), false),
+        std::vector<uint32_t>({ 1, 3, 2, 4, 0 }));
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,293 @@
+// Copyright 2022 Denisova Julia
+#ifndef MODULES_TASK_2_DENISOVA_RADIX_SORT_OMP_RADIX_SORT_KV_H_
+#define MODULES_TASK_2_DENISOVA_RADIX_SORT_OMP_RADIX_SORT_KV_H_
+#include <omp.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+// Key/payload radix sort. Keys and payloads live in two separate arrays
+// (struct of arrays): a pass reads and writes sizeof(Key) +
+// sizeof(Payload) bytes per element and no pairs are ever built.
+// Keys are sorted by an unsigned image of their bits, so int32_t,
+// uint32_t, int64_t, uint64_t, float and double keys are supported.
+namespace radixkv {
+
+template <class Key> struct KeyBits;
+
+template <> struct KeyBits<uint32_t> {
+    typedef uint32_t type;
+    static type encode(type b) { return b; }
+    static type decode(type b) { return b; }
+};
+template <> struct KeyBits<uint64_t> {
+    typedef uint64_t type;
+    static type encode(type b) { return b; }
+    static type decode(type b) { return b; }
+};
+template <> struct KeyBits<int32_t> {
+    typedef uint32_t type;
+    static type encode(type b) { return b ^ 0x80000000u; }
+    static type decode(type b) { return b ^ 0x80000000u; }
+};
+template <> struct KeyBits<int64_t> {
+    typedef uint64_t type;
+    static type encode(type b) { return b ^ (1ull << 63); }
+    static type decode(type b) { return b ^ (1ull << 63); }
+};
+// negative floats get all bits inverted, positive ones the sign bit set
+template <> struct KeyBits<float> {
+    typedef uint32_t type;
+    static type encode(type b) {
+        return (b & 0x80000000u) ? ~b : b | 0x80000000u;
+    }
+    static type decode(type b) {
+        return (b & 0x80000000u) ? b & ~0x80000000u : ~b;
+    }
+};
+template <> struct KeyBits<double> {
+    typedef uint64_t type;
+    static type encode(type b) {
+        return (b & (1ull << 63)) ? ~b : b | (1ull << 63);
+    }
+    static type decode(type b) {
+        return (b & (1ull << 63)) ? b & ~(1ull << 63) : ~b;
+    }
+};
+
+// While sorting the key array holds the encoded bits, memcpy keeps these
+// accesses legal for floating point keys
+template <class Key>
+typename KeyBits<Key>::type loadBits(const Key* keys, int i) {
+    typename KeyBits<Key>::type bits;
+    memcpy(&bits, keys + i, sizeof(bits));
+    return bits;
+}
+
+template <class Key>
+void storeBits(Key* keys, int i, typename KeyBits<Key>::type bits) {
+    memcpy(keys + i, &bits, sizeof(bits));
+}
+
+template <class Key>
+void encodeKeys(Key* keys, int n) {
+#pragma omp parallel for
+    for (int i = 0; i < n; i++) {
+        storeBits(keys, i, KeyBits<Key>::encode(loadBits(keys, i)));
+    }
+}
+
+template <class Key>
+void decodeKeys(Key* keys, int n) {
+#pragma omp parallel for
+    for (int i = 0; i < n; i++) {
+        storeBits(keys, i, KeyBits<Key>::decode(loadBits(keys, i)));
+    }
+}
+
+const int kBase = 256;
+const int kMinChunk = 1 << 14;
+const int kInsertionCutoff = 32;
+const int kTaskCutoff = 1 << 14;
+
+// Stable LSD sort of encoded keys, byte digits. Every thread owns a
+// contiguous chunk, the per-thread histograms are combined digit-major so
+// that equal keys keep the order of the chunks and of the input
+template <class Key, class Payload>
+void lsdSort(Key* keys, Payload* payload, int n) {
+    typedef typename KeyBits<Key>::type Bits;
+    std::vector<Key> keyBuf(n);
+    std::vector<Payload> payloadBuf(n);
+    Key* srcKeys = keys;
+    Key* dstKeys = keyBuf.data();
+    Payload* srcPayload = payload;
+    Payload* dstPayload = payloadBuf.data();
+
+    int maxThreads = std::max(1, std::min(omp_get_max_threads(),
+        n / kMinChunk));
+    std::vector<int> counts(maxThreads * kBase);
+    int threads = 1;
+    bool skip = false;
+
+#pragma omp parallel num_threads(maxThreads)
+    {
+#pragma omp single
+        threads = omp_get_num_threads();
+
+        int id = omp_get_thread_num();
+        int begin = static_cast<int>(static_cast<int64_t>(n) * id / threads);
+        int end = static_cast<int>(
+            static_cast<int64_t>(n) * (id + 1) / threads);
+        int* cnt = counts.data() + id * kBase;
+
+        for (size_t pass = 0; pass < sizeof(Bits); pass++) {
+            int shift = static_cast<int>(8 * pass);
+            std::fill(cnt, cnt + kBase, 0);
+            for (int i = begin; i < end; i++) {
+                cnt[(loadBits(srcKeys, i) >> shift) & (kBase - 1)]++;
+            }
+#pragma omp barrier
+#pragma omp single
+            {
+                // a digit shared by every key would only copy the data
+                skip = false;
+                int pos = 0;
+                for (int d = 0; d < kBase; d++) {
+                    int digitTotal = 0;
+                    for (int t = 0; t < threads; t++) {
+                        int c = counts[t * kBase + d];
+                        counts[t * kBase + d] = pos;
+                        pos += c;
+                        digitTotal += c;
+                    }
+                    skip = skip || digitTotal == n;
+                }
+            }
+            if (!skip) {
+                for (int i = begin; i < end; i++) {
+                    Bits bits = loadBits(srcKeys, i);
+                    int to = cnt[(bits >> shift) & (kBase - 1)]++;
+                    storeBits(dstKeys, to, bits);
+                    dstPayload[to] = srcPayload[i];
+                }
+            }
+#pragma omp barrier
+#pragma omp single
+            {
+                if (!skip) {
+                    std::swap(srcKeys, dstKeys);
+                    std::swap(srcPayload, dstPayload);
+                }
+            }
+        }
+
+        if (srcKeys != keys) {
+            memcpy(keys + begin, srcKeys + begin,
+                (end - begin) * sizeof(Key));
+            memcpy(payload + begin, srcPayload + begin,
+                (end - begin) * sizeof(Payload));
+        }
+    }
+}
+
+template <class Key, class Payload>
+void insertionSort(Key* keys, Payload* payload, int n) {
+    typedef typename KeyBits<Key>::type Bits;
+    for (int i = 1; i < n; i++) {
+        Bits bits = loadBits(keys, i);
+        Payload value = payload[i];
+        int j = i;
+        for (; j > 0 && loadBits(keys, j - 1) > bits; j--) {
+            storeBits(keys, j, loadBits(keys, j - 1));
+            payload[j] = payload[j - 1];
+        }
+        storeBits(keys, j, bits);
+        payload[j] = value;
+    }
+}
+
+// Unstable in-place MSD sort (American flag): elements are cycled into
+// their buckets without any scratch buffer, large buckets are sorted by
+// OpenMP tasks. Must be called inside a parallel region
+template <class Key, class Payload>
+void msdSort(Key* keys, Payload* payload, int n, int shift) {
+    typedef typename KeyBits<Key>::type Bits;
+    if (n <= kInsertionCutoff) {
+        insertionSort(keys, payload, n);
+        return;
+    }
+
+    int count[kBase] = { 0 };
+    for (int i = 0; i < n; i++) {
+        count[(loadBits(keys, i) >> shift) & (kBase - 1)]++;
+    }
+    int head[kBase], tail[kBase];
+    int pos = 0;
+    for (int d = 0; d < kBase; d++) {
+        head[d] = pos;
+        pos += count[d];
+        tail[d] = pos;
+    }
+
+    for (int b = 0; b < kBase; b++) {
+        while (head[b] < tail[b]) {
+            Bits bits = loadBits(keys, head[b]);
+            Payload value = payload[head[b]];
+            int d = (bits >> shift) & (kBase - 1);
+            while (d != b) {
+                int to = head[d]++;
+                Bits nextBits = loadBits(keys, to);
+                Payload nextValue = payload[to];
+                storeBits(keys, to, bits);
+                payload[to] = value;
+                bits = nextBits;
+                value = nextValue;
+                d = (bits >> shift) & (kBase - 1);
+            }
+            storeBits(keys, head[b], bits);
+            payload[head[b]] = value;
+            head[b]++;
+        }
+    }
+
+    if (shift == 0) {
+        return;
+    }
+    for (int b = 0, begin = 0; b < kBase; begin += count[b], b++) {
+        if (count[b] < 2) {
+            continue;
+        }
+        Key* bucketKeys = keys + begin;
+        Payload* bucketPayload = payload + begin;
+        int size = count[b];
+        if (size > kTaskCutoff) {
+#pragma omp task firstprivate(bucketKeys, bucketPayload, size, shift)
+            msdSort(bucketKeys, bucketPayload, size, shift - 8);
+        } else {
+            msdSort(bucketKeys, bucketPayload, size, shift - 8);
+        }
+    }
+}
+
+}  // namespace radixkv
+
+// Sorts keys[0, n) and applies the same permutation to payload[0, n).
+// stable = true: parallel LSD passes, equal keys keep their input order,
+// needs n extra keys and payloads of scratch memory.
+// stable = false: in-place MSD sort, no scratch memory, equal keys may
+// be reordered
+template <class Key, class Payload>
+void radixSortPairs(Key* keys, Payload* payload, int n, bool stable = true) {
+    static_assert(sizeof(Payload) == 4 || sizeof(Payload) == 8,
+        "payload must be a 32- or 64-bit value");
+    if (n < 2) {
+        return;
+    }
+    radixkv::encodeKeys(keys, n);
+    if (stable) {
+        radixkv::lsdSort(keys, payload, n);
+    } else {
+        const int topShift = 8 * (sizeof(Key) - 1);
+#pragma omp parallel
+#pragma omp single
+        radixkv::msdSort(keys, payload, n, topShift);
+    }
+    radixkv::decodeKeys(keys, n);
+}
+
+// Indices that sort keys (argsort); keys themselves are not modified
+template <class Key>
+std::vector<uint32_t> radixArgsort(const Key* keys, int n,
+    bool stable = true) {
+    std::vector<Key> sortedKeys(keys, keys + n);
+    std::vector<uint32_t> index(n);
+    for (int i = 0; i < n; i++) {
+        index[i] = static_cast<uint32_t>(i);
+    }
+    radixSortPairs(sortedKeys.data(), index.data(), n, stable);
+    return index;
+}
+
+#endif  // MODULES_TASK_2_DENISOVA_RADIX_SORT_OMP_RADIX_SORT_KV_H_
@@ -1,6 +1,8 @@
 // Copyright 2022 Kovalev Ruslan
 #include <omp.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <utility>
 #include <random>
@@ -154,3 +156,64 @@ std::vector<int> getParallelSort(const std::vector<int>& commonVector) {
   }
   return resultVector;
 }
+
+std::vector<int> getBlockOddEvenSort(const std::vector<int>& commonVector,
+                                     int numberOfThread,
+                                     int* barrierCount, int* teamSize) {
+  std::vector<int> res(commonVector);
+  int n = res.size();
+  if (numberOfThread <= 0) numberOfThread = omp_get_num_procs();
+  numberOfThread = std::max(1, std::min(numberOfThread, n));
+  int barriers = 0, team = 1;
+
+#pragma omp parallel num_threads(numberOfThread)
+  {
+    int p = omp_get_num_threads();
+    int id = omp_get_thread_num();
+    auto blockBegin = [n, p](int b) {
+      return static_cast<int>(static_cast<int64_t>(n) * b / p);
+    };
+    int* a = res.data();
+    int begin = blockBegin(id), end = blockBegin(id + 1);
+    std::vector<int> scratch(end - begin);
+
+    std::sort(a + begin, a + end);
+#pragma omp barrier
+#pragma omp master
+    {
+      barriers++;
+      team = p;
+    }
+
+    for (int phase = 0; phase < p; phase++) {
+      // even phases pair blocks (0, 1), (2, 3), ..., odd ones (1, 2), ...
+      bool isLeft = id % 2 == phase % 2;
+      int partner = isLeft ? id + 1 : id - 1;
+      bool exchange = partner >= 0 && partner < p;
+      if (exchange) {
+        int border = isLeft ? end : begin;
+        exchange = a[border - 1] > a[border];
+      }
+      if (exchange && isLeft) {
+        // the smallest end - begin keys of both blocks, merged forwards
+        int i = begin, j = end, last = blockBegin(partner + 1);
+        for (int k = 0; k < end - begin; k++)
+          scratch[k] = (j == last || a[i] <= a[j]) ? a[i++] : a[j++];
+      } else if (exchange) {
+        // the largest end - begin keys of both blocks, merged backwards
+        int i = begin - 1, j = end - 1, first = blockBegin(partner);
+        for (int k = end - begin - 1; k >= 0; k--)
+          scratch[k] = (i < first || a[j] >= a[i]) ? a[j--] : a[i--];
+      }
+#pragma omp barrier
+      if (exchange) std::copy(scratch.begin(), scratch.end(), a + begin);
+#pragma omp barrier
+#pragma omp master
+      barriers += 2;
+    }
+  }
+
+  if (barrierCount != nullptr) *barrierCount = barriers;
+  if (teamSize != nullptr) *teamSize = team;
+  return res;
+}
@@ -12,4 +12,18 @@ void copy_vectors(std::vector<int>* arr_1, std::vector<int>* arr_2, int sz);
 void getSequantialSort(std::vector<int>* arr, int sz);
 std::vector<int> getParallelSort(const std::vector<int>& commonVector);
 
+// Block odd-even transposition sort: every thread sorts its own block,
+// then p phases of merge-split exchanges with the neighbour block follow
+// (the left block keeps the smaller half, the right one the larger).
+// Two barriers per phase, 2p + 1 in total instead of one per element
+// phase. p is the team OpenMP grants, which may be smaller than asked
+// for. The blocks are n / p keys rather than cache-sized: b blocks take b
+// phases, each a pass over the whole array, so more blocks than threads
+// would only add passes. numberOfThread <= 0 uses all cores; barrierCount
+// and teamSize (optional) receive the number of barriers passed and p
+std::vector<int> getBlockOddEvenSort(const std::vector<int>& commonVector,
+                                     int numberOfThread = 0,
+                                     int* barrierCount = nullptr,
+                                     int* teamSize = nullptr);
+
 #endif  // MODULES_TASK_2_KOVALEV_R_ODD_EVEN_SORT_OMP_KOVALEV_R_ODD_EVEN_SORT_OMP_H_
@@ -1,7 +1,11 @@
 // Copyright 2022 Kovalev Ruslan
 #include <gtest/gtest.h>
 
+#include <omp.h>
+
+#include <algorithm>
 #include <ctime>
+#include <random>
 #include <vector>
 
 #include "./kovalev_r_odd_even_sort_omp.h"
@@ -71,6 +75,58 @@ TEST(Sequential_algorithm, radix_sort_5) {
   ASSERT_EQ(true, res);
 }
 
+TEST(Block_algorithm, odd_even_block_sort_any_thread_count) {
+  std::mt19937 gen(7);
+  for (int size : {1, 2, 17, 1001, 20000}) {
+    std::vector<int> arr(size);
+    for (int& x : arr) x = static_cast<int>(gen() % 2001) - 1000;
+    std::vector<int> expected(arr);
+    std::sort(expected.begin(), expected.end());
+    for (int threads : {1, 2, 3, 8, 64}) {
+      int barriers = 0, team = 0;
+      std::vector<int> res = getBlockOddEvenSort(arr, threads, &barriers,
+                                                 &team);
+      ASSERT_TRUE(std::is_sorted(res.begin(), res.end()));
+      ASSERT_EQ(expected, res);
+      // OpenMP may grant fewer threads than asked for
+      ASSERT_GE(team, 1);
+      ASSERT_LE(team, std::min(threads, size));
+      ASSERT_EQ(2 * team + 1, barriers);
+    }
+  }
+}
+
+TEST(Block_algorithm, odd_even_block_sort_reversed) {
+  int size = 100000;
+  std::vector<int> arr(size);
+  for (int i = 0; i < size; i++) arr[i] = size - i;
+  std::vector<int> res = getBlockOddEvenSort(arr, 16);
+  ASSERT_TRUE(std::is_sorted(res.begin(), res.end()));
+}
+
+TEST(Block_algorithm, odd_even_block_sort_scaling) {
+  int size = 2000000;
+  std::vector<int> arr(size);
+  vec_gen(&arr, size);
+  std::vector<int> expected(arr);
+  std::sort(expected.begin(), expected.end());
+
+  double start = omp_get_wtime();
+  std::vector<int> batcher = getParallelSort(arr);
+  std::cout << "getParallelSort: " << omp_get_wtime() - start << " s"
+            << std::endl;
+  ASSERT_EQ(expected, batcher);
+  for (int threads = 2; threads <= 64; threads *= 2) {
+    int barriers = 0;
+    start = omp_get_wtime();
+    std::vector<int> res = getBlockOddEvenSort(arr, threads, &barriers);
+    double time = omp_get_wtime() - start;
+    std::cout << threads << " threads: " << barriers << " barriers, "
+              << time << " s" << std::endl;
+    ASSERT_EQ(expected, res);
+  }
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
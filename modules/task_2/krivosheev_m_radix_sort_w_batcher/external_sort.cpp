@@ -0,0 +1,299 @@
+// Copyright 2022 Krivosheev Miron
+
+#include <omp.h>
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../../../modules/task_2/krivosheev_m_radix_sort_w_batcher/external_sort.h"
+
+namespace {
+
+const int kRadix = 256;
+
+// byte of x at shift, with the sign bit flipped so negatives go first
+inline int digitOf(int x, int shift) {
+  return ((static_cast<uint32_t>(x) ^ 0x80000000u) >> shift) & (kRadix - 1);
+}
+
+FilePtr openFile(const std::string& path, const char* mode) {
+  FilePtr file(std::fopen(path.c_str(), mode), &std::fclose);
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  return file;
+}
+
+// closes a written file, a failed flush is a write error
+void closeFile(FilePtr* file) {
+  if (std::fclose(file->release()) != 0) {
+    throw std::runtime_error("Write error");
+  }
+}
+
+void writeKeys(FILE* file, const int* keys, size_t n) {
+  if (std::fwrite(keys, sizeof(int), n, file) != n) {
+    throw std::runtime_error("Write error");
+  }
+}
+
+// The run files of one call, removed when it returns or throws
+class RunFiles {
+ public:
+  explicit RunFiles(const std::string& tmpDir) : prefix_(tmpDir) {
+    // the pid tells processes apart, the counter calls of one process
+    static std::atomic<unsigned> calls(0);
+#if defined(_WIN32)
+    int pid = _getpid();
+#else
+    int pid = static_cast<int>(getpid());
+#endif
+    prefix_ += "/ext_sort_" + std::to_string(pid) + "_" +
+               std::to_string(calls++) + "_run_";
+  }
+  ~RunFiles() {
+    for (const std::string& path : paths_) {
+      std::remove(path.c_str());
+    }
+  }
+  RunFiles(const RunFiles&) = delete;
+  RunFiles& operator=(const RunFiles&) = delete;
+
+  const std::vector<std::string>& paths() const { return paths_; }
+  const std::string& add() {
+    paths_.push_back(prefix_ + std::to_string(paths_.size()) + ".bin");
+    return paths_.back();
+  }
+
+ private:
+  std::string prefix_;
+  std::vector<std::string> paths_;
+};
+
+double megabytes(int64_t keys) {
+  return static_cast<double>(keys) * sizeof(int) / (1024.0 * 1024.0);
+}
+
+}  // namespace
+
+double ExternalSortStats::runMBps() const {
+  return runSeconds > 0 ? megabytes(keys) / runSeconds : 0;
+}
+
+double ExternalSortStats::mergeMBps() const {
+  return mergeSeconds > 0 ? megabytes(keys) / mergeSeconds : 0;
+}
+
+void radixSortRun(int* data, int* buf, int64_t n) {
+  int threads = omp_get_max_threads();
+  std::vector<int64_t> count(threads * kRadix);
+  int* src = data;
+  int* dst = buf;
+  bool skip = false;
+
+#pragma omp parallel num_threads(threads)
+  {
+    int id = omp_get_thread_num();
+    int64_t begin = n * id / threads;
+    int64_t end = n * (id + 1) / threads;
+    int64_t* cnt = count.data() + id * kRadix;
+
+    for (int shift = 0; shift < 32; shift += 8) {
+      std::fill(cnt, cnt + kRadix, 0);
+      for (int64_t i = begin; i < end; i++) {
+        cnt[digitOf(src[i], shift)]++;
+      }
+#pragma omp barrier
+#pragma omp single
+      {
+        // digit-major prefix sum: thread t writes its keys of digit d
+        // after the keys of digit d from threads 0..t-1, which keeps
+        // every pass stable
+        skip = false;
+        int64_t pos = 0;
+        for (int d = 0; d < kRadix; d++) {
+          int64_t total = 0;
+          for (int t = 0; t < threads; t++) {
+            int64_t c = count[t * kRadix + d];
+            count[t * kRadix + d] = pos;
+            pos += c;
+            total += c;
+          }
+          skip = skip || total == n;
+        }
+      }
+      if (!skip) {
+        for (int64_t i = begin; i < end; i++) {
+          dst[cnt[digitOf(src[i], shift)]++] = src[i];
+        }
+      }
+#pragma omp barrier
+#pragma omp single
+      {
+        if (!skip) {
+          std::swap(src, dst);
+        }
+      }
+    }
+
+    if (src != data) {
+      std::copy(src + begin, src + end, data + begin);
+    }
+  }
+}
+
+RunReader::RunReader(const std::string& path, int bufferKeys)
+    : file_(openFile(path, "rb")), front_(bufferKeys), back_(bufferKeys),
+      pos_(0), size_(0), done_(false) {
+  startRead();
+  refill();
+}
+
+RunReader::~RunReader() {
+  if (pending_.valid()) {
+    pending_.wait();
+  }
+}
+
+void RunReader::startRead() {
+  FILE* file = file_.get();
+  int* to = back_.data();
+  size_t n = back_.size();
+  pending_ = std::async(std::launch::async, [file, to, n] {
+    return std::fread(to, sizeof(int), n, file);
+  });
+}
+
+void RunReader::refill() {
+  size_ = pending_.get();
+  pos_ = 0;
+  std::swap(front_, back_);
+  if (size_ == 0) {
+    done_ = true;
+    return;
+  }
+  startRead();
+}
+
+LoserTree::LoserTree(const std::vector<RunReader*>& runs)
+    : runs_(runs), keys_(runs.size()), tree_(runs.size()),
+      k_(static_cast<int>(runs.size())) {
+  if (k_ == 0) {
+    throw std::invalid_argument("No runs to merge");
+  }
+  for (int i = 0; i < k_; i++) {
+    keys_[i] = headKey(i);
+  }
+  tree_[0] = build(1);
+}
+
+// nodes 1..k-1 are internal, node k + i is the leaf of run i
+int LoserTree::build(int node) {
+  if (node >= k_) {
+    return node - k_;
+  }
+  int left = build(2 * node);
+  int right = build(2 * node + 1);
+  if (less(left, right)) {
+    tree_[node] = right;
+    return left;
+  }
+  tree_[node] = left;
+  return right;
+}
+
+void LoserTree::pop() {
+  int winner = tree_[0];
+  runs_[winner]->next();
+  keys_[winner] = headKey(winner);
+  for (int node = (winner + k_) / 2; node > 0; node /= 2) {
+    if (less(tree_[node], winner)) {
+      std::swap(tree_[node], winner);
+    }
+  }
+  tree_[0] = winner;
+}
+
+ExternalSortStats externalSort(const std::string& input,
+                               const std::string& output, int64_t runKeys,
+                               const std::string& tmpDir, int bufferKeys) {
+  if (runKeys < 1 || bufferKeys < 1) {
+    throw std::invalid_argument("Run and buffer sizes must be positive");
+  }
+  ExternalSortStats stats = { 0, 0, 0, 0 };
+  RunFiles runFiles(tmpDir);
+
+  // <Run formation>
+  double start = omp_get_wtime();
+  {
+    FilePtr in = openFile(input, "rb");
+    std::vector<int> keys(runKeys), scratch(runKeys);
+    size_t n;
+    while ((n = std::fread(keys.data(), sizeof(int), keys.size(),
+                           in.get())) > 0) {
+      radixSortRun(keys.data(), scratch.data(), n);
+      FilePtr run = openFile(runFiles.add(), "wb");
+      writeKeys(run.get(), keys.data(), n);
+      closeFile(&run);
+      stats.keys += n;
+    }
+  }
+  stats.runs = static_cast<int>(runFiles.paths().size());
+  stats.runSeconds = omp_get_wtime() - start;
+  // </Run formation>
+
+  // <Merge>
+  start = omp_get_wtime();
+  FilePtr out = openFile(output, "wb");
+  if (stats.runs > 0) {
+    std::vector<std::unique_ptr<RunReader>> readers;
+    std::vector<RunReader*> runs;
+    for (const std::string& path : runFiles.paths()) {
+      readers.emplace_back(new RunReader(path, bufferKeys));
+      runs.push_back(readers.back().get());
+    }
+    LoserTree tree(runs);
+
+    // the full buffer is written in the background while the other one
+    // is being filled; on a throw the future waits for the write before
+    // out is closed
+    std::vector<int> fill(bufferKeys), flush(bufferKeys);
+    std::future<void> writing;
+    FILE* to = out.get();
+    size_t used = 0;
+    while (!tree.done()) {
+      fill[used++] = tree.top();
+      tree.pop();
+      if (used == fill.size()) {
+        if (writing.valid()) {
+          writing.get();
+        }
+        std::swap(fill, flush);
+        const int* from = flush.data();
+        writing = std::async(std::launch::async, [to, from, used] {
+          writeKeys(to, from, used);
+        });
+        used = 0;
+      }
+    }
+    if (writing.valid()) {
+      writing.get();
+    }
+    writeKeys(to, fill.data(), used);
+  }
+  closeFile(&out);
+  stats.mergeSeconds = omp_get_wtime() - start;
+  // </Merge>
+
+  return stats;
+}
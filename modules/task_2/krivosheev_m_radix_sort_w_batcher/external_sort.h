@@ -0,0 +1,101 @@
+// Copyright 2022 Krivosheev Miron
+#ifndef MODULES_TASK_2_KRIVOSHEEV_M_RADIX_SORT_W_BATCHER_EXTERNAL_SORT_H_
+#define MODULES_TASK_2_KRIVOSHEEV_M_RADIX_SORT_W_BATCHER_EXTERNAL_SORT_H_
+#include <stdint.h>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef std::unique_ptr<FILE, int (*)(FILE*)> FilePtr;
+
+// Out-of-core sort of a binary file of native-endian int keys, for data
+// that does not fit in memory. The input is cut into runs of runKeys
+// keys, every run is radix sorted in memory and written to a temporary
+// file in tmpDir, then all runs are merged with a loser tree. The run
+// files are named after the process and the call, so concurrent sorts
+// may share tmpDir, and are removed on return and on a throw.
+// Memory used: 8 * runKeys bytes while forming runs (keys + scratch),
+// about 8 * bufferKeys bytes per run while merging.
+struct ExternalSortStats {
+  int64_t keys;
+  int runs;
+  double runSeconds;    // read + sort + write of all runs
+  double mergeSeconds;  // k-way merge into the output file
+
+  double runMBps() const;
+  double mergeMBps() const;
+};
+
+ExternalSortStats externalSort(const std::string& input,
+                               const std::string& output, int64_t runKeys,
+                               const std::string& tmpDir = ".",
+                               int bufferKeys = 1 << 18);
+
+// Parallel LSD radix sort of data[0, n) by bytes, negative keys included.
+// buf must hold n keys
+void radixSortRun(int* data, int* buf, int64_t n);
+
+// Sequential reader of a sorted run. Two buffers are used: while the
+// merge consumes one of them the next block is read into the other one
+// in the background
+class RunReader {
+ public:
+  RunReader(const std::string& path, int bufferKeys);
+  ~RunReader();
+  RunReader(const RunReader&) = delete;
+  RunReader& operator=(const RunReader&) = delete;
+
+  bool done() const { return done_; }
+  int key() const { return front_[pos_]; }
+  void next() {
+    if (++pos_ == size_) {
+      refill();
+    }
+  }
+
+ private:
+  void startRead();
+  // waits for the background read and swaps the buffers
+  void refill();
+
+  FilePtr file_;
+  std::vector<int> front_, back_;
+  size_t pos_, size_;
+  std::future<size_t> pending_;
+  bool done_;
+};
+
+// Tournament tree of losers over k runs: the winner (smallest key) is
+// kept at the root, replacing it costs log2(k) comparisons along one
+// path, against 2 log2(k) for a binary heap
+class LoserTree {
+ public:
+  explicit LoserTree(const std::vector<RunReader*>& runs);
+
+  bool done() const { return keys_[tree_[0]] == kDone; }
+  int top() const { return static_cast<int>(keys_[tree_[0]]); }
+  // consumes the smallest key and replays its run up to the root
+  void pop();
+
+ private:
+  // head keys are cached here, a finished run gets kDone which is
+  // greater than any int key
+  static const int64_t kDone = INT64_MAX;
+
+  bool less(int a, int b) const {
+    return keys_[a] < keys_[b] || (keys_[a] == keys_[b] && a < b);
+  }
+  int64_t headKey(int run) const {
+    return runs_[run]->done() ? kDone : runs_[run]->key();
+  }
+  int build(int node);
+
+  std::vector<RunReader*> runs_;
+  std::vector<int64_t> keys_;
+  std::vector<int> tree_;
+  int k_;
+};
+
+#endif  // MODULES_TASK_2_KRIVOSHEEV_M_RADIX_SORT_W_BATCHER_EXTERNAL_SORT_H_
@@ -1,8 +1,42 @@
 // Copyright 2022 Krivosheev Miron
 
 #include <gtest/gtest.h>
+#include <omp.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT [build/c++11]
 #include <vector>
 #include "./batcher.h"
+#include "./external_sort.h"
+
+static void writeKeyFile(const std::string& path,
+  const std::vector<int>& keys) {
+  FILE* file = std::fopen(path.c_str(), "wb");
+  std::fwrite(keys.data(), sizeof(int), keys.size(), file);
+  std::fclose(file);
+}
+
+static std::vector<int> readKeyFile(const std::string& path) {
+  std::vector<int> keys;
+  FILE* file = std::fopen(path.c_str(), "rb");
+  int key;
+  while (std::fread(&key, sizeof(int), 1, file) == 1) {
+    keys.push_back(key);
+  }
+  std::fclose(file);
+  return keys;
+}
+
+static std::vector<int> getRandFullRange(int size) {
+  std::mt19937 gen(size);
+  std::vector<int> vec(size);
+  for (int i = 0; i < size; i++) {
+    vec[i] = static_cast<int>(gen());
+  }
+  return vec;
+}
 
 TEST(Radix_Sort_W_Batcher, Test_CorrectSort) {
   std::vector<int> vec = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
@@ -53,3 +87,90 @@ TEST(Radix_Sort_W_Batcher, Test_RadixSort_w_Batcher) {
     part2.end(), stl_mege.begin());
   ASSERT_EQ(stl_mege, res);
 }
+
+TEST(Radix_Sort_W_Batcher, Test_RadixSortRun_Negative) {
+  std::vector<int> vec = getRandFullRange(100000);
+  std::vector<int> buf(vec.size());
+  std::vector<int> expected(vec);
+  std::sort(expected.begin(), expected.end());
+  radixSortRun(vec.data(), buf.data(), vec.size());
+  ASSERT_EQ(expected, vec);
+}
+
+TEST(Radix_Sort_W_Batcher, Test_ExternalSort_ManyRuns) {
+  std::vector<int> vec = getRandFullRange(100003);
+  for (int i = 0; i < 1000; i++) {
+    vec[i * 100] = 42;
+  }
+  writeKeyFile("ext_sort_in.bin", vec);
+  // 101 runs, the last one shorter, and tiny read buffers
+  ExternalSortStats stats = externalSort("ext_sort_in.bin",
+    "ext_sort_out.bin", 1000, ".", 64);
+  std::vector<int> res = readKeyFile("ext_sort_out.bin");
+  std::remove("ext_sort_in.bin");
+  std::remove("ext_sort_out.bin");
+
+  std::sort(vec.begin(), vec.end());
+  ASSERT_EQ(101, stats.runs);
+  ASSERT_EQ(100003, stats.keys);
+  ASSERT_EQ(vec, res);
+}
+
+TEST(Radix_Sort_W_Batcher, Test_ExternalSort_SingleRunAndEmpty) {
+  std::vector<int> vec = GetRandVector(777);
+  writeKeyFile("ext_sort_in.bin", vec);
+  ExternalSortStats stats = externalSort("ext_sort_in.bin",
+    "ext_sort_out.bin", 1 << 20);
+  std::vector<int> res = readKeyFile("ext_sort_out.bin");
+  std::sort(vec.begin(), vec.end());
+  ASSERT_EQ(1, stats.runs);
+  ASSERT_EQ(vec, res);
+
+  writeKeyFile("ext_sort_in.bin", std::vector<int>());
+  stats = externalSort("ext_sort_in.bin", "ext_sort_out.bin", 100);
+  res = readKeyFile("ext_sort_out.bin");
+  std::remove("ext_sort_in.bin");
+  std::remove("ext_sort_out.bin");
+  ASSERT_EQ(0, stats.runs);
+  ASSERT_TRUE(res.empty());
+}
+
+TEST(Radix_Sort_W_Batcher, Test_ExternalSort_ConcurrentCallsShareTmpDir) {
+  std::vector<int> first = getRandFullRange(5001);
+  std::vector<int> second = getRandFullRange(7002);
+  writeKeyFile("ext_sort_in_1.bin", first);
+  writeKeyFile("ext_sort_in_2.bin", second);
+  // both calls write runs 0, 1, ... into the same directory at once
+  std::thread other([] {
+    externalSort("ext_sort_in_2.bin", "ext_sort_out_2.bin", 500, ".", 64);
+  });
+  externalSort("ext_sort_in_1.bin", "ext_sort_out_1.bin", 500, ".", 64);
+  other.join();
+  std::vector<int> res1 = readKeyFile("ext_sort_out_1.bin");
+  std::vector<int> res2 = readKeyFile("ext_sort_out_2.bin");
+  for (const char* path : { "ext_sort_in_1.bin", "ext_sort_in_2.bin",
+                            "ext_sort_out_1.bin", "ext_sort_out_2.bin" }) {
+    std::remove(path);
+  }
+
+  std::sort(first.begin(), first.end());
+  std::sort(second.begin(), second.end());
+  ASSERT_EQ(first, res1);
+  ASSERT_EQ(second, res2);
+}
+
+TEST(Radix_Sort_W_Batcher, Test_ExternalSort_Throughput) {
+  int size = 1 << 23;  // 32 MB of keys in 8 runs
+  writeKeyFile("ext_sort_in.bin", getRandFullRange(size));
+  ExternalSortStats stats = externalSort("ext_sort_in.bin",
+    "ext_sort_out.bin", size / 8);
+  std::vector<int> res = readKeyFile("ext_sort_out.bin");
+  std::remove("ext_sort_in.bin");
+  std::remove("ext_sort_out.bin");
+
+  std::cout << "Runs: " << stats.runs << ", run formation "
+    << stats.runMBps() << " MB/s, merge " << stats.mergeMBps()
+    << " MB/s" << std::endl;
+  ASSERT_EQ(size, static_cast<int>(res.size()));
+  ASSERT_TRUE(std::is_sorted(res.begin(), res.end()));
+}
@@ -4,8 +4,9 @@
 #include <random>
 #include <algorithm>
 #include <iostream>
-#include <list>
+#include <cstdint>
 #include "../../task_2/kulemin_p_discharge_double_sort_omp/kulemin_p_discharge_double_sort_omp.h"
+#include "../../../3rdparty/unapproved/double_keys.h"
 
 vector* create_random_vector(int size_n) {
     std::random_device dev;
@@ -16,40 +17,125 @@ vector* create_random_vector(int size_n) {
     }
     return in;
 }
-void union_from_lists(std::list<double> *lists, vector* v) {
-    int j = v->last_el;
-    while (!lists->empty()) {
-        v->ptr[j] = ((*lists).front());
-        (*lists).pop_front();
-        j++;
+namespace {
+using dkeys::kDigitMask;
+using dkeys::kDigitSize;
+using dkeys::load_key;
+using dkeys::store_key;
+}  // namespace
+
+void double_radix_sort(double* data, int size, double* scratch) {
+    if (size < 2)
+        return;
+    std::vector<double> own_scratch;
+    if (scratch == nullptr) {
+        own_scratch.resize(size);
+        scratch = own_scratch.data();
     }
-    v->last_el = j;
+    dkeys::sort(data, size, scratch);
 }
 
-void discharge_sort(vector* v) {
-    std::vector< std::vector<std::list<double >>> lists(omp_get_max_threads());
-    for (size_t j = 0; j < sizeof(double); j++) {
-        #pragma omp parallel
+void double_radix_sort_omp(double* data, int size) {
+    int nthreads = std::min(omp_get_max_threads(),
+                            size / static_cast<int>(kDigitSize) + 1);
+    if (nthreads == 1) {
+        double_radix_sort(data, size);
+        return;
+    }
+
+    // The runtime may give the region fewer threads than requested, the
+    // per-thread arrays are sized by the team that actually runs
+    std::vector<double> scratch(size);
+    std::vector<uint64_t> local_min, local_max;
+    std::vector<size_t> offsets;
+    std::vector<size_t> bucket_begin(kDigitSize + 1);
+    std::vector<int> first_bucket;
+    int shift = 0;
+
+    #pragma omp parallel num_threads(nthreads)
+    {
+        const int team = omp_get_num_threads();
+        #pragma omp single
         {
-            lists[omp_get_thread_num()].resize(256);
-            #pragma omp for
-            for (int i = 0; i < v->size; i++) {
-                unsigned char* pt = (unsigned char*)(v->ptr + i);
-                lists[omp_get_thread_num()][*(pt + j)].push_back(v->ptr[i]);
-            }
-            #pragma omp single
-            {
-                for (int t = 0; t < 256; t++) {
-                    for (int k = 0; k < omp_get_num_threads(); k++) {
-                        union_from_lists(&lists[k][t], v);
-                    }
+            local_min.assign(team, ~0ull);
+            local_max.assign(team, 0);
+            offsets.assign(team * kDigitSize, 0);
+            first_bucket.assign(team + 1, kDigitSize);
+        }
+
+        int t = omp_get_thread_num();
+        int begin = static_cast<int>(static_cast<int64_t>(size) * t / team);
+        int end = static_cast<int>(static_cast<int64_t>(size) * (t + 1) / team);
+
+        for (int i = begin; i < end; i++) {
+            uint64_t key = dkeys::to_key(load_key(data, i));
+            store_key(data, i, key);
+            local_min[t] = std::min(local_min[t], key);
+            local_max[t] = std::max(local_max[t], key);
+        }
+        #pragma omp barrier
+
+        #pragma omp single
+        shift = dkeys::top_digit_shift(
+            *std::min_element(local_min.begin(), local_min.end()),
+            *std::max_element(local_max.begin(), local_max.end()));
+
+        size_t* cursor = offsets.data() + t * kDigitSize;
+        for (int i = begin; i < end; i++)
+            cursor[(load_key(data, i) >> shift) & kDigitMask]++;
+        #pragma omp barrier
+
+        #pragma omp single
+        {
+            size_t offset = 0;
+            for (int d = 0; d < kDigitSize; d++) {
+                bucket_begin[d] = offset;
+                for (int k = 0; k < team; k++) {
+                    size_t tmp_count = offsets[k * kDigitSize + d];
+                    offsets[k * kDigitSize + d] = offset;
+                    offset += tmp_count;
                 }
-                v->last_el = 0;
             }
+            bucket_begin[kDigitSize] = offset;
+
+            // Each thread takes a contiguous range of buckets holding
+            // about size / team keys
+            first_bucket[0] = 0;
+            for (int k = 1, d = 0; k < team; k++) {
+                size_t target = static_cast<size_t>(size) * k / team;
+                while (d < kDigitSize && bucket_begin[d + 1] <= target)
+                    d++;
+                first_bucket[k] = d;
+            }
+        }
+
+        for (int i = begin; i < end; i++) {
+            uint64_t key = load_key(data, i);
+            store_key(scratch.data(), cursor[(key >> shift) & kDigitMask]++,
+                      key);
+        }
+        #pragma omp barrier
+
+        std::vector<size_t> count(dkeys::kMaxPasses * kDigitSize);
+        for (int d = first_bucket[t]; d < first_bucket[t + 1]; d++) {
+            size_t bucket = bucket_begin[d];
+            size_t n = bucket_begin[d + 1] - bucket;
+            if (n == 0)
+                continue;
+            double* sorted = dkeys::lsd_sort_keys(scratch.data() + bucket,
+                                                  data + bucket, n, shift,
+                                                  count.data());
+            for (size_t i = 0; i < n; i++)
+                store_key(data, bucket + i,
+                          dkeys::from_key(load_key(sorted, i)));
         }
     }
 }
 
+void discharge_sort(vector* v) {
+    double_radix_sort_omp(v->ptr, v->size);
+}
+
 bool check_vectors(double* st, double* sd, int size) {
     bool res = true;
     for (int i = 0; i < size; i++) {
@@ -1,6 +1,11 @@
 // Copyright 2018 Nesterov Alexander
 #include <gtest/gtest.h>
+#include <omp.h>
 #include <vector>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <cmath>
 #include "./kulemin_p_discharge_double_sort_omp.h"
 
 TEST(Parallel_Operations_OpenMP, Test_No_Throw) {
@@ -51,6 +56,63 @@ TEST(Parallel_Operations_OpenMP, Test_200) {
     bool res = check_vectors(vb->ptr, sd->ptr, count);
     ASSERT_EQ(true, res);
 }
+TEST(Parallel_Operations_OpenMP, Test_Special_Values) {
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> data = {std::nan(""), 3.5, -inf, 0.0, -1e-300,
+        inf, -0.0, -7.25, 1e300, 0.0, -0.0};
+    double_radix_sort(data.data(), static_cast<int>(data.size()));
+    std::vector<double> expected = {-inf, -7.25, -1e-300, -0.0, -0.0,
+        0.0, 0.0, 3.5, 1e300, inf};
+    ASSERT_TRUE(std::isnan(data.back()));
+    ASSERT_EQ(expected, std::vector<double>(data.begin(), data.end() - 1));
+    ASSERT_TRUE(std::signbit(data[3]) && std::signbit(data[4]));
+    ASSERT_FALSE(std::signbit(data[5]) || std::signbit(data[6]));
+}
+TEST(Parallel_Operations_OpenMP, Test_Negative_Parallel) {
+    int count = 100000;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1e6, 1e6);
+    std::vector<double> data(count);
+    for (double& val : data) val = dist(gen);
+    std::vector<double> expected = data;
+    std::sort(expected.begin(), expected.end());
+    double_radix_sort_omp(data.data(), count);
+    ASSERT_EQ(expected, data);
+}
+TEST(Parallel_Operations_OpenMP, Test_Narrow_Range_Parallel) {
+    int count = 50000;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> dist(1.0, 2.0);
+    std::vector<double> data(count);
+    for (double& val : data) val = dist(gen);
+    data[100] = data[200];
+    std::vector<double> expected = data;
+    std::sort(expected.begin(), expected.end());
+    double_radix_sort_omp(data.data(), count);
+    ASSERT_EQ(expected, data);
+}
+TEST(Parallel_Operations_OpenMP, Test_Smaller_Team_Than_Requested) {
+    // a nested region runs on one thread whatever num_threads asks for
+    int count = 20000;
+    std::vector<std::vector<double>> data(2, std::vector<double>(count));
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dist(-1e3, 1e3);
+    for (auto& vec : data)
+        for (double& val : vec) val = dist(gen);
+    std::vector<std::vector<double>> expected = data;
+    for (auto& vec : expected) std::sort(vec.begin(), vec.end());
+
+    int old_threads = omp_get_max_threads();
+    int old_levels = omp_get_max_active_levels();
+    omp_set_num_threads(4);
+    omp_set_max_active_levels(1);
+    #pragma omp parallel for num_threads(2)
+    for (int k = 0; k < 2; k++)
+        double_radix_sort_omp(data[k].data(), count);
+    omp_set_max_active_levels(old_levels);
+    omp_set_num_threads(old_threads);
+    ASSERT_EQ(expected, data);
+}
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,302 @@
+// Copyright 2022 Remizova Antonina
+#include "../../../modules/task_2/remizova_a_hoar_batcher/hoar_select.h"
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include "../../../modules/task_2/remizova_a_hoar_batcher/hoar_batcher.h"
+
+namespace {
+// ranges shorter than this are handled by one thread
+const int kSequentialCutoff = 1 << 16;
+const int kMinChunk = 1 << 15;
+const int kSampleSize = 4096;
+// distance in the sorted sample between the target and its splitters,
+// about three standard deviations of the target's position
+const int kSampleGap = 96;
+
+struct lessThan {
+    double pvt;
+    bool operator()(double x) const { return x < pvt; }
+};
+
+struct notGreaterThan {
+    double pvt;
+    bool operator()(double x) const { return x <= pvt; }
+};
+
+// Hoare partition of a[l, r) by a predicate, returns the border
+template <class Pred>
+int hoarPartition(double* a, int l, int r, Pred pred) {
+    r--;
+    while (true) {
+        while (l <= r && pred(a[l]))
+            l++;
+        while (l <= r && !pred(a[r]))
+            r--;
+        if (l > r)
+            return l;
+        std::swap(a[l], a[r]);
+        l++;
+        r--;
+    }
+}
+
+// Every chunk is partitioned by its own thread, then the elements left on
+// the wrong side of the global border are swapped pairwise in parallel
+template <class Pred>
+int partitionChunks(double* a, int left, int right, Pred pred) {
+    int n = right - left;
+    int threads = std::max(1, std::min(omp_get_max_threads(),
+                                       n / kMinChunk));
+    if (threads == 1)
+        return hoarPartition(a, left, right, pred);
+
+    std::vector<int> begin(threads + 1), split(threads);
+    for (int t = 0; t <= threads; t++)
+        begin[t] = left + static_cast<int>(static_cast<int64_t>(n) * t /
+                                           threads);
+#pragma omp parallel for num_threads(threads)
+    for (int t = 0; t < threads; t++)
+        split[t] = hoarPartition(a, begin[t], begin[t + 1], pred);
+
+    int m = left;
+    for (int t = 0; t < threads; t++)
+        m += split[t] - begin[t];
+
+    // wrong elements before m and after m, as lists of intervals
+    std::vector<std::pair<int, int>> high, low;
+    std::vector<int64_t> highAt(1, 0), lowAt(1, 0);
+    for (int t = 0; t < threads; t++) {
+        int highEnd = std::min(begin[t + 1], m);
+        if (split[t] < highEnd) {
+            high.push_back(std::make_pair(split[t], highEnd));
+            highAt.push_back(highAt.back() + highEnd - split[t]);
+        }
+        int lowBegin = std::max(begin[t], m);
+        if (lowBegin < split[t]) {
+            low.push_back(std::make_pair(lowBegin, split[t]));
+            lowAt.push_back(lowAt.back() + split[t] - lowBegin);
+        }
+    }
+
+    int64_t wrong = highAt.back();
+#pragma omp parallel for num_threads(threads)
+    for (int t = 0; t < threads; t++) {
+        int64_t from = wrong * t / threads, to = wrong * (t + 1) / threads;
+        if (from == to)
+            continue;
+        size_t h = std::upper_bound(highAt.begin(), highAt.end(), from) -
+                   highAt.begin() - 1;
+        size_t l = std::upper_bound(lowAt.begin(), lowAt.end(), from) -
+                   lowAt.begin() - 1;
+        int i = high[h].first + static_cast<int>(from - highAt[h]);
+        int j = low[l].first + static_cast<int>(from - lowAt[l]);
+        for (int64_t done = from; done < to; done++) {
+            if (i == high[h].second)
+                i = high[++h].first;
+            if (j == low[l].second)
+                j = low[++l].first;
+            std::swap(a[i++], a[j++]);
+        }
+    }
+    return m;
+}
+
+std::vector<double> randomSample(const double* a, int left, int right,
+                                 std::mt19937* gen) {
+    std::uniform_int_distribution<int> pick(left, right - 1);
+    std::vector<double> sample(kSampleSize);
+    for (double& s : sample)
+        s = a[pick(*gen)];
+    std::sort(sample.begin(), sample.end());
+    return sample;
+}
+}  // namespace
+
+int parallelPartition(std::vector<double>* vec, int left, int right,
+                      double pvt, bool orEqual) {
+    if (left < 0 || right > static_cast<int>(vec->size()) || left > right)
+        throw "wrong partition range";
+    if (orEqual)
+        return partitionChunks(vec->data(), left, right,
+                               notGreaterThan{ pvt });
+    return partitionChunks(vec->data(), left, right, lessThan{ pvt });
+}
+
+double selectK(std::vector<double>* vec, int k) {
+    int n = vec->size();
+    if (k < 0 || k >= n)
+        throw "rank out of range";
+
+    double* a = vec->data();
+    int lo = 0, hi = n;
+    std::mt19937 gen(n);
+    while (hi - lo > kSequentialCutoff) {
+        // Floyd-Rivest: two splitters from a sample bracket the target
+        // rank closely, only the part between them is kept
+        std::vector<double> sample = randomSample(a, lo, hi, &gen);
+        int pos = static_cast<int>(static_cast<int64_t>(k - lo) *
+                                   kSampleSize / (hi - lo));
+        int oldSize = hi - lo;
+        if (pos - kSampleGap >= 0) {
+            int m = parallelPartition(vec, lo, hi,
+                                      sample[pos - kSampleGap]);
+            if (k < m)
+                hi = m;
+            else
+                lo = m;
+        }
+        if (pos + kSampleGap < kSampleSize && lo <= k && k < hi) {
+            int m = parallelPartition(vec, lo, hi,
+                                      sample[pos + kSampleGap], true);
+            if (k < m)
+                hi = m;
+            else
+                lo = m;
+        }
+        if (hi - lo == oldSize) {
+            // the splitters caught the whole range (few distinct keys):
+            // three-way step around one pivot, the equal keys drop out
+            double pvt = sample[pos];
+            int m = parallelPartition(vec, lo, hi, pvt);
+            if (k < m) {
+                hi = m;
+                continue;
+            }
+            int eq = parallelPartition(vec, m, hi, pvt, true);
+            if (k < eq)
+                return a[k];
+            lo = eq;
+        }
+    }
+    std::nth_element(a + lo, a + k, a + hi);
+    return a[k];
+}
+
+std::vector<double> topK(std::vector<double>* vec, int k) {
+    if (k <= 0)
+        return std::vector<double>();
+    k = std::min(k, static_cast<int>(vec->size()));
+    selectK(vec, k - 1);
+    std::vector<double> res(vec->begin(), vec->begin() + k);
+    hoarSort(&res, 0, k - 1);
+    return res;
+}
+
+std::vector<double> quantiles(const std::vector<double>& vec,
+                              const std::vector<double>& q) {
+    int n = vec.size();
+    if (n == 0)
+        throw "empty vector";
+    std::vector<int> ranks(q.size());
+    for (size_t i = 0; i < q.size(); i++) {
+        if (!(q[i] >= 0 && q[i] <= 1))
+            throw "quantile out of [0, 1]";
+        ranks[i] = static_cast<int>(std::floor(q[i] * (n - 1)));
+    }
+    std::vector<double> res(q.size());
+    if (n <= kSequentialCutoff) {
+        std::vector<double> sorted(vec);
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = 0; i < ranks.size(); i++)
+            res[i] = sorted[ranks[i]];
+        return res;
+    }
+
+    // <Splitters>
+    std::mt19937 gen(n);
+    std::vector<double> sample = randomSample(vec.data(), 0, n, &gen);
+    std::vector<double> splitters;
+    for (int r : ranks) {
+        int pos = static_cast<int>(static_cast<int64_t>(r) *
+                                   kSampleSize / n);
+        if (pos - kSampleGap >= 0)
+            splitters.push_back(sample[pos - kSampleGap]);
+        if (pos + kSampleGap < kSampleSize)
+            splitters.push_back(sample[pos + kSampleGap]);
+    }
+    std::sort(splitters.begin(), splitters.end());
+    splitters.erase(std::unique(splitters.begin(), splitters.end()),
+                    splitters.end());
+    // </Splitters>
+
+    // bucket 2i holds keys between splitters i - 1 and i, bucket 2i + 1
+    // keys equal to splitter i
+    const int buckets = 2 * splitters.size() + 1;
+    auto bucketOf = [&splitters](double x) {
+        int i = std::lower_bound(splitters.begin(), splitters.end(), x) -
+                splitters.begin();
+        bool equal = i < static_cast<int>(splitters.size()) &&
+                     splitters[i] == x;
+        return 2 * i + (equal ? 1 : 0);
+    };
+
+    // <Classification>
+    int threads = std::max(1, std::min(omp_get_max_threads(),
+                                       n / kMinChunk));
+    std::vector<int64_t> counts(static_cast<size_t>(threads) * buckets, 0);
+    auto chunkBegin = [n, threads](int t) {
+        return static_cast<int>(static_cast<int64_t>(n) * t / threads);
+    };
+#pragma omp parallel for num_threads(threads)
+    for (int t = 0; t < threads; t++) {
+        int64_t* count = counts.data() + static_cast<size_t>(t) * buckets;
+        for (int i = chunkBegin(t); i < chunkBegin(t + 1); i++)
+            count[bucketOf(vec[i])]++;
+    }
+    std::vector<int64_t> bucketAt(buckets + 1, 0);
+    for (int b = 0; b < buckets; b++) {
+        int64_t total = 0;
+        for (int t = 0; t < threads; t++)
+            total += counts[static_cast<size_t>(t) * buckets + b];
+        bucketAt[b + 1] = bucketAt[b] + total;
+    }
+    // </Classification>
+
+    // only the buckets holding a wanted rank are gathered, every thread
+    // writes its keys after those of the threads before it
+    std::vector<int> bucketOfRank(ranks.size());
+    std::vector<std::vector<double>> gathered(buckets);
+    for (size_t i = 0; i < ranks.size(); i++) {
+        int b = std::upper_bound(bucketAt.begin(), bucketAt.end(),
+                                 static_cast<int64_t>(ranks[i])) -
+                bucketAt.begin() - 1;
+        bucketOfRank[i] = b;
+        if (b % 2 == 0)
+            gathered[b].resize(bucketAt[b + 1] - bucketAt[b]);
+    }
+    for (int b = 0; b < buckets; b += 2) {
+        int64_t at = 0;
+        for (int t = 0; t < threads; t++) {
+            int64_t c = counts[static_cast<size_t>(t) * buckets + b];
+            counts[static_cast<size_t>(t) * buckets + b] = at;
+            at += c;
+        }
+    }
+#pragma omp parallel for num_threads(threads)
+    for (int t = 0; t < threads; t++) {
+        int64_t* cursor = counts.data() + static_cast<size_t>(t) * buckets;
+        for (int i = chunkBegin(t); i < chunkBegin(t + 1); i++) {
+            int b = bucketOf(vec[i]);
+            if (!gathered[b].empty())
+                gathered[b][cursor[b]++] = vec[i];
+        }
+    }
+
+    for (size_t i = 0; i < ranks.size(); i++) {
+        int b = bucketOfRank[i];
+        if (b % 2 == 1) {
+            res[i] = splitters[b / 2];
+            continue;
+        }
+        std::vector<double>& keys = gathered[b];
+        int64_t local = ranks[i] - bucketAt[b];
+        std::nth_element(keys.begin(), keys.begin() + local, keys.end());
+        res[i] = keys[local];
+    }
+    return res;
+}
@@ -0,0 +1,30 @@
+// Copyright 2022 Remizova Antonina
+#ifndef MODULES_TASK_2_REMIZOVA_A_HOAR_BATCHER_HOAR_SELECT_H_
+#define MODULES_TASK_2_REMIZOVA_A_HOAR_BATCHER_HOAR_SELECT_H_
+
+#include <vector>
+
+// Selection on top of the Hoare partition: only the part holding the
+// wanted rank is partitioned further, so the work is O(n) instead of the
+// O(n log n) of a full hoarSort. Keys must not be NaN.
+
+// Parallel partition of vec[left, right) around pvt: returns m such that
+// [left, m) holds the elements less than pvt (orEqual: not greater than
+// pvt) and [m, right) the rest
+int parallelPartition(std::vector<double>* vec, int left, int right,
+                      double pvt, bool orEqual = false);
+
+// Puts the k-th smallest element (0-based) to (*vec)[k], smaller or equal
+// ones before it and greater or equal ones after it, and returns it
+double selectK(std::vector<double>* vec, int k);
+
+// The k smallest elements in ascending order; vec is reordered
+std::vector<double> topK(std::vector<double>* vec, int k);
+
+// Elements of ranks floor(q[i] * (n - 1)), 0 <= q[i] <= 1. All ranks are
+// bracketed with splitters from one sample and found in a single
+// classification pass, vec is not modified
+std::vector<double> quantiles(const std::vector<double>& vec,
+                              const std::vector<double>& q);
+
+#endif  // MODULES_TASK_2_REMIZOVA_A_HOAR_BATCHER_HOAR_SELECT_H_
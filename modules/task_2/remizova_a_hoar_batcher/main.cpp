@@ -1,6 +1,9 @@
 // Copyright 2022 Remizova Antonina
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
 #include "../../../modules/task_2/remizova_a_hoar_batcher/hoar_batcher.h"
+#include "../../../modules/task_2/remizova_a_hoar_batcher/hoar_select.h"
 
 TEST(SEQ_hoar_batcher, can_create_rand_vec_10) {
     int size = 10;
@@ -161,6 +164,81 @@ TEST(PAR_hoar_batcher, compare_seq_par_sort_with_vec_size_1000000) {
     EXPECT_EQ(res_seq, res_par);
 }
 
+std::vector<double> getRandDoubles(int size) {
+    std::mt19937 gen(size);
+    std::uniform_real_distribution<double> dist(-1e6, 1e6);
+    std::vector<double> vec(size);
+    for (double& x : vec)
+        x = dist(gen);
+    return vec;
+}
+
+TEST(PAR_hoar_select, parallel_partition) {
+    std::vector<double> v = getRandDoubles(1000000);
+    int m = parallelPartition(&v, 100, 900000, 0.0);
+    for (int i = 100; i < 900000; i++)
+        ASSERT_EQ(i < m, v[i] < 0.0);
+    m = parallelPartition(&v, 0, v.size(), 1e7, true);
+    EXPECT_EQ(1000000, m);
+}
+
+TEST(PAR_hoar_select, select_k_any_rank) {
+    std::vector<double> v = getRandDoubles(1000000);
+    std::vector<double> sorted(v);
+    std::sort(sorted.begin(), sorted.end());
+    for (int k : { 0, 1, 4999, 500000, 999999 }) {
+        std::vector<double> w(v);
+        EXPECT_EQ(sorted[k], selectK(&w, k));
+        EXPECT_EQ(sorted[k], w[k]);
+        EXPECT_TRUE(std::all_of(w.begin(), w.begin() + k,
+            [&](double x) { return x <= w[k]; }));
+        EXPECT_TRUE(std::all_of(w.begin() + k, w.end(),
+            [&](double x) { return x >= w[k]; }));
+    }
+    EXPECT_ANY_THROW(selectK(&v, 1000000));
+}
+
+TEST(PAR_hoar_select, select_k_few_distinct) {
+    std::vector<double> v = getRandVector(1000000);
+    for (double& x : v)
+        x = static_cast<int>(x) % 3;
+    std::vector<double> sorted(v);
+    std::sort(sorted.begin(), sorted.end());
+    for (int k : { 0, 333333, 500000, 999999 }) {
+        std::vector<double> w(v);
+        EXPECT_EQ(sorted[k], selectK(&w, k));
+    }
+}
+
+TEST(PAR_hoar_select, quantiles_single_pass) {
+    std::vector<double> v = getRandDoubles(2000000);
+    for (int i = 0; i < 300000; i++)
+        v[i * 5] = 42.0;
+    std::vector<double> q = { 0.0, 0.01, 0.25, 0.5, 0.5, 0.9, 0.999, 1.0 };
+    std::vector<double> res = quantiles(v, q);
+    std::sort(v.begin(), v.end());
+    for (size_t i = 0; i < q.size(); i++)
+        EXPECT_EQ(v[static_cast<int>(q[i] * (v.size() - 1))], res[i]);
+    EXPECT_ANY_THROW(quantiles(v, { 1.5 }));
+}
+
+TEST(PAR_hoar_select, top_k_against_full_sort) {
+    std::vector<double> v = getRandDoubles(10000000);
+    std::vector<double> full(v);
+
+    double start_time = omp_get_wtime();
+    std::vector<double> top = topK(&v, 1000);
+    double top_time = omp_get_wtime() - start_time;
+
+    start_time = omp_get_wtime();
+    hoarSort(&full, 0, full.size() - 1);
+    double sort_time = omp_get_wtime() - start_time;
+
+    std::cout << "top-1000: " << top_time << " s, full sort: "
+              << sort_time << " s" << std::endl;
+    EXPECT_EQ(std::vector<double>(full.begin(), full.begin() + 1000), top);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
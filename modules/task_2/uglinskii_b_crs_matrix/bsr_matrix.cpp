@@ -0,0 +1,44 @@
+// Copyright 2022 Uglinskii Bogdan
+#include "../../../modules/task_2/uglinskii_b_crs_matrix/bsr_matrix.h"
+
+#include <vector>
+
+int CountBlocks(const MatrixCRS& M, int R, int C) {
+  const int block_rows = (M.N + R - 1) / R;
+  const int block_cols = (M.M + C - 1) / C;
+  int blocks = 0;
+#pragma omp parallel reduction(+ : blocks)
+  {
+    std::vector<char> seen(block_cols, 0);
+    std::vector<int> touched;
+#pragma omp for schedule(static)
+    for (int b = 0; b < block_rows; b++) {
+      const int last = std::min(M.N, (b + 1) * R);
+      for (int k = M.row_index[b * R]; k < M.row_index[last]; k++) {
+        int bc = M.col[k] / C;
+        if (!seen[bc]) {
+          seen[bc] = 1;
+          touched.push_back(bc);
+        }
+      }
+      blocks += touched.size();
+      for (int bc : touched) seen[bc] = 0;
+      touched.clear();
+    }
+  }
+  return blocks;
+}
+
+int DetectBlockSize(const MatrixCRS& M) {
+  int best = 1;
+  double best_bytes = 12.0 * M.NZ;
+  for (int size = 2; size <= 4; size++) {
+    double bytes = CountBlocks(M, size, size) * (8.0 * size * size + 4.0);
+    // ties go to the larger block, its kernel has more independent sums
+    if (bytes <= best_bytes) {
+      best = size;
+      best_bytes = bytes;
+    }
+  }
+  return best;
+}
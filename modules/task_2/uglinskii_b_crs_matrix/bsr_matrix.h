@@ -0,0 +1,266 @@
+// Copyright 2022 Uglinskii Bogdan
+#ifndef MODULES_TASK_2_UGLINSKII_B_CRS_MATRIX_BSR_MATRIX_H_
+#define MODULES_TASK_2_UGLINSKII_B_CRS_MATRIX_BSR_MATRIX_H_
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "../../../3rdparty/unapproved/parallel_scan.h"
+#include "../../../modules/task_2/uglinskii_b_crs_matrix/crs_multiplication.h"
+
+// Block CRS: the matrix is cut into R x C blocks and every block holding
+// a nonzero is stored dense, row by row, with one column index for the
+// whole block. The scalar size N x M does not have to be a multiple of
+// the block size, the last block row and column are padded with zeros.
+template <int R, int C>
+struct MatrixBSR {
+  int N;
+  int M;
+  int NB;  // stored blocks
+
+  std::vector<double> value;   // NB * R * C
+  std::vector<int> col;        // block column of every block
+  std::vector<int> row_index;  // block row pointers
+
+  int BlockRows() const { return (N + R - 1) / R; }
+  int BlockCols() const { return (M + C - 1) / C; }
+};
+
+// Calls f(0), f(1), ..., f(n - 1) with compile-time constants, so that
+// the loops over a block disappear
+template <int I, int n>
+struct Unroll {
+  template <class F>
+  static void Run(const F& f) {
+    f(I);
+    Unroll<I + 1, n>::Run(f);
+  }
+};
+
+template <int n>
+struct Unroll<n, n> {
+  template <class F>
+  static void Run(const F&) {}
+};
+
+// blocks a BSR storage of M with R x C blocks would hold
+int CountBlocks(const MatrixCRS& M, int R, int C);
+
+// The square block size from 1 to 4 that moves the fewest bytes through
+// an SpMV (8 bytes per stored value, zero fill included, 4 per column
+// index); 1 means blocking does not pay
+int DetectBlockSize(const MatrixCRS& M);
+
+template <int R, int C>
+int ConvertToBSR(const MatrixCRS& A, MatrixBSR<R, C>* B) {
+  B->N = A.N;
+  B->M = A.M;
+  const int block_rows = B->BlockRows();
+  std::vector<int> count(block_rows + 1, 0);
+
+  // <Counting>
+#pragma omp parallel
+  {
+    std::vector<char> seen(B->BlockCols(), 0);
+    std::vector<int> touched;
+#pragma omp for schedule(static)
+    for (int b = 0; b < block_rows; b++) {
+      touched.clear();
+      const int last = std::min(A.N, (b + 1) * R);
+      for (int k = A.row_index[b * R]; k < A.row_index[last]; k++) {
+        if (!seen[A.col[k] / C]) {
+          seen[A.col[k] / C] = 1;
+          touched.push_back(A.col[k] / C);
+        }
+      }
+      count[b] = touched.size();
+      for (int bc : touched) seen[bc] = 0;
+    }
+  }
+  // </Counting>
+
+  B->row_index.resize(block_rows + 1);
+  B->NB = pscan::exclusive_scan_omp(count.data(), B->row_index.data(),
+                                    count.size());
+  B->col.resize(B->NB);
+  B->value.assign(static_cast<size_t>(B->NB) * R * C, 0.0);
+
+  // <Filling>
+  // the block columns of a row are laid out sorted first, slot maps a
+  // block column to its block
+#pragma omp parallel
+  {
+    std::vector<int> slot(B->BlockCols(), -1);
+#pragma omp for schedule(static)
+    for (int b = 0; b < block_rows; b++) {
+      int* cols = B->col.data() + B->row_index[b];
+      int n = 0;
+      const int last = std::min(A.N, (b + 1) * R);
+      for (int k = A.row_index[b * R]; k < A.row_index[last]; k++) {
+        if (slot[A.col[k] / C] < 0) {
+          slot[A.col[k] / C] = 0;
+          cols[n++] = A.col[k] / C;
+        }
+      }
+      std::sort(cols, cols + n);
+      const int first = B->row_index[b];
+      for (int j = 0; j < n; j++) slot[cols[j]] = j;
+      for (int i = b * R; i < last; i++) {
+        for (int k = A.row_index[i]; k < A.row_index[i + 1]; k++) {
+          size_t at = static_cast<size_t>(first + slot[A.col[k] / C]) * R * C;
+          B->value[at + (i - b * R) * C + A.col[k] % C] = A.value[k];
+        }
+      }
+      for (int j = 0; j < n; j++) slot[cols[j]] = -1;
+    }
+  }
+  // </Filling>
+  return 0;
+}
+
+// the zero fill of the blocks is dropped again
+template <int R, int C>
+int ConvertToCRS(const MatrixBSR<R, C>& B, MatrixCRS* A) {
+  InitializeMatrix(B.N, B.M, 0, A);
+  for (int i = 0; i < B.N; i++) {
+    const int b = i / R, r = i % R;
+    for (int k = B.row_index[b]; k < B.row_index[b + 1]; k++) {
+      const double* row = &B.value[static_cast<size_t>(k) * R * C + r * C];
+      for (int c = 0; c < C && B.col[k] * C + c < B.M; c++) {
+        if (row[c] != 0) {
+          A->value.push_back(row[c]);
+          A->col.push_back(B.col[k] * C + c);
+        }
+      }
+    }
+    A->row_index[i + 1] = A->value.size();
+  }
+  A->NZ = A->value.size();
+  return 0;
+}
+
+// y = A x
+template <int R, int C>
+int BSRMultiplyVector(const MatrixBSR<R, C>& A, const std::vector<double>& x,
+                      std::vector<double>* y) {
+  if (static_cast<int>(x.size()) != A.M) {
+    std::cout << "Incorrect sizes of matrix\n";
+    return 1;
+  }
+  // x and y are padded to whole blocks only when the size needs it
+  const int block_rows = A.BlockRows();
+  std::vector<double> x_pad;
+  const double* xs = x.data();
+  if (A.M % C != 0) {
+    x_pad.assign(static_cast<size_t>(A.BlockCols()) * C, 0.0);
+    std::copy(x.begin(), x.end(), x_pad.begin());
+    xs = x_pad.data();
+  }
+  y->assign(static_cast<size_t>(block_rows) * R, 0.0);
+  double* ys = y->data();
+
+#pragma omp parallel for schedule(static)
+  for (int b = 0; b < block_rows; b++) {
+    double sum[R] = {};
+    for (int k = A.row_index[b]; k < A.row_index[b + 1]; k++) {
+      const double* block = &A.value[static_cast<size_t>(k) * R * C];
+      const double* xb = xs + static_cast<size_t>(A.col[k]) * C;
+      Unroll<0, R>::Run([&](int r) {
+        Unroll<0, C>::Run([&](int c) { sum[r] += block[r * C + c] * xb[c]; });
+      });
+    }
+    Unroll<0, R>::Run([&](int r) { ys[b * R + r] = sum[r]; });
+  }
+  y->resize(A.N);
+  return 0;
+}
+
+// C = A B, blocks of C that cancel to zero are kept
+template <int R, int K, int C>
+int BSRMultiply(const MatrixBSR<R, K>& A, const MatrixBSR<K, C>& B,
+                MatrixBSR<R, C>* P) {
+  if (A.M != B.N) {
+    std::cout << "Incorrect sizes of matrix\n";
+    return 1;
+  }
+  P->N = A.N;
+  P->M = B.M;
+  const int block_rows = A.BlockRows();
+  std::vector<int> count(block_rows + 1, 0);
+
+  // <Symbolic>
+#pragma omp parallel
+  {
+    std::vector<char> seen(B.BlockCols(), 0);
+    std::vector<int> touched;
+#pragma omp for schedule(dynamic, 64)
+    for (int b = 0; b < block_rows; b++) {
+      touched.clear();
+      for (int ka = A.row_index[b]; ka < A.row_index[b + 1]; ka++) {
+        const int kb = A.col[ka];
+        for (int l = B.row_index[kb]; l < B.row_index[kb + 1]; l++) {
+          if (!seen[B.col[l]]) {
+            seen[B.col[l]] = 1;
+            touched.push_back(B.col[l]);
+          }
+        }
+      }
+      count[b] = touched.size();
+      for (int bc : touched) seen[bc] = 0;
+    }
+  }
+  // </Symbolic>
+
+  P->row_index.resize(block_rows + 1);
+  P->NB = pscan::exclusive_scan_omp(count.data(), P->row_index.data(),
+                                    count.size());
+  P->col.resize(P->NB);
+  P->value.assign(static_cast<size_t>(P->NB) * R * C, 0.0);
+
+  // <Numeric>
+  // a block row of the product is accumulated in place: the block columns
+  // are laid out sorted first, slot maps a block column to its block
+#pragma omp parallel
+  {
+    std::vector<int> slot(B.BlockCols(), -1);
+#pragma omp for schedule(dynamic, 64)
+    for (int b = 0; b < block_rows; b++) {
+      int* cols = P->col.data() + P->row_index[b];
+      int n = 0;
+      for (int ka = A.row_index[b]; ka < A.row_index[b + 1]; ka++) {
+        const int kb = A.col[ka];
+        for (int l = B.row_index[kb]; l < B.row_index[kb + 1]; l++) {
+          if (slot[B.col[l]] < 0) {
+            slot[B.col[l]] = 0;
+            cols[n++] = B.col[l];
+          }
+        }
+      }
+      std::sort(cols, cols + n);
+      for (int j = 0; j < n; j++) slot[cols[j]] = P->row_index[b] + j;
+
+      for (int ka = A.row_index[b]; ka < A.row_index[b + 1]; ka++) {
+        const double* a = &A.value[static_cast<size_t>(ka) * R * K];
+        const int kb = A.col[ka];
+        for (int l = B.row_index[kb]; l < B.row_index[kb + 1]; l++) {
+          const double* bl = &B.value[static_cast<size_t>(l) * K * C];
+          double* p = &P->value[static_cast<size_t>(slot[B.col[l]]) * R * C];
+          Unroll<0, R>::Run([&](int r) {
+            Unroll<0, K>::Run([&](int k) {
+              const double ark = a[r * K + k];
+              Unroll<0, C>::Run([&](int c) {
+                p[r * C + c] += ark * bl[k * C + c];
+              });
+            });
+          });
+        }
+      }
+      for (int j = 0; j < n; j++) slot[cols[j]] = -1;
+    }
+  }
+  // </Numeric>
+  return 0;
+}
+
+#endif  // MODULES_TASK_2_UGLINSKII_B_CRS_MATRIX_BSR_MATRIX_H_
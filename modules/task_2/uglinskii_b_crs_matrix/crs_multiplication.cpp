@@ -1,9 +1,13 @@
 // Copyright 2022 Uglinskii Bogdan
 #include "../../../modules/task_2/uglinskii_b_crs_matrix/crs_multiplication.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <random>
 
+#include "../../../3rdparty/unapproved/parallel_scan.h"
+
 void InitializeMatrix(int rows, int col, int NZ, MatrixCRS *M) {
   M->N = rows;
   M->M = col;
@@ -284,12 +288,10 @@ int CRSMultiplyOMP(MatrixCRS A, MatrixCRS B, MatrixCRS *C) {
   }
   B = Transpose(B);
 
-  std::vector<double> vals;
-  std::vector<int> col;
-  std::vector<int> row_idx{0};
-
   std::vector<std::vector<double>> local_vals(A.N);
   std::vector<std::vector<int>> local_col(A.N);
+  // one more zero count at the end: the exclusive scan puts NZ there
+  std::vector<int> row_NZ(A.N + 1, 0);
 #pragma omp parallel for schedule(static)
   for (int i = 0; i < A.N; i++) {
     for (int j = 0; j < B.N; j++) {
@@ -307,22 +309,23 @@ int CRSMultiplyOMP(MatrixCRS A, MatrixCRS B, MatrixCRS *C) {
         local_vals[i].push_back(S);
       }
     }
+    row_NZ[i] = local_col[i].size();
   }
 
-  int rows_NZ = 0;
+  // row pointers are the prefix sums of the row counts, then every row
+  // is copied to its place in parallel
+  InitializeMatrix(A.N, B.N, 0, C);
+  C->NZ = pscan::exclusive_scan_omp(row_NZ.data(), C->row_index.data(),
+                                    row_NZ.size());
+  C->col.resize(C->NZ);
+  C->value.resize(C->NZ);
+#pragma omp parallel for schedule(static)
   for (int i = 0; i < A.N; i++) {
-    col.insert(col.end(), local_col[i].begin(), local_col[i].end());
-    vals.insert(vals.end(), local_vals[i].begin(), local_vals[i].end());
-
-    rows_NZ += local_col[i].size();
-    row_idx.push_back(rows_NZ);
+    std::copy(local_col[i].begin(), local_col[i].end(),
+              C->col.begin() + C->row_index[i]);
+    std::copy(local_vals[i].begin(), local_vals[i].end(),
+              C->value.begin() + C->row_index[i]);
   }
 
-  InitializeMatrix(A.N, B.N, col.size(), C);
-
-  C->col.insert(C->col.begin(), col.begin(), col.end());
-  C->value.insert(C->value.begin(), vals.begin(), vals.end());
-  C->row_index.insert(C->row_index.begin(), row_idx.begin(), row_idx.end());
-
   return 0;
 }
@@ -2,11 +2,56 @@
 #include <gtest/gtest.h>
 #include <omp.h>
 
+#include <algorithm>
 #include <iostream>
+#include <random>
 #include <vector>
 
+#include "../../../3rdparty/unapproved/parallel_scan.h"
+#include "./bsr_matrix.h"
 #include "./crs_multiplication.h"
 
+// FEM-like matrix: block_rows x block_rows dense b x b blocks, block row
+// i couples to its neighbours i - 1, i + 1 and to two random blocks
+MatrixCRS GenerateBlockMatrixCRS(int block_rows, int b) {
+  std::mt19937 gen(block_rows * b);
+  std::uniform_real_distribution<double> value(-1, 1);
+  std::uniform_int_distribution<int> any(0, block_rows - 1);
+  MatrixCRS M;
+  InitializeMatrix(block_rows * b, block_rows * b, 0, &M);
+  for (int i = 0; i < block_rows; i++) {
+    std::vector<int> blocks = {i, any(gen), any(gen)};
+    if (i > 0) blocks.push_back(i - 1);
+    if (i + 1 < block_rows) blocks.push_back(i + 1);
+    std::sort(blocks.begin(), blocks.end());
+    blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+    for (int r = 0; r < b; r++) {
+      for (int bc : blocks) {
+        for (int c = 0; c < b; c++) {
+          M.value.push_back(value(gen));
+          M.col.push_back(bc * b + c);
+        }
+      }
+      M.row_index[i * b + r + 1] = M.value.size();
+    }
+  }
+  M.NZ = M.value.size();
+  return M;
+}
+
+std::vector<double> CRSMultiplyVector(const MatrixCRS& A,
+                                      const std::vector<double>& x) {
+  std::vector<double> y(A.N);
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < A.N; i++) {
+    double sum = 0;
+    for (int k = A.row_index[i]; k < A.row_index[i + 1]; k++)
+      sum += A.value[k] * x[A.col[k]];
+    y[i] = sum;
+  }
+  return y;
+}
+
 TEST(Multiplication_seq, crs_5x5_5) {
   MatrixCRS matrix_A = GenerateRandomMatrixCRS(5, 5, 5);
   MatrixCRS matrix_B = GenerateRandomMatrixCRS(5, 5, 5);
@@ -122,6 +167,140 @@ TEST(Multiplication_parallel, 25x25_35) {
   ASSERT_TRUE(CompareMatrixCRS(matrix_C, C_omp));
 }
 
+TEST(Multiplication_parallel, 30x30_exact_storage) {
+  MatrixCRS matrix_A = GenerateRandomMatrixCRS(30, 30, 90);
+  MatrixCRS matrix_B = GenerateRandomMatrixCRS(30, 30, 90);
+
+  MatrixCRS matrix_C, C_omp;
+  CRSMultiply(matrix_A, matrix_B, &matrix_C);
+  CRSMultiplyOMP(matrix_A, matrix_B, &C_omp);
+  ASSERT_EQ(31u, C_omp.row_index.size());
+  ASSERT_EQ(static_cast<size_t>(C_omp.NZ), C_omp.col.size());
+  ASSERT_EQ(static_cast<size_t>(C_omp.NZ), C_omp.value.size());
+  ASSERT_TRUE(CompareMatrixCRS(matrix_C, C_omp));
+}
+
+TEST(Scan, row_pointers_from_counts) {
+  const int rows = 1 << 20;
+  std::vector<int> counts(rows + 1, 0), row_index(rows + 1);
+  for (int i = 0; i < rows; i++) counts[i] = i % 7;
+  int NZ = pscan::exclusive_scan_omp(counts.data(), row_index.data(),
+                                     counts.size());
+  int expected = 0;
+  for (int i = 0; i <= rows; i++) {
+    ASSERT_EQ(expected, row_index[i]);
+    expected += counts[i];
+  }
+  ASSERT_EQ(expected, NZ);
+}
+
+TEST(BSR, round_trip_through_crs) {
+  MatrixCRS A = GenerateRandomMatrixCRS(50, 47, 300);
+  MatrixBSR<3, 3> B3;
+  MatrixBSR<2, 4> B24;
+  MatrixCRS back;
+
+  ConvertToBSR(A, &B3);
+  ASSERT_EQ(17, B3.BlockRows());
+  ASSERT_EQ(16, B3.BlockCols());
+  ASSERT_EQ(CountBlocks(A, 3, 3), B3.NB);
+  ConvertToCRS(B3, &back);
+  ASSERT_TRUE(CompareMatrixCRS(A, back));
+
+  ConvertToBSR(A, &B24);
+  ASSERT_EQ(CountBlocks(A, 2, 4), B24.NB);
+  ConvertToCRS(B24, &back);
+  ASSERT_TRUE(CompareMatrixCRS(A, back));
+}
+
+TEST(BSR, detects_block_size) {
+  ASSERT_EQ(3, DetectBlockSize(GenerateBlockMatrixCRS(200, 3)));
+  ASSERT_EQ(4, DetectBlockSize(GenerateBlockMatrixCRS(200, 4)));
+  ASSERT_EQ(1, DetectBlockSize(GenerateRandomMatrixCRS(150, 150, 450)));
+
+  MatrixCRS A = GenerateBlockMatrixCRS(200, 3);
+  MatrixBSR<3, 3> B;
+  ConvertToBSR(A, &B);
+  ASSERT_EQ(A.NZ, B.NB * 9);
+}
+
+TEST(BSR, multiply_vector_matches_crs) {
+  MatrixCRS A = GenerateRandomMatrixCRS(61, 43, 500);
+  std::vector<double> x(43);
+  for (int i = 0; i < 43; i++) x[i] = GenerateValue(-1, 1);
+  std::vector<double> expected = CRSMultiplyVector(A, x), y;
+
+  MatrixBSR<4, 4> B;
+  ConvertToBSR(A, &B);
+  ASSERT_EQ(0, BSRMultiplyVector(B, x, &y));
+  ASSERT_EQ(expected.size(), y.size());
+  for (int i = 0; i < 61; i++) ASSERT_NEAR(expected[i], y[i], 1e-9);
+
+  MatrixBSR<3, 2> B32;
+  ConvertToBSR(A, &B32);
+  ASSERT_EQ(0, BSRMultiplyVector(B32, x, &y));
+  for (int i = 0; i < 61; i++) ASSERT_NEAR(expected[i], y[i], 1e-9);
+
+  ASSERT_EQ(1, BSRMultiplyVector(B, std::vector<double>(42), &y));
+}
+
+TEST(BSR, multiply_matches_crs) {
+  MatrixCRS A = GenerateRandomMatrixCRS(31, 26, 120);
+  MatrixCRS B = GenerateRandomMatrixCRS(26, 35, 120);
+  MatrixCRS expected;
+  CRSMultiply(A, B, &expected);
+
+  MatrixBSR<3, 2> A32;
+  MatrixBSR<2, 4> B24;
+  MatrixBSR<3, 4> C34;
+  ConvertToBSR(A, &A32);
+  ConvertToBSR(B, &B24);
+  ASSERT_EQ(0, BSRMultiply(A32, B24, &C34));
+  std::vector<std::vector<double>> dense = ExpandMatrix(expected);
+  MatrixCRS product;
+  ConvertToCRS(C34, &product);
+  std::vector<std::vector<double>> result = ExpandMatrix(product);
+  for (int i = 0; i < 31; i++)
+    for (int j = 0; j < 35; j++) ASSERT_NEAR(dense[i][j], result[i][j], 1e-6);
+
+  MatrixBSR<4, 4> A44;
+  MatrixBSR<2, 4> C24;
+  ConvertToBSR(A, &A44);
+  ASSERT_EQ(1, BSRMultiply(B24, A44, &C24));
+}
+
+TEST(BSR, fem_3x3_spmv_and_spgemm) {
+  const int block_rows = 100000;
+  MatrixCRS A = GenerateBlockMatrixCRS(block_rows, 3);
+  MatrixBSR<3, 3> B;
+  ConvertToBSR(A, &B);
+  std::vector<double> x(A.M, 1.0), y;
+
+  double t1 = omp_get_wtime();
+  for (int repeat = 0; repeat < 10; repeat++) CRSMultiplyVector(A, x);
+  double t2 = omp_get_wtime();
+  for (int repeat = 0; repeat < 10; repeat++) BSRMultiplyVector(B, x, &y);
+  double t3 = omp_get_wtime();
+  std::vector<double> expected = CRSMultiplyVector(A, x);
+  for (int i = 0; i < A.N; i++) ASSERT_NEAR(expected[i], y[i], 1e-9);
+
+  // column indices plus row pointers read by one SpMV
+  double crs_index = 4.0 * (A.NZ + A.N + 1);
+  double bsr_index = 4.0 * (B.NB + B.BlockRows() + 1);
+  std::cout << "CRS SpMV = " << (t2 - t1) / 10
+            << "\nBSR 3x3 SpMV = " << (t3 - t2) / 10
+            << "\nIndex bytes CRS / BSR = " << crs_index / bsr_index << "\n";
+  ASSERT_GT(crs_index / bsr_index, 5.0);
+
+  MatrixBSR<3, 3> square;
+  MatrixBSR<3, 3> small;
+  ConvertToBSR(GenerateBlockMatrixCRS(2000, 3), &small);
+  double t4 = omp_get_wtime();
+  BSRMultiply(small, small, &square);
+  std::cout << "BSR 3x3 SpGEMM = " << omp_get_wtime() - t4 << "\n";
+  ASSERT_GE(square.NB, small.NB);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -6,6 +6,10 @@
 #include <iostream>
 
 #include "../../../modules/task_3/bakina_k_ccs_matrix_mult/ccs_matrix_mult.h"
+#define PARALLEL_SCAN_TBB
+#include "../../../3rdparty/unapproved/ccs_spmv.h"
+#include "../../../3rdparty/unapproved/parallel_scan.h"
+#include "../../../3rdparty/unapproved/parallel_transpose.h"
 
 std::vector<std::vector<double>> get_random_matrix(int n, int m) {
     if (n < 0 || m < 0) {
@@ -77,30 +81,13 @@ CCS_matrix ccs_matrix_transposition_tbb(const CCS_matrix& B) {
     CCS_matrix BT;
     BT.col_n = B.row_n;
     BT.row_n = B.col_n;
-    std::vector<std::vector<int>> for_row(B.row_n);
-    std::vector<std::vector<double>> for_value(B.row_n);
-    for (int j = 0; j < B.col_n; ++j) {
-        tbb::parallel_for(tbb::blocked_range<size_t>(B.column_pointer[j],
-            B.column_pointer[j + 1]),
-            [&](const tbb::blocked_range<size_t>& r) {
-                int begin = r.begin(), end = r.end();
-                for (int i = begin; i != end; ++i) {
-                    for_row[B.row[i]].push_back(j);
-                    for_value[B.row[i]].push_back(B.value[i]);
-                }
-            });
-    }
     BT.column_pointer.resize(BT.col_n + 1);
-    BT.column_pointer[0] = 0;
     BT.value.resize(B.value.size());
     BT.row.resize(B.value.size());
-    for (int i = 0; i < BT.col_n; ++i) {
-        BT.column_pointer[i + 1] = BT.column_pointer[i] + for_value[i].size();
-        for (int j = BT.column_pointer[i]; j < BT.column_pointer[i + 1]; ++j) {
-            BT.value[j] = for_value[i][j - BT.column_pointer[i]];
-            BT.row[j] = for_row[i][j - BT.column_pointer[i]];
-        }
-    }
+    // the columns of B are the rows of the counting transpose
+    ptranspose::transpose_tbb<int, double>(B.col_n, B.row_n,
+        B.column_pointer.data(), B.row.data(), B.value.data(),
+        BT.column_pointer.data(), BT.row.data(), BT.value.data());
     return BT;
 }
 
@@ -147,47 +134,161 @@ CCS_matrix ccs_matrix_multplication_tbb(const CCS_matrix& A,
     if (A.row_n != B.col_n) {
         throw("Wrong matrix sizes for multiplication");
     }
+    return ccs_spgemm_tbb(B, A);
+}
 
-    // Transpose the matrix B
-    CCS_matrix BT(ccs_matrix_transposition_tbb(B));
+namespace {
+// scatter of one column of C, one per thread: value and mark are indexed
+// by the row, mark holds the last column that touched the row
+struct column_accumulator {
+    std::vector<double> value;
+    std::vector<int> mark;
+    std::vector<int> touched;
 
-    // Initialization of matrix C
+    explicit column_accumulator(int rows) : value(rows), mark(rows, -1) {}
+};
+}  // namespace
+
+CCS_matrix ccs_spgemm_tbb(const CCS_matrix& A, const CCS_matrix& B) {
+    if (A.col_n != B.row_n) {
+        throw("Wrong matrix sizes for multiplication");
+    }
     CCS_matrix C;
-    C.col_n = A.col_n;
-    C.row_n = B.row_n;
-    C.column_pointer.reserve(A.col_n + 1);
-    C.value.reserve(A.col_n * BT.col_n);
-    C.row.reserve(A.col_n * BT.col_n);
-    C.column_pointer.push_back(0);
+    C.row_n = A.row_n;
+    C.col_n = B.col_n;
+    C.column_pointer.assign(B.col_n + 1, 0);
 
-    // Multiplication
-    std::vector<std::vector<int>> x(A.col_n, std::vector<int>(A.row_n, -1));
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, A.col_n),
-        [&](const tbb::blocked_range<size_t>& r) {
-            int begin = r.begin(), end = r.end();
-            for (int i = begin; i < end; ++i) {
-                for (int j = A.column_pointer[i];
-                    j < A.column_pointer[i + 1]; ++j) {
-                    x[i][A.row[j]] = j;
+    tbb::enumerable_thread_specific<column_accumulator> accumulators(
+        column_accumulator(A.row_n));
+
+    // <Symbolic>
+    tbb::parallel_for(tbb::blocked_range<int>(0, B.col_n),
+        [&](const tbb::blocked_range<int>& r) {
+            column_accumulator& acc = accumulators.local();
+            for (int j = r.begin(); j != r.end(); ++j) {
+                int count = 0;
+                for (int kb = B.column_pointer[j];
+                    kb < B.column_pointer[j + 1]; ++kb) {
+                    int k = B.row[kb];
+                    for (int ia = A.column_pointer[k];
+                        ia < A.column_pointer[k + 1]; ++ia) {
+                        if (acc.mark[A.row[ia]] != j) {
+                            acc.mark[A.row[ia]] = j;
+                            ++count;
+                        }
+                    }
                 }
+                C.column_pointer[j] = count;
             }
         });
-    for (int i = 0; i < A.col_n; ++i) {
-        for (int k = 0; k < BT.col_n; ++k) {
-            double sum = 0;
-            for (int j = BT.column_pointer[k];
-                j < BT.column_pointer[k + 1]; ++j) {
-                if (x[i][BT.row[j]] > -1) {
-                    sum += A.value[x[i][BT.row[j]]] * BT.value[j];
+    // </Symbolic>
+
+    int nz = pscan::exclusive_scan_tbb(C.column_pointer.data(),
+        C.column_pointer.data(), C.column_pointer.size());
+    C.value.resize(nz);
+    C.row.resize(nz);
+    // the numeric pass marks columns with B.col_n + j, so it never sees
+    // the marks of the symbolic pass
+    std::vector<int> zeros(B.col_n + 1, 0);
+
+    // <Numeric>
+    tbb::parallel_for(tbb::blocked_range<int>(0, B.col_n),
+        [&](const tbb::blocked_range<int>& r) {
+            column_accumulator& acc = accumulators.local();
+            for (int j = r.begin(); j != r.end(); ++j) {
+                const int tag = B.col_n + j;
+                acc.touched.clear();
+                for (int kb = B.column_pointer[j];
+                    kb < B.column_pointer[j + 1]; ++kb) {
+                    const int k = B.row[kb];
+                    const double b = B.value[kb];
+                    for (int ia = A.column_pointer[k];
+                        ia < A.column_pointer[k + 1]; ++ia) {
+                        const int i = A.row[ia];
+                        if (acc.mark[i] != tag) {
+                            acc.mark[i] = tag;
+                            acc.value[i] = A.value[ia] * b;
+                            acc.touched.push_back(i);
+                        } else {
+                            acc.value[i] += A.value[ia] * b;
+                        }
+                    }
+                }
+                std::sort(acc.touched.begin(), acc.touched.end());
+                int at = C.column_pointer[j];
+                for (int i : acc.touched) {
+                    C.row[at] = i;
+                    C.value[at++] = acc.value[i];
+                    if (acc.value[i] == 0) {
+                        ++zeros[j];
+                    }
                 }
             }
-            if (std::fabs(sum) > 0) {
-                C.value.push_back(sum);
-                C.row.push_back(k);
-            }
+        });
+    // </Numeric>
+
+    // <Compaction>
+    // only when something cancelled: every column moves left by the zeros
+    // of the columns before it
+    if (pscan::exclusive_scan_tbb(zeros.data(), zeros.data(),
+        zeros.size()) > 0) {
+        CCS_matrix D;
+        D.row_n = C.row_n;
+        D.col_n = C.col_n;
+        D.column_pointer.resize(C.col_n + 1);
+        for (int j = 0; j <= C.col_n; ++j) {
+            D.column_pointer[j] = C.column_pointer[j] - zeros[j];
         }
-        C.column_pointer.push_back(C.value.size());
+        D.value.resize(D.column_pointer[C.col_n]);
+        D.row.resize(D.column_pointer[C.col_n]);
+        tbb::parallel_for(tbb::blocked_range<int>(0, C.col_n),
+            [&](const tbb::blocked_range<int>& r) {
+                for (int j = r.begin(); j != r.end(); ++j) {
+                    int at = D.column_pointer[j];
+                    for (int k = C.column_pointer[j];
+                        k < C.column_pointer[j + 1]; ++k) {
+                        if (C.value[k] != 0) {
+                            D.row[at] = C.row[k];
+                            D.value[at++] = C.value[k];
+                        }
+                    }
+                }
+            });
+        return D;
     }
+    // </Compaction>
     return C;
 }
 
+namespace {
+std::vector<double> ccs_spmm(const CCS_matrix& A,
+    const std::vector<double>& X, int k, pspmv::Backend backend) {
+    if (k <= 0 || X.size() != static_cast<size_t>(A.col_n) * k) {
+        throw("Wrong vector size for multiplication");
+    }
+    std::vector<double> Y(static_cast<size_t>(A.row_n) * k);
+    pspmv::ccs_spmm_any(backend, A.row_n, A.col_n, A.column_pointer.data(),
+        A.row.data(), A.value.data(), 0, X.data(), k, Y.data());
+    return Y;
+}
+}  // namespace
+
+std::vector<double> ccs_spmv_tbb(const CCS_matrix& A,
+    const std::vector<double>& x) {
+    return ccs_spmm(A, x, 1, pspmv::Backend::Tbb);
+}
+
+std::vector<double> ccs_spmv_std(const CCS_matrix& A,
+    const std::vector<double>& x) {
+    return ccs_spmm(A, x, 1, pspmv::Backend::Thread);
+}
+
+std::vector<double> ccs_spmm_tbb(const CCS_matrix& A,
+    const std::vector<double>& X, int k) {
+    return ccs_spmm(A, X, k, pspmv::Backend::Tbb);
+}
+
+std::vector<double> ccs_spmm_std(const CCS_matrix& A,
+    const std::vector<double>& X, int k) {
+    return ccs_spmm(A, X, k, pspmv::Backend::Thread);
+}
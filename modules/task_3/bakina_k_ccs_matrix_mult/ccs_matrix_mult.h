@@ -22,7 +22,28 @@ CCS_matrix convert_to_ccs(const std::vector<std::vector<double>>& A);
 CCS_matrix ccs_matrix_transposition(const CCS_matrix& B);
 CCS_matrix ccs_matrix_multplication(const CCS_matrix& A, const CCS_matrix& B);
 CCS_matrix ccs_matrix_transposition_tbb(const CCS_matrix& B);
+// B * A (note the order), computed by ccs_spgemm_tbb(B, A)
 CCS_matrix ccs_matrix_multplication_tbb(const CCS_matrix& A,
     const CCS_matrix& B);
+// A * B column by column, C(:, j) = sum over k of A(:, k) * B(k, j):
+// a parallel symbolic pass counts the rows of every column of C, a prefix
+// sum places the columns and a parallel numeric pass fills them in place.
+// No transpose is formed and only pairs A(i, k), B(k, j) that exist are
+// multiplied. Entries that cancel to zero are dropped
+CCS_matrix ccs_spgemm_tbb(const CCS_matrix& A, const CCS_matrix& B);
+// A * x: the columns of A are cut into chunks of about equal nonzeros,
+// every chunk scatters into its own copy of the result and the copies
+// are summed by rows (3rdparty/unapproved/ccs_spmv.h). _tbb runs on
+// tbb::parallel_for, _std on std::thread
+std::vector<double> ccs_spmv_tbb(const CCS_matrix& A,
+    const std::vector<double>& x);
+std::vector<double> ccs_spmv_std(const CCS_matrix& A,
+    const std::vector<double>& x);
+// A * X for k right-hand sides, X (col_n x k) and the result (row_n x k)
+// stored row by row; k = 4, 8, 16, 32 and 64 use kernels of fixed width
+std::vector<double> ccs_spmm_tbb(const CCS_matrix& A,
+    const std::vector<double>& X, int k);
+std::vector<double> ccs_spmm_std(const CCS_matrix& A,
+    const std::vector<double>& X, int k);
 
 #endif  // MODULES_TASK_3_BAKINA_K_CCS_MATRIX_MULT_CCS_MATRIX_MULT_H_
@@ -1,8 +1,21 @@
 // Copyright 2022 Bakina Kseniia
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "./ccs_matrix_mult.h"
 
+#define USE_EFFICIENCY_TESTS 0
+
+// columns of the sparse transpose test: by default it only checks the
+// result; with USE_EFFICIENCY_TESTS the matrix has 10M nonzeros
+#if USE_EFFICIENCY_TESTS == 1
+const int kTransposeColumns = 200000;
+#else
+const int kTransposeColumns = 4000;
+#endif
+
 TEST(Bakina_K_ccs_matrix_mult, check_matrix_transposition_small_size) {
     int n = 10, m = 15;
     std::vector<std::vector<double>> A = get_random_matrix(n, m);
@@ -136,6 +149,155 @@ TEST(Bakina_K_ccs_matrix_mult, check_matrix_multiplication_large_size2) {
     EXPECT_TRUE(C_ccs == C_check);
 }
 
+std::vector<std::vector<double>> multiply_dense(
+    const std::vector<std::vector<double>>& A,
+    const std::vector<std::vector<double>>& B) {
+    std::vector<std::vector<double>> C(A.size(),
+        std::vector<double>(B[0].size(), 0));
+    for (size_t i = 0; i < A.size(); ++i) {
+        for (size_t k = 0; k < B.size(); ++k) {
+            for (size_t j = 0; j < B[0].size(); ++j) {
+                C[i][j] += A[i][k] * B[k][j];
+            }
+        }
+    }
+    return C;
+}
+
+TEST(Bakina_K_ccs_matrix_mult, check_spgemm_rectangular) {
+    std::vector<std::vector<double>> A = get_random_matrix(40, 70);
+    std::vector<std::vector<double>> B = get_random_matrix(70, 30);
+    CCS_matrix C(ccs_spgemm_tbb(convert_to_ccs(A), convert_to_ccs(B)));
+
+    EXPECT_EQ(40, C.row_n);
+    EXPECT_EQ(30, C.col_n);
+    EXPECT_TRUE(C == convert_to_ccs(multiply_dense(A, B)));
+    EXPECT_TRUE(C == ccs_matrix_multplication(convert_to_ccs(B),
+        convert_to_ccs(A)));
+    EXPECT_ANY_THROW(ccs_spgemm_tbb(convert_to_ccs(A), convert_to_ccs(A)));
+}
+
+TEST(Bakina_K_ccs_matrix_mult, check_spgemm_drops_cancelled_entries) {
+    // C = A * B, C(0, 0) = 1 * 2 + 1 * (-2) cancels, C(1, 0) = 3 * 2
+    CCS_matrix A{2, 2, {1, 3, 1}, {0, 1, 0}, {0, 2, 3}};
+    CCS_matrix B{2, 2, {2, -2, 5}, {0, 1, 1}, {0, 2, 3}};
+    CCS_matrix expected{2, 2, {6, 5}, {1, 0}, {0, 1, 2}};
+
+    EXPECT_TRUE(ccs_spgemm_tbb(A, B) == expected);
+}
+
+TEST(Bakina_K_ccs_matrix_mult, check_spgemm_sparse_large) {
+    // 20000 x 20000 with 8 nonzeros per column, far too big for the dot
+    // product version which visits every (i, j)
+    const int n = 20000;
+    CCS_matrix A{n, n, {}, {}, {0}};
+    for (int j = 0; j < n; ++j) {
+        for (int k = 0; k < 8; ++k) {
+            A.row.push_back((j * 37 + k * 2503) % n);
+            A.value.push_back(1 + (j + k) % 5);
+        }
+        std::sort(A.row.end() - 8, A.row.end());
+        A.column_pointer.push_back(A.row.size());
+    }
+
+    tbb::tick_count t1 = tbb::tick_count::now();
+    CCS_matrix C(ccs_spgemm_tbb(A, A));
+    tbb::tick_count t2 = tbb::tick_count::now();
+    std::cout << "Column-wise TBB: " << (t2 - t1).seconds() << "\n";
+
+    // column 0 of A * A against a dense scatter
+    std::vector<double> column(n, 0);
+    for (int kb = A.column_pointer[0]; kb < A.column_pointer[1]; ++kb) {
+        int k = A.row[kb];
+        for (int ia = A.column_pointer[k]; ia < A.column_pointer[k + 1];
+            ++ia) {
+            column[A.row[ia]] += A.value[ia] * A.value[kb];
+        }
+    }
+    int at = C.column_pointer[0];
+    for (int i = 0; i < n; ++i) {
+        if (column[i] != 0) {
+            ASSERT_EQ(i, C.row[at]);
+            ASSERT_DOUBLE_EQ(column[i], C.value[at++]);
+        }
+    }
+    EXPECT_EQ(C.column_pointer[1], at);
+}
+
+TEST(Bakina_K_ccs_matrix_mult, check_matrix_transposition_sparse_large) {
+    // 50 nonzeros per column, above the cutoff of the parallel transpose
+    const int n = kTransposeColumns;
+    CCS_matrix A{n, n, {}, {}, {0}};
+    A.row.reserve(50 * n);
+    A.value.reserve(50 * n);
+    for (int j = 0; j < n; ++j) {
+        for (int k = 0; k < 50; ++k) {
+            A.row.push_back((j * 7919 + k * 3989) % n);
+            A.value.push_back(j + k);
+        }
+        std::sort(A.row.end() - 50, A.row.end());
+        A.column_pointer.push_back(A.row.size());
+    }
+
+    tbb::tick_count t1 = tbb::tick_count::now();
+    CCS_matrix AT_ccs(ccs_matrix_transposition(A));
+    tbb::tick_count t2 = tbb::tick_count::now();
+    CCS_matrix AT_check(ccs_matrix_transposition_tbb(A));
+    tbb::tick_count t3 = tbb::tick_count::now();
+    std::cout << "Sequential: " << (t2 - t1).seconds() << "\n";
+    std::cout << "Counting TBB: " << (t3 - t2).seconds() << "\n";
+
+    EXPECT_TRUE(AT_check == AT_ccs);
+}
+
+TEST(Bakina_K_ccs_matrix_mult, check_spmv) {
+    std::vector<std::vector<double>> A = get_random_matrix(500, 700);
+    std::vector<double> x(700);
+    for (int j = 0; j < 700; ++j) {
+        x[j] = j % 7 - 3;
+    }
+    std::vector<double> expected(500, 0);
+    for (int i = 0; i < 500; ++i) {
+        for (int j = 0; j < 700; ++j) {
+            expected[i] += A[i][j] * x[j];
+        }
+    }
+    // enough nonzeros for the chunks, the values keep the sums exact
+    CCS_matrix A_ccs(convert_to_ccs(A));
+    tbb::task_arena arena(4);
+    std::vector<double> y;
+    arena.execute([&] { y = ccs_spmv_tbb(A_ccs, x); });
+    EXPECT_EQ(expected, y);
+    EXPECT_EQ(expected, ccs_spmv_std(A_ccs, x));
+    EXPECT_ANY_THROW(ccs_spmv_tbb(A_ccs, std::vector<double>(500)));
+}
+
+TEST(Bakina_K_ccs_matrix_mult, check_spmm) {
+    std::vector<std::vector<double>> A = get_random_matrix(300, 400);
+    CCS_matrix A_ccs(convert_to_ccs(A));
+    tbb::task_arena arena(4);
+    // 3 takes the kernel of any width, 8 and 64 the fixed ones
+    for (int k : {3, 8, 64}) {
+        std::vector<double> X(400 * k);
+        for (size_t j = 0; j < X.size(); ++j) {
+            X[j] = static_cast<int>(j % 11) - 5;
+        }
+        std::vector<double> expected(300 * k, 0);
+        for (int i = 0; i < 300; ++i) {
+            for (int j = 0; j < 400; ++j) {
+                for (int c = 0; c < k; ++c) {
+                    expected[i * k + c] += A[i][j] * X[j * k + c];
+                }
+            }
+        }
+        std::vector<double> Y;
+        arena.execute([&] { Y = ccs_spmm_tbb(A_ccs, X, k); });
+        EXPECT_EQ(expected, Y) << k;
+        EXPECT_EQ(expected, ccs_spmm_std(A_ccs, X, k)) << k;
+    }
+    EXPECT_ANY_THROW(ccs_spmm_std(A_ccs, std::vector<double>(400 * 4), 5));
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
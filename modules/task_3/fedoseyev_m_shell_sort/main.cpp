@@ -2,8 +2,70 @@
 #include <gtest/gtest.h>
 #include <omp.h>
 
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./sample_sort.h"
+#include "./segmented_sort.h"
 #include "./shell_sort.h"
 
+std::vector<int> uniform_keys(int n) {
+  std::mt19937 gen(1);
+  std::vector<int> v(n);
+  for (int& x : v) x = static_cast<int>(gen());
+  return v;
+}
+
+// Zipf(1.1) over 100000 distinct keys
+std::vector<int> zipf_keys(int n) {
+  const int distinct = 100000;
+  std::vector<double> weights(distinct);
+  for (int k = 0; k < distinct; k++) weights[k] = 1.0 / std::pow(k + 1, 1.1);
+  std::discrete_distribution<int> dist(weights.begin(), weights.end());
+  std::mt19937 gen(2);
+  std::vector<int> v(n);
+  for (int& x : v) x = dist(gen) * 7919 % distinct;
+  return v;
+}
+
+// sorted with 1% of the positions swapped at random
+std::vector<int> nearly_sorted_keys(int n) {
+  std::mt19937 gen(3);
+  std::vector<int> v(n);
+  for (int i = 0; i < n; i++) v[i] = i;
+  for (int i = 0; i < n / 100; i++) std::swap(v[gen() % n], v[gen() % n]);
+  return v;
+}
+
+void compare_sorts(const std::string& name, const std::vector<int>& input) {
+  int n = static_cast<int>(input.size());
+  std::vector<int> a = input, b = input, c = input;
+
+  double start = omp_get_wtime();
+  sample_sort(a.data(), a.size());
+  double sample_time = omp_get_wtime() - start;
+
+  start = omp_get_wtime();
+  tbb::parallel_sort(b.begin(), b.end());
+  double tbb_time = omp_get_wtime() - start;
+
+  start = omp_get_wtime();
+  shell_sort(c.data(), n, false);
+  double shell_time = omp_get_wtime() - start;
+
+  std::cout << "\t" << name << ": sample sort " << sample_time
+            << ", tbb::parallel_sort " << tbb_time << ", shell sort "
+            << shell_time << "\n";
+  ASSERT_EQ(b, a);
+  ASSERT_EQ(b, c);
+}
+
 TEST(SHELL_SORT_TBB, TEST_1) {
   int size = 5;
   int* a = generate_vector(size);
@@ -66,3 +128,120 @@ TEST(SHELL_SORT_TBB, SIZE_BIG) {
   delete[] a;
   delete[] b;
 }
+
+TEST(SAMPLE_SORT_TBB, UNIFORM_ZIPF_NEARLY_SORTED) {
+  for (int n : {1, 100, 50000, 300001}) {
+    std::vector<std::vector<int>> inputs = {uniform_keys(n), zipf_keys(n),
+                                            nearly_sorted_keys(n)};
+    for (auto& v : inputs) {
+      std::vector<int> expected = v;
+      std::sort(expected.begin(), expected.end());
+      sample_sort(v.data(), v.size());
+      ASSERT_EQ(expected, v);
+    }
+  }
+}
+
+TEST(SAMPLE_SORT_TBB, ALL_EQUAL_AND_TWO_KEYS) {
+  std::vector<int> v(200000, 5);
+  sample_sort(v.data(), v.size());
+  ASSERT_EQ(std::vector<int>(200000, 5), v);
+  for (std::size_t i = 0; i < v.size(); i++) v[i] = (i * 7) % 2;
+  sample_sort(v.data(), v.size(), 4, 64);
+  ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+  ASSERT_EQ(100000, std::count(v.begin(), v.end(), 0));
+}
+
+TEST(SAMPLE_SORT_TBB, COMPARATOR_AND_DOUBLES) {
+  std::mt19937 gen(4);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> v(100000);
+  for (double& x : v) x = dist(gen);
+  std::vector<double> expected = v;
+  std::sort(expected.begin(), expected.end(), std::greater<double>());
+  sample_sort(v.data(), v.size(), 8, 0, std::greater<double>());
+  ASSERT_EQ(expected, v);
+}
+
+TEST(SAMPLE_SORT_TBB, BENCHMARK) {
+  const int n = 1 << 20;
+  compare_sorts("uniform", uniform_keys(n));
+  compare_sorts("zipf", zipf_keys(n));
+  compare_sorts("nearly sorted", nearly_sorted_keys(n));
+}
+
+// values of random segments with sizes in [min_size, max_size]
+void random_segments(int segments, int min_size, int max_size,
+                     std::vector<int>* values, std::vector<int>* offsets) {
+  std::mt19937 gen(segments);
+  std::uniform_int_distribution<int> size(min_size, max_size);
+  offsets->assign(1, 0);
+  for (int s = 0; s < segments; s++)
+    offsets->push_back(offsets->back() + size(gen));
+  *values = uniform_keys(offsets->back());
+}
+
+void sort_each_segment(std::vector<int>* values,
+                       const std::vector<int>& offsets) {
+  for (size_t s = 0; s + 1 < offsets.size(); s++)
+    std::sort(values->begin() + offsets[s], values->begin() + offsets[s + 1]);
+}
+
+TEST(SEGMENTED_SORT_TBB, NETWORKS_ZERO_ONE_PRINCIPLE) {
+  // a network sorts everything iff it sorts every 0/1 input
+  for (std::size_t n = 0; n <= 16; n++) {
+    for (uint32_t bits = 0; bits < (1u << n); bits++) {
+      int a[16];
+      for (std::size_t i = 0; i < n; i++) a[i] = (bits >> i) & 1;
+      segmented::network_sort(a, n, std::less<int>());
+      ASSERT_TRUE(std::is_sorted(a, a + n)) << n << " " << bits;
+    }
+  }
+  for (std::size_t n = 17; n <= segmented::kNetworkLimit; n++) {
+    std::vector<int> a = uniform_keys(n);
+    segmented::network_sort(a.data(), n, std::less<int>());
+    ASSERT_TRUE(std::is_sorted(a.begin(), a.end())) << n;
+  }
+}
+
+TEST(SEGMENTED_SORT_TBB, ALL_SEGMENT_SIZES) {
+  std::vector<int> values, offsets;
+  random_segments(5000, 0, 5000, &values, &offsets);
+  std::vector<int> expected(values);
+  sort_each_segment(&expected, offsets);
+  segmented_sort(values.data(), offsets.data(), offsets.size() - 1);
+  ASSERT_EQ(expected, values);
+}
+
+TEST(SEGMENTED_SORT_TBB, SUB_RANGE_COMPARATOR_AND_DOUBLES) {
+  std::vector<double> values = {5, 4, 3, 9, 1, 7, 7, 2, 8, 6, 0};
+  std::vector<std::size_t> offsets = {1, 4, 4, 9};
+  segmented_sort(values.data(), offsets.data(), 3, std::greater<double>());
+  ASSERT_EQ(std::vector<double>({5, 9, 4, 3, 8, 7, 7, 2, 1, 6, 0}), values);
+}
+
+TEST(SEGMENTED_SORT_TBB, BENCHMARK_SMALL_SEGMENTS) {
+  std::vector<int> values, offsets;
+  random_segments(1000000, 16, 64, &values, &offsets);
+  std::vector<int> expected(values), by_std(values);
+
+  double start = omp_get_wtime();
+  sort_each_segment(&expected, offsets);
+  double seq_time = omp_get_wtime() - start;
+
+  start = omp_get_wtime();
+  tbb::parallel_for(std::size_t(0), offsets.size() - 1, [&](std::size_t s) {
+    std::sort(by_std.begin() + offsets[s], by_std.begin() + offsets[s + 1]);
+  });
+  double std_time = omp_get_wtime() - start;
+
+  start = omp_get_wtime();
+  segmented_sort(values.data(), offsets.data(), offsets.size() - 1);
+  double seg_time = omp_get_wtime() - start;
+
+  std::cout << "1M segments of 16..64 keys: std::sort " << seq_time
+            << " s, parallel_for + std::sort " << std_time
+            << " s, segmented_sort " << seg_time << " s" << std::endl;
+  ASSERT_EQ(expected, values);
+  ASSERT_EQ(expected, by_std);
+}
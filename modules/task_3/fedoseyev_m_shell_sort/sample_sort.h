@@ -0,0 +1,130 @@
+// Copyright 2022 Fedoseyev Mikhail
+#ifndef MODULES_TASK_3_FEDOSEYEV_M_SHELL_SORT_SAMPLE_SORT_H_
+#define MODULES_TASK_3_FEDOSEYEV_M_SHELL_SORT_SAMPLE_SORT_H_
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+// Parallel sample sort: splitters are picked from oversampling * buckets
+// random samples, every element is routed to its bucket in one
+// classification pass, and the buckets are sorted independently, so
+// there is no merge phase. Splitters that repeat in the sample get an
+// equality bucket of their own, which needs no sorting at all, so heavy
+// duplicate keys (Zipf-like data) do not overload a single bucket.
+// buckets == 0 picks 4 buckets per worker thread.
+template <class T, class Compare = std::less<T>>
+void sample_sort(T* data, std::size_t n, std::size_t oversampling = 32,
+                 std::size_t buckets = 0, Compare comp = Compare()) {
+  const std::size_t kSequentialCutoff = 1 << 14;
+  if (n < 2) return;
+
+  // already sorted input (a common case for nearly sorted data) is
+  // detected with a single parallel pass
+  bool sorted = tbb::parallel_reduce(
+      tbb::blocked_range<std::size_t>(1, n), true,
+      [&](const tbb::blocked_range<std::size_t>& r, bool ok) {
+        for (std::size_t i = r.begin(); i < r.end() && ok; i++)
+          ok = !comp(data[i], data[i - 1]);
+        return ok;
+      },
+      [](bool a, bool b) { return a && b; });
+  if (sorted) return;
+
+  if (n < kSequentialCutoff) {
+    std::sort(data, data + n, comp);
+    return;
+  }
+
+  const std::size_t threads = tbb::this_task_arena::max_concurrency();
+  if (buckets == 0) buckets = 4 * threads;
+  buckets = std::max<std::size_t>(2, std::min(buckets, n / 1024));
+  oversampling = std::max<std::size_t>(1, oversampling);
+
+  // <Splitters>
+  std::vector<T> sample(buckets * oversampling);
+  std::mt19937_64 gen(n);
+  std::uniform_int_distribution<std::size_t> pick(0, n - 1);
+  for (T& s : sample) s = data[pick(gen)];
+  std::sort(sample.begin(), sample.end(), comp);
+
+  std::vector<T> splitters;
+  for (std::size_t i = 1; i < buckets; i++) {
+    const T& s = sample[i * oversampling];
+    if (splitters.empty() || comp(splitters.back(), s))
+      splitters.push_back(s);
+  }
+  // </Splitters>
+
+  // bucket 2i holds keys between splitters i - 1 and i,
+  // bucket 2i + 1 holds keys equal to splitter i
+  const std::size_t num_buckets = 2 * splitters.size() + 1;
+  auto classify = [&](const T& x) -> uint32_t {
+    std::size_t i =
+        std::lower_bound(splitters.begin(), splitters.end(), x, comp) -
+        splitters.begin();
+    bool equal = i < splitters.size() && !comp(x, splitters[i]);
+    return static_cast<uint32_t>(2 * i + (equal ? 1 : 0));
+  };
+
+  // <Classification>
+  const std::size_t chunks = std::min(4 * threads, n / 1024 + 1);
+  auto chunk_begin = [n, chunks](std::size_t c) { return n * c / chunks; };
+  std::vector<uint32_t> ids(n);
+  // counts[c * num_buckets + b]: elements of chunk c going to bucket b,
+  // turned into write cursors by the prefix sum below
+  std::vector<std::size_t> counts(chunks * num_buckets, 0);
+  tbb::parallel_for(std::size_t(0), chunks, [&](std::size_t c) {
+    std::size_t* count = counts.data() + c * num_buckets;
+    for (std::size_t i = chunk_begin(c); i < chunk_begin(c + 1); i++) {
+      ids[i] = classify(data[i]);
+      count[ids[i]]++;
+    }
+  });
+
+  std::vector<std::size_t> bucket_begin(num_buckets + 1);
+  std::size_t offset = 0;
+  for (std::size_t b = 0; b < num_buckets; b++) {
+    bucket_begin[b] = offset;
+    for (std::size_t c = 0; c < chunks; c++) {
+      std::size_t tmp = counts[c * num_buckets + b];
+      counts[c * num_buckets + b] = offset;
+      offset += tmp;
+    }
+  }
+  bucket_begin[num_buckets] = n;
+
+  std::vector<T> buffer(n);
+  tbb::parallel_for(std::size_t(0), chunks, [&](std::size_t c) {
+    std::size_t* cursor = counts.data() + c * num_buckets;
+    for (std::size_t i = chunk_begin(c); i < chunk_begin(c + 1); i++)
+      buffer[cursor[ids[i]]++] = data[i];
+  });
+  // </Classification>
+
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0, num_buckets, 1),
+      [&](const tbb::blocked_range<std::size_t>& r) {
+        for (std::size_t b = r.begin(); b < r.end(); b++) {
+          T* first = buffer.data() + bucket_begin[b];
+          T* last = buffer.data() + bucket_begin[b + 1];
+          // a bucket holding most of the keys means poor splitters,
+          // it is sorted in parallel instead of by a single thread
+          if (b % 2 == 0 && static_cast<std::size_t>(last - first) > n / 2)
+            tbb::parallel_sort(first, last, comp);
+          else if (b % 2 == 0)
+            std::sort(first, last, comp);
+          std::copy(first, last, data + bucket_begin[b]);
+        }
+      });
+}
+
+#endif  // MODULES_TASK_3_FEDOSEYEV_M_SHELL_SORT_SAMPLE_SORT_H_
@@ -0,0 +1,203 @@
+// Copyright 2022 Fedoseyev Mikhail
+#ifndef MODULES_TASK_3_FEDOSEYEV_M_SHELL_SORT_SEGMENTED_SORT_H_
+#define MODULES_TASK_3_FEDOSEYEV_M_SHELL_SORT_SEGMENTED_SORT_H_
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace segmented {
+
+const std::size_t kNetworkLimit = 32;
+const std::size_t kMergeLimit = 4096;
+// segments are handed to TBB in chunks of about this many elements
+const std::size_t kChunkElements = 1 << 15;
+
+// Batcher's odd-even merge sort for N keys, unrolled at compile time:
+// the network for the next power of two with the comparators that touch
+// a missing key dropped (a missing key acts as +infinity and would never
+// move). The templates below walk the loops
+//   for (p = 1; p < N; p += p)
+//     for (k = p; k > 0; k /= 2)
+//       for (j = k % p; j + k < N; j += k + k)
+//         for (i = 0; i < k && i + j + k < N; i++)
+//           if ((i + j) / (p + p) == (i + j + k) / (p + p))
+//             compare_exchange(i + j, i + j + k)
+// so every network is a straight line of compare-exchanges on constant
+// indices, which the compiler keeps in registers
+template <std::size_t X, std::size_t Y, class T, class Compare>
+inline void compare_exchange(T* a, Compare& comp) {
+  // written as selects so that the compiler can use conditional moves
+  T x = a[X], y = a[Y];
+  bool swap = comp(y, x);
+  a[X] = swap ? y : x;
+  a[Y] = swap ? x : y;
+}
+
+template <std::size_t N, std::size_t P, std::size_t K, std::size_t J,
+          std::size_t I, bool = (I < K && I + J + K < N)>
+struct Exchanges {
+  template <class T, class Compare>
+  static inline void apply(T* a, Compare& comp) {
+    if ((I + J) / (P + P) == (I + J + K) / (P + P))
+      compare_exchange<I + J, I + J + K>(a, comp);
+    Exchanges<N, P, K, J, I + 1>::apply(a, comp);
+  }
+};
+template <std::size_t N, std::size_t P, std::size_t K, std::size_t J,
+          std::size_t I>
+struct Exchanges<N, P, K, J, I, false> {
+  template <class T, class Compare>
+  static inline void apply(T*, Compare&) {}
+};
+
+template <std::size_t N, std::size_t P, std::size_t K, std::size_t J,
+          bool = (J + K < N)>
+struct Groups {
+  template <class T, class Compare>
+  static inline void apply(T* a, Compare& comp) {
+    Exchanges<N, P, K, J, 0>::apply(a, comp);
+    Groups<N, P, K, J + K + K>::apply(a, comp);
+  }
+};
+template <std::size_t N, std::size_t P, std::size_t K, std::size_t J>
+struct Groups<N, P, K, J, false> {
+  template <class T, class Compare>
+  static inline void apply(T*, Compare&) {}
+};
+
+template <std::size_t N, std::size_t P, std::size_t K, bool = (K > 0)>
+struct Steps {
+  template <class T, class Compare>
+  static inline void apply(T* a, Compare& comp) {
+    Groups<N, P, K, K % P>::apply(a, comp);
+    Steps<N, P, K / 2>::apply(a, comp);
+  }
+};
+template <std::size_t N, std::size_t P, std::size_t K>
+struct Steps<N, P, K, false> {
+  template <class T, class Compare>
+  static inline void apply(T*, Compare&) {}
+};
+
+template <std::size_t N, std::size_t P = 1, bool = (P < N)>
+struct Network {
+  template <class T, class Compare>
+  static inline void apply(T* a, Compare& comp) {
+    Steps<N, P, P>::apply(a, comp);
+    Network<N, P + P>::apply(a, comp);
+  }
+};
+template <std::size_t N, std::size_t P>
+struct Network<N, P, false> {
+  template <class T, class Compare>
+  static inline void apply(T*, Compare&) {}
+};
+
+template <std::size_t N, class T, class Compare>
+void fixed_network_sort(T* a, Compare comp) {
+  Network<N>::apply(a, comp);
+}
+
+// fills table[0, N] with the sorters for 0..N keys
+template <std::size_t N, class T, class Compare>
+struct NetworkTable {
+  static void fill(void (**table)(T*, Compare)) {
+    table[N] = &fixed_network_sort<N, T, Compare>;
+    NetworkTable<N - 1, T, Compare>::fill(table);
+  }
+};
+template <class T, class Compare>
+struct NetworkTable<0, T, Compare> {
+  static void fill(void (**table)(T*, Compare)) {
+    table[0] = &fixed_network_sort<0, T, Compare>;
+  }
+};
+
+// sorts n <= kNetworkLimit keys with the unrolled network for n
+template <class T, class Compare>
+void network_sort(T* a, std::size_t n, Compare comp) {
+  struct Table {
+    void (*sort[kNetworkLimit + 1])(T*, Compare);
+    Table() { NetworkTable<kNetworkLimit, T, Compare>::fill(sort); }
+  };
+  static const Table table;
+  table.sort[n](a, comp);
+}
+
+// Blocks of kNetworkLimit keys are sorted by the network, then merged
+// pairwise, bouncing between a and scratch (at least n keys)
+template <class T, class Compare>
+void block_merge_sort(T* a, std::size_t n, T* scratch, Compare comp) {
+  for (std::size_t b = 0; b < n; b += kNetworkLimit)
+    network_sort(a + b, std::min(kNetworkLimit, n - b), comp);
+  T* src = a;
+  T* dst = scratch;
+  for (std::size_t width = kNetworkLimit; width < n; width *= 2) {
+    for (std::size_t lo = 0; lo < n; lo += 2 * width) {
+      std::size_t mid = std::min(lo + width, n);
+      std::size_t hi = std::min(lo + 2 * width, n);
+      std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, comp);
+    }
+    std::swap(src, dst);
+  }
+  if (src != a) std::copy(src, src + n, a);
+}
+
+template <class T, class Compare>
+void sort_segment(T* a, std::size_t n, T* scratch, Compare comp) {
+  if (n <= kNetworkLimit)
+    network_sort(a, n, comp);
+  else if (n <= kMergeLimit)
+    block_merge_sort(a, n, scratch, comp);
+  else
+    std::sort(a, a + n, comp);
+}
+
+}  // namespace segmented
+
+// Sorts every segment values[offsets[s], offsets[s + 1]) on its own,
+// s < segments (offsets holds segments + 1 entries, CRS row pointers for
+// example). Chunks of whole segments with similar element counts are
+// sorted in parallel. Segments of up to 32 keys go through a sorting
+// network, longer ones up to 4096 keys are merged from network-sorted
+// blocks; nothing is allocated per segment
+template <class T, class Offset, class Compare = std::less<T>>
+void segmented_sort(T* values, const Offset* offsets, std::size_t segments,
+                    Compare comp = Compare()) {
+  if (segments == 0) return;
+  const std::size_t first = offsets[0];
+  const std::size_t total = offsets[segments] - offsets[0];
+  const std::size_t chunks = total / segmented::kChunkElements + 1;
+
+  // chunk c starts at the first segment that begins at or after
+  // c * total / chunks elements
+  auto chunk_begin = [&](std::size_t c) -> std::size_t {
+    if (c == chunks) return segments;
+    std::size_t at = first + total * c / chunks;
+    return std::lower_bound(offsets, offsets + segments, at,
+                            [](Offset o, std::size_t v) {
+                              return static_cast<std::size_t>(o) < v;
+                            }) -
+           offsets;
+  };
+
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0, chunks),
+      [&](const tbb::blocked_range<std::size_t>& r) {
+        // one scratch buffer per task, shared by all its segments
+        std::vector<T> scratch(segmented::kMergeLimit);
+        std::size_t end = chunk_begin(r.end());
+        for (std::size_t s = chunk_begin(r.begin()); s < end; s++)
+          segmented::sort_segment(values + offsets[s],
+                                  offsets[s + 1] - offsets[s],
+                                  scratch.data(), comp);
+      });
+}
+
+#endif  // MODULES_TASK_3_FEDOSEYEV_M_SHELL_SORT_SEGMENTED_SORT_H_
@@ -1,6 +1,7 @@
 // Copyright 2022 Kim Nikita
 #include <gtest/gtest.h>
 // #include <tbb/tick_count.h>
+#include <algorithm>
 #include <vector>
 #include "./radix_sort.h"
 
@@ -88,6 +89,47 @@ TEST(TBB, Vector_Mega_Large_Size) {
   // EXPECT_EQ(t1_res / t2_res, 0);
 }
 
+TEST(TBB, Vector_Many_Leaves_Matches_Std_Sort) {
+  int size = 300007;
+  std::vector<int> input_vec = getRandomVector(size);
+  input_vec[0] = 123456789;
+  input_vec[1] = -123456789;
+
+  std::vector<int> exp_res(input_vec);
+  std::sort(exp_res.begin(), exp_res.end());
+
+  std::vector<int> res = radixSortParallel(input_vec, size);
+
+  ASSERT_EQ(exp_res, res);
+}
+
+TEST(TBB, Sort_Tree_Result_In_Scratch) {
+  int size = 50000;
+  std::vector<int> input_vec = getRandomVector(size);
+  std::vector<int> data(input_vec), scratch(size);
+
+  sortTree(data.data(), scratch.data(), size, 1000, getMax(data, size),
+           false);
+
+  std::sort(input_vec.begin(), input_vec.end());
+  ASSERT_EQ(input_vec, scratch);
+}
+
+TEST(TBB, Parallel_Merge_Uneven_Runs) {
+  std::vector<int> a = getRandomVector(100000);
+  std::vector<int> b = getRandomVector(3);
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  std::vector<int> res(a.size() + b.size());
+
+  parallelMerge(a.data(), a.size(), b.data(), b.size(), res.data());
+
+  std::vector<int> exp_res(a);
+  exp_res.insert(exp_res.end(), b.begin(), b.end());
+  std::sort(exp_res.begin(), exp_res.end());
+  ASSERT_EQ(exp_res, res);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
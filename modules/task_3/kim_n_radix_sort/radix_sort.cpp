@@ -2,27 +2,27 @@
 
 #include "../../../modules/task_3/kim_n_radix_sort/radix_sort.h"
 #include <omp.h>
-#include <tbb/task.h>
-#include <tbb/task_scheduler_init.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/scalable_allocator.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+#include <algorithm>
+#include <cstdint>
 #include <vector>
-#include <deque>
 #include <random>
 
+namespace {
+// smallest piece sorted by a single task
+const int kLeafSize = 1 << 11;
+// merges shorter than this are not split any further
+const int kMergeCutoff = 1 << 13;
 
-tbb::task* RootTask::execute() {
-  return NULL;
+// decimal digit of x at place, shifted from -9..9 to 0..18
+inline int digitOf(int x, int64_t place) {
+  return static_cast<int>(x / place % 10) + 9;
 }
+}  // namespace
 
-tbb::task* RadixTask::execute() {
-  for (int i = 0; i < size; i++) {
-    res->push_back(start[i]);
-  }
-  for (int place = 1; max_value / place > 0; place *= 10) {
-    *res = countSort(*res, size, place);
-  }
-
-  return NULL;
-}
 
 std::vector<int> getRandomVector(int size) {
   std::random_device dev;
@@ -36,7 +36,7 @@ std::vector<int> getRandomVector(int size) {
   return res;
 }
 
-int getMax(std::vector<int> input_vec, int size) {
+int getMax(const std::vector<int>& input_vec, int size) {
   int max = abs(input_vec[0]);
   for (int i = 1; i < size; i++)
     if (abs(input_vec[i]) > max)
@@ -101,35 +101,87 @@ std::vector<int> radixSort(const std::vector<int>& input_vec, int size) {
   return res;
 }
 
-std::vector<int> radixSortParallel(const std::vector<int>& input_vec, int size) {
-  int proc = omp_get_num_procs();
-  // int proc = 2;
-  int chunk = size / proc;
-  int i = 0;
-  int max_value = getMax(input_vec, size);
-  std::deque<std::vector<int>> res;
-  tbb::task_scheduler_init init(proc);
-  for (int i = 0; i < proc; i++) {
-    res.push_back(std::vector<int>());
+void radixSortRange(int* data, int* buf, int size, int max_value) {
+  int* src = data;
+  int* dst = buf;
+  for (int64_t place = 1; max_value / place > 0; place *= 10) {
+    int digits[19] = { 0 };
+    for (int i = 0; i < size; i++)
+      digits[digitOf(src[i], place)]++;
+    for (int i = 1; i < 19; i++)
+      digits[i] += digits[i - 1];
+    for (int i = size - 1; i >= 0; i--)
+      dst[--digits[digitOf(src[i], place)]] = src[i];
+    std::swap(src, dst);
   }
+  if (src != data)
+    std::copy(src, src + size, data);
+}
 
-  RootTask& root = *new(tbb::task::allocate_root()) RootTask();
-  root.set_ref_count(proc + 1);
+void parallelMerge(const int* a, int a_size, const int* b, int b_size,
+                   int* out) {
+  if (a_size + b_size <= kMergeCutoff) {
+    std::merge(a, a + a_size, b, b + b_size, out);
+    return;
+  }
+  // split the longer run in half and find the matching point of the other
+  // one, equal keys of a stay in front of equal keys of b
+  int a_mid, b_mid;
+  if (a_size >= b_size) {
+    a_mid = a_size / 2;
+    b_mid = std::lower_bound(b, b + b_size, a[a_mid]) - b;
+  } else {
+    b_mid = b_size / 2;
+    a_mid = std::upper_bound(a, a + a_size, b[b_mid]) - a;
+  }
+  tbb::parallel_invoke(
+      [=] { parallelMerge(a, a_mid, b, b_mid, out); },
+      [=] {
+        parallelMerge(a + a_mid, a_size - a_mid, b + b_mid, b_size - b_mid,
+                      out + a_mid + b_mid);
+      });
+}
 
-  for (; i < proc-1; i++) {
-    RadixTask& task = *new(root.allocate_child()) RadixTask(&input_vec[i * chunk], chunk, &res[i], max_value);
-    tbb::task::spawn(task);
+void sortTree(int* src, int* dst, int size, int leaf_size, int max_value,
+              bool to_src) {
+  if (size <= leaf_size) {
+    radixSortRange(src, dst, size, max_value);
+    if (!to_src)
+      std::copy(src, src + size, dst);
+    return;
   }
-  RadixTask& task = *new(root.allocate_child()) RadixTask(&input_vec[i * chunk], size - i * chunk, &res[i], max_value);
-  tbb::task::spawn(task);
+  // children leave their halves in the buffer this level merges from
+  int half = size / 2;
+  tbb::task_group group;
+  group.run([=] {
+    sortTree(src, dst, half, leaf_size, max_value, !to_src);
+  });
+  sortTree(src + half, dst + half, size - half, leaf_size, max_value,
+           !to_src);
+  group.wait();
+
+  if (to_src)
+    parallelMerge(dst, half, dst + half, size - half, src);
+  else
+    parallelMerge(src, half, src + half, size - half, dst);
+}
 
-  root.wait_for_all();
+std::vector<int> radixSortParallel(const std::vector<int>& input_vec,
+                                   int size) {
+  std::vector<int> res(input_vec.begin(), input_vec.begin() + size);
+  if (size < 2)
+    return res;
 
-  for (int i = 0; i < proc - 1; i++) {
-    res.push_back(std::vector<int>());
-    getMergedVector(res[0], res[1], &res.back());
-    res.pop_front();
-    res.pop_front();
-  }
-  return res[0];
+  int proc = omp_get_num_procs();
+  int max_value = getMax(input_vec, size);
+  // about four leaves per thread so that idle threads can steal work
+  int leaf_size = std::max(kLeafSize, size / (4 * proc));
+  // the only scratch memory of the whole sort, shared by all levels
+  std::vector<int, tbb::scalable_allocator<int>> scratch(size);
+
+  tbb::task_arena arena(proc);
+  arena.execute([&] {
+    sortTree(res.data(), scratch.data(), size, leaf_size, max_value, true);
+  });
+  return res;
 }
@@ -2,30 +2,11 @@
 #ifndef MODULES_TASK_3_KIM_N_RADIX_SORT_RADIX_SORT_H_
 #define MODULES_TASK_3_KIM_N_RADIX_SORT_RADIX_SORT_H_
 
-#include <tbb/task.h>
 #include <vector>
-#include <deque>
-
-class RootTask : public tbb::task {
- public:
-    RootTask() {}
-    tbb::task* execute();
-};
-
-class RadixTask : public tbb::task {
- public:
-    int max_value;
-    const int size;
-    const int* start;
-    std::vector<int>* res;
-    RadixTask(const int* start_, const int size_,  std::vector<int>* res_, int max_value_) :
-      max_value(max_value_), size(size_), start(start_), res(res_) {}
-    tbb::task* execute();
-};
 
 std::vector<int> getRandomVector(int size);
 
-int getMax(std::vector<int> input_vec, int size);
+int getMax(const std::vector<int>& input_vec, int size);
 
 void getMergedVector(const std::vector<int>& a, const std::vector<int>& b, std::vector<int>* res);
 
@@ -33,6 +14,21 @@ std::vector<int> countSort(const std::vector<int>& input_vec, int size, int plac
 
 std::vector<int> radixSort(const std::vector<int>& input_vec, int size);
 
+// Sorts [data, data + size) by decimal digits, buf is scratch of the same
+// size. Nothing is allocated, the result is left in data
+void radixSortRange(int* data, int* buf, int size, int max_value);
+
+// Merges [a, a + a_size) and [b, b + b_size) into out; large merges are
+// split by binary search and both halves are merged in parallel
+void parallelMerge(const int* a, int a_size, const int* b, int b_size,
+                   int* out);
+
+// Merge sort tree over [src, src + size): leaves are radix sorted, every
+// level merges from one buffer into the other (ping-pong), so the result
+// ends up in src when to_src is true and in dst otherwise
+void sortTree(int* src, int* dst, int size, int leaf_size, int max_value,
+              bool to_src);
+
 std::vector<int> radixSortParallel(const std::vector<int>& input_vec, int size);
 
 #endif  // MODULES_TASK_3_KIM_N_RADIX_SORT_RADIX_SORT_H_
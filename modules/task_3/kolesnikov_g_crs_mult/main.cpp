@@ -1,8 +1,45 @@
 // Copyright 2022 Kolesnikov Gleb
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
 //  #include <tbb/task_arena.h>
 #include "tbb/tbb.h"
 #include "./crs_mult.h"
+#include "./reorder.h"
+#include "./sparse_ops.h"
+#include "./spmv.h"
+
+#define USE_SPMV_BENCHMARK 0
+
+// rows of random length (0 .. 2 * avg nonzeros) and one very long row,
+// built straight in CRS form
+MatrixCRS randomCRS(int nRows, int nCols, int avg, int longRow) {
+    std::mt19937 gen(nRows + nCols);
+    MatrixCRS A(nCols, nRows);
+    A.pointers.push_back(0);
+    for (int i = 0; i < nRows; i++) {
+        int length = i == longRow ? nCols
+                                  : static_cast<int>(gen() % (2 * avg + 1));
+        for (int j = 0; j < length; j++) {
+            int col = i == longRow ? j : static_cast<int>(gen() % nCols);
+            A.columns.push_back(col);
+            A.values.push_back(static_cast<double>(gen() % 100) / 10 - 5);
+        }
+        A.pointers.push_back(A.values.size());
+    }
+    return A;
+}
+
+std::vector<double> referenceSpmv(const MatrixCRS& A,
+    const std::vector<double>& x) {
+    std::vector<double> y(A.nRows, 0);
+    for (int i = 0; i < A.nRows; i++)
+        for (int j = A.pointers[i]; j < A.pointers[i + 1]; j++)
+            y[i] += A.values[j] * x[A.columns[j]];
+    return y;
+}
 
 
 
@@ -113,6 +150,333 @@ TEST(MatrixCRS_tbb, mult_crs_tbb) {
   */
 }
 
+TEST(MatrixCRS_tbb, spmv_matches_dense) {
+    std::vector<std::vector<double>> v = generateMatrix(53, 37, 0.3);
+    std::vector<std::vector<double>> x(53, std::vector<double>(1));
+    std::vector<double> xv(53);
+    for (int i = 0; i < 53; i++)
+        x[i][0] = xv[i] = i % 7 - 3;
+    std::vector<std::vector<double>> y = multMatrix(v, x);
+    std::vector<double> yTbb = spmv(MatrixCRS(v), xv, SpmvBackend::Tbb);
+    std::vector<double> yThr = spmv(MatrixCRS(v), xv, SpmvBackend::Thread);
+    for (int i = 0; i < 37; i++) {
+        EXPECT_NEAR(y[i][0], yTbb[i], 1e-9);
+        EXPECT_NEAR(y[i][0], yThr[i], 1e-9);
+    }
+}
+
+TEST(MatrixCRS_tbb, spmv_splits_long_rows) {
+    // a 200000-entry row among 100000 short and empty ones is cut between
+    // several chunks
+    MatrixCRS A = randomCRS(100000, 200000, 3, 777);
+    std::vector<double> x(A.nColumns);
+    for (int i = 0; i < A.nColumns; i++)
+        x[i] = (i % 11) * 0.25;
+    std::vector<double> expected = referenceSpmv(A, x);
+    std::vector<double> y;
+    tbb::task_arena arena(4);
+    arena.execute([&] { y = spmv(A, x); });
+    ASSERT_EQ(expected.size(), y.size());
+    for (int i = 0; i < A.nRows; i++)
+        ASSERT_NEAR(expected[i], y[i], 1e-6 * (1 + std::fabs(expected[i])));
+    y = spmv(A, x, SpmvBackend::Thread);
+    for (int i = 0; i < A.nRows; i++)
+        ASSERT_NEAR(expected[i], y[i], 1e-6 * (1 + std::fabs(expected[i])));
+}
+
+TEST(MatrixCRS_tbb, spmm_matches_spmv_per_column) {
+    MatrixCRS A = randomCRS(20000, 5000, 8, 10);
+    for (int k : {4, 13, 64}) {
+        std::vector<double> X(static_cast<size_t>(A.nColumns) * k);
+        for (size_t i = 0; i < X.size(); i++)
+            X[i] = static_cast<double>(i % 17) - 8;
+        std::vector<double> Y;
+        tbb::task_arena arena(3);
+        arena.execute([&] { Y = spmm(A, X, k); });
+        std::vector<double> YThr = spmm(A, X, k, SpmvBackend::Thread);
+        for (int c = 0; c < k; c++) {
+            std::vector<double> x(A.nColumns);
+            for (int i = 0; i < A.nColumns; i++)
+                x[i] = X[static_cast<size_t>(i) * k + c];
+            std::vector<double> y = referenceSpmv(A, x);
+            for (int i = 0; i < A.nRows; i++) {
+                ASSERT_NEAR(y[i], Y[static_cast<size_t>(i) * k + c], 1e-9);
+                ASSERT_NEAR(y[i], YThr[static_cast<size_t>(i) * k + c], 1e-9);
+            }
+        }
+    }
+}
+
+TEST(MatrixCRS_tbb, spmv_wrong_sizes) {
+    MatrixCRS A = randomCRS(10, 20, 3, -1);
+    EXPECT_ANY_THROW(spmv(A, std::vector<double>(19)));
+    EXPECT_ANY_THROW(spmm(A, std::vector<double>(20 * 4), 5));
+}
+
+#if USE_SPMV_BENCHMARK == 1
+// 400000 x 400000 with 16 nonzeros a row on average, about 80 MB, and a
+// STREAM triad over 3 * 128 MB: too big and too slow for the CI runs
+TEST(MatrixCRS_tbb, spmv_bandwidth) {
+    MatrixCRS A = randomCRS(400000, 400000, 16, -1);
+    std::vector<double> x(A.nColumns, 1.0);
+    for (auto backend : {SpmvBackend::Tbb, SpmvBackend::Thread}) {
+        double stream = streamTriadGBs(1 << 24, backend);
+        for (int k : {1, 8}) {
+            std::vector<double> X(static_cast<size_t>(A.nColumns) * k, 1.0);
+            tbb::tick_count start = tbb::tick_count::now();
+            std::vector<double> Y = k == 1 ? spmv(A, x, backend)
+                                           : spmm(A, X, k, backend);
+            double seconds = (tbb::tick_count::now() - start).seconds();
+            double gbs = spmvBytes(A, k) / seconds / 1e9;
+            std::cout << (backend == SpmvBackend::Tbb ? "tbb" : "std::thread")
+                      << " k = " << k << ": " << gbs << " GB/s, "
+                      << 100 * gbs / stream << "% of STREAM triad ("
+                      << stream << " GB/s)\n";
+            ASSERT_EQ(static_cast<size_t>(A.nRows) * k, Y.size());
+        }
+    }
+}
+#endif  // USE_SPMV_BENCHMARK
+
+// dense A with the entries outside the pattern of M cleared
+std::vector<std::vector<double>> maskDense(std::vector<std::vector<double>> A,
+    const std::vector<std::vector<double>>& M) {
+    for (size_t i = 0; i < A.size(); i++)
+        for (size_t j = 0; j < A[i].size(); j++)
+            if (M[i][j] == 0)
+                A[i][j] = 0;
+    return A;
+}
+
+// strict lower triangle of a random undirected graph, every vertex with
+// about 2 * degree neighbours
+MatrixCRS randomLowerGraph(int n, int degree) {
+    std::mt19937 gen(n);
+    std::vector<std::vector<int>> lower(n);
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < degree; k++) {
+            int j = static_cast<int>(gen() % n);
+            if (i != j)
+                lower[std::max(i, j)].push_back(std::min(i, j));
+        }
+    }
+    MatrixCRS L(n, n);
+    L.pointers.push_back(0);
+    for (int i = 0; i < n; i++) {
+        std::sort(lower[i].begin(), lower[i].end());
+        lower[i].erase(std::unique(lower[i].begin(), lower[i].end()),
+            lower[i].end());
+        for (int j : lower[i]) {
+            L.columns.push_back(j);
+            L.values.push_back(1);
+        }
+        L.pointers.push_back(L.values.size());
+    }
+    return L;
+}
+
+double sumValues(const MatrixCRS& A) {
+    double sum = 0;
+    for (double v : A.values)
+        sum += v;
+    return sum;
+}
+
+TEST(MatrixCRS_tbb, masked_mult_matches_dense) {
+    // the dense and sparse rows of B and M take all three intersections
+    for (double dB : {0.02, 0.3, 0.95}) {
+        for (double dM : {0.02, 0.3, 0.95}) {
+            std::vector<std::vector<double>> A = generateMatrix(120, 70, 0.1);
+            std::vector<std::vector<double>> B = generateMatrix(90, 120, dB);
+            std::vector<std::vector<double>> M = generateMatrix(90, 70, dM);
+            MatrixCRS C = maskedMult(MatrixCRS(A), MatrixCRS(B),
+                MatrixCRS(M));
+            EXPECT_EQ(C, MatrixCRS(maskDense(multMatrix(A, B), M)));
+        }
+    }
+}
+
+TEST(MatrixCRS_tbb, masked_mult_counts_triangles) {
+    const int n = 300;
+    MatrixCRS L = randomLowerGraph(n, 6);
+    std::vector<std::vector<char>> edge(n, std::vector<char>(n, 0));
+    for (int i = 0; i < n; i++)
+        for (int k = L.pointers[i]; k < L.pointers[i + 1]; k++)
+            edge[i][L.columns[k]] = 1;
+    double triangles = 0;
+    for (int a = 0; a < n; a++)
+        for (int b = 0; b < a; b++)
+            for (int c = 0; edge[a][b] && c < b; c++)
+                triangles += edge[a][c] && edge[b][c];
+    EXPECT_GT(triangles, 0);
+    EXPECT_EQ(triangles, sumValues(maskedMult(L, L, L)));
+}
+
+TEST(MatrixCRS_tbb, masked_mult_wrong_sizes) {
+    MatrixCRS A(MatrixCRS(generateMatrix(5, 4, 0.5)));
+    MatrixCRS B(MatrixCRS(generateMatrix(3, 5, 0.5)));
+    EXPECT_ANY_THROW(maskedMult(A, A, A));
+    EXPECT_ANY_THROW(maskedMult(A, B, A));
+    EXPECT_NO_THROW(maskedMult(A, B, MatrixCRS(generateMatrix(3, 4, 0.5))));
+}
+
+TEST(MatrixCRS_tbb, ewise_add_and_mult_match_dense) {
+    std::vector<std::vector<double>> A = generateMatrix(80, 60, 0.2);
+    std::vector<std::vector<double>> B = generateMatrix(80, 60, 0.4);
+    std::vector<std::vector<double>> sum = A, product = A, negative = A;
+    for (int i = 0; i < 60; i++) {
+        for (int j = 0; j < 80; j++) {
+            sum[i][j] += B[i][j];
+            product[i][j] *= B[i][j];
+            negative[i][j] = -A[i][j];
+        }
+    }
+    EXPECT_EQ(ewiseAdd(MatrixCRS(A), MatrixCRS(B)), MatrixCRS(sum));
+    EXPECT_EQ(ewiseMult(MatrixCRS(A), MatrixCRS(B)), MatrixCRS(product));
+    // entries that cancel are dropped
+    MatrixCRS zero = ewiseAdd(MatrixCRS(A), MatrixCRS(negative));
+    EXPECT_EQ(zero, MatrixCRS(zerpMatrix(80, 60)));
+    EXPECT_ANY_THROW(ewiseAdd(MatrixCRS(A), MatrixCRS(product).T()));
+}
+
+TEST(MatrixCRS_tbb, masked_mult_speed) {
+    // triangles of a 5000-vertex graph: masked against the full product
+    // followed by the mask
+    MatrixCRS L = randomLowerGraph(5000, 8);
+    tbb::tick_count start = tbb::tick_count::now();
+    MatrixCRS masked = maskedMult(L, L, L);
+    double maskedTime = (tbb::tick_count::now() - start).seconds();
+    start = tbb::tick_count::now();
+    MatrixCRS full = ewiseMult(L.dot_tbb(L.T()), L);
+    double fullTime = (tbb::tick_count::now() - start).seconds();
+    std::cout << "Masked: " << maskedTime << " s, full then mask: "
+              << fullTime << " s, triangles: " << sumValues(masked) << "\n";
+    EXPECT_EQ(full, masked);
+}
+
+std::vector<int> shuffled(int n, unsigned seed) {
+    std::vector<int> p(n);
+    std::iota(p.begin(), p.end(), 0);
+    std::shuffle(p.begin(), p.end(), std::mt19937(seed));
+    return p;
+}
+
+// 7-point stencil of a k x k x k grid, numbered in random order
+MatrixCRS scrambledGrid(int k) {
+    const int n = k * k * k;
+    MatrixCRS A(n, n);
+    A.pointers.push_back(0);
+    for (int v = 0; v < n; v++) {
+        const int x = v % k, y = v / k % k, z = v / (k * k);
+        int neighbours[7] = {v - k * k, v - k, v - 1, v, v + 1, v + k,
+            v + k * k};
+        bool inside[7] = {z > 0, y > 0, x > 0, true, x < k - 1, y < k - 1,
+            z < k - 1};
+        for (int t = 0; t < 7; t++) {
+            if (inside[t]) {
+                A.columns.push_back(neighbours[t]);
+                A.values.push_back(t == 3 ? 6 : -1);
+            }
+        }
+        A.pointers.push_back(A.values.size());
+    }
+    std::vector<int> p = shuffled(n, k);
+    return permute(A, p, p);
+}
+
+TEST(MatrixCRS_tbb, permute_matches_spmv) {
+    MatrixCRS A = randomCRS(3000, 4000, 6, 17);
+    std::vector<int> p = shuffled(A.nRows, 1), q = shuffled(A.nColumns, 2);
+    MatrixCRS B = permute(A, p, q);
+    std::vector<double> x(A.nColumns), xq(A.nColumns);
+    for (int j = 0; j < A.nColumns; j++)
+        x[j] = j % 13 - 6;
+    for (int j = 0; j < A.nColumns; j++)
+        xq[j] = x[q[j]];
+    std::vector<double> y = referenceSpmv(A, x), yB = referenceSpmv(B, xq);
+    for (int i = 0; i < A.nRows; i++)
+        ASSERT_NEAR(y[p[i]], yB[i], 1e-9);
+    for (int i = 0; i + 1 < B.nRows; i++)
+        ASSERT_TRUE(std::is_sorted(B.columns.begin() + B.pointers[i],
+            B.columns.begin() + B.pointers[i + 1]));
+    EXPECT_ANY_THROW(permute(A, q, p));
+    EXPECT_ANY_THROW(rcmOrder(A));
+}
+
+TEST(MatrixCRS_tbb, reordering_narrows_scrambled_grid) {
+    MatrixCRS A = scrambledGrid(12);
+    std::vector<int> rcm = rcmOrder(A);
+    MatrixCRS B = permute(A, rcm, rcm);
+    // about 12^2 against the 12^3 of the random numbering
+    EXPECT_LT(4 * bandwidth(B), bandwidth(A));
+    EXPECT_LT(4 * profile(B), profile(A));
+
+    // the parts of the bisection are ranges of n / parts rows, a grid cut
+    // into 8 blocks keeps most stencil entries inside their part
+    const int parts = 8, size = (A.nRows + parts - 1) / parts;
+    std::vector<int> part = partitionOrder(A, parts);
+    MatrixCRS C = permute(A, part, part);
+    auto crossing = [size](const MatrixCRS& M) {
+        int cut = 0;
+        for (int i = 0; i < M.nRows; i++)
+            for (int k = M.pointers[i]; k < M.pointers[i + 1]; k++)
+                cut += i / size != M.columns[k] / size;
+        return cut;
+    };
+    EXPECT_LT(4 * crossing(C), crossing(A));
+}
+
+#if USE_SPMV_BENCHMARK == 1
+// an 80^3 grid, 512k rows: timings only, too slow for the CI runs
+TEST(MatrixCRS_tbb, reordering_spmv_speedup) {
+    MatrixCRS A = scrambledGrid(80);
+    tbb::tick_count start = tbb::tick_count::now();
+    std::vector<int> rcm = rcmOrder(A);
+    std::cout << "RCM: " << (tbb::tick_count::now() - start).seconds()
+              << " s\n";
+    start = tbb::tick_count::now();
+    std::vector<int> part = partitionOrder(A, 64);
+    std::cout << "Partition: " << (tbb::tick_count::now() - start).seconds()
+              << " s\n";
+
+    std::vector<double> x(A.nColumns);
+    for (int j = 0; j < A.nColumns; j++)
+        x[j] = j % 7;
+    auto spmvTime = [&](const MatrixCRS& M, const std::vector<int>& order) {
+        std::vector<double> xm(M.nColumns), y;
+        for (int j = 0; j < M.nColumns; j++)
+            xm[j] = x[order[j]];
+        double best = 1e9;
+        for (int repeat = 0; repeat < 5; repeat++) {
+            tbb::tick_count t = tbb::tick_count::now();
+            y = spmv(M, xm);
+            best = std::min(best, (tbb::tick_count::now() - t).seconds());
+        }
+        std::vector<double> yA(M.nRows);
+        for (int i = 0; i < M.nRows; i++)
+            yA[order[i]] = y[i];
+        return std::make_pair(best, yA);
+    };
+    std::vector<int> id(A.nRows);
+    std::iota(id.begin(), id.end(), 0);
+    auto base = spmvTime(A, id);
+    std::cout << "scrambled: bandwidth " << bandwidth(A) << ", profile "
+              << profile(A) << ", spmv " << base.first << " s\n";
+    const std::vector<int>* orders[2] = {&rcm, &part};
+    const char* names[2] = {"RCM", "partition"};
+    for (int m = 0; m < 2; m++) {
+        const std::vector<int>& order = *orders[m];
+        MatrixCRS B = permute(A, order, order);
+        auto result = spmvTime(B, order);
+        std::cout << names[m] << ": bandwidth " << bandwidth(B) << ", profile "
+                  << profile(B) << ", spmv " << result.first
+                  << " s, speedup " << base.first / result.first << "\n";
+        for (int i = 0; i < A.nRows; i++)
+            ASSERT_NEAR(base.second[i], result.second[i], 1e-9);
+    }
+}
+#endif  // USE_SPMV_BENCHMARK
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,69 @@
+// Copyright 2022 Kolesnikov Gleb
+#include "../../../modules/task_3/kolesnikov_g_crs_mult/reorder.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "tbb/tbb.h"
+#define PARALLEL_SCAN_TBB
+#include "../../../3rdparty/unapproved/sparse_reorder.h"
+
+namespace {
+preorder::graph patternGraph(const MatrixCRS& A) {
+    if (A.nRows != A.nColumns) {
+        throw std::runtime_error("Error! Matrix is not square!\n");
+    }
+    return preorder::symmetric_graph_tbb(A.nRows, A.pointers.data(),
+        A.columns.data());
+}
+}  // namespace
+
+MatrixCRS permute(const MatrixCRS& A, const std::vector<int>& p,
+    const std::vector<int>& q) {
+    std::vector<int> pInv, qInv;
+    if (!preorder::invert(p, A.nRows, &pInv) ||
+        !preorder::invert(q, A.nColumns, &qInv)) {
+        throw std::runtime_error("Error! Incorrect permutation!\n");
+    }
+    std::vector<int> length(A.nRows);
+    for (int i = 0; i < A.nRows; i++)
+        length[i] = A.pointers[p[i] + 1] - A.pointers[p[i]];
+    MatrixCRS B(A.nColumns, A.nRows);
+    B.pointers.resize(A.nRows + 1);
+    B.pointers[A.nRows] = pscan::exclusive_scan_tbb(length.data(),
+        B.pointers.data(), A.nRows);
+    B.columns.resize(B.pointers[A.nRows]);
+    B.values.resize(B.pointers[A.nRows]);
+    tbb::parallel_for(tbb::blocked_range<int>(0, A.nRows),
+        [&](const tbb::blocked_range<int>& r) {
+            std::vector<std::pair<int, double>> row;
+            for (int i = r.begin(); i != r.end(); ++i) {
+                row.clear();
+                for (int k = A.pointers[p[i]]; k < A.pointers[p[i] + 1]; k++)
+                    row.push_back({qInv[A.columns[k]], A.values[k]});
+                std::sort(row.begin(), row.end());
+                int at = B.pointers[i];
+                for (const auto& entry : row) {
+                    B.columns[at] = entry.first;
+                    B.values[at++] = entry.second;
+                }
+            }
+        });
+    return B;
+}
+
+std::vector<int> rcmOrder(const MatrixCRS& A) {
+    return preorder::rcm_order_tbb(patternGraph(A));
+}
+
+std::vector<int> partitionOrder(const MatrixCRS& A, int parts) {
+    return preorder::partition_order_tbb(patternGraph(A), parts);
+}
+
+int bandwidth(const MatrixCRS& A) {
+    return preorder::bandwidth(A.nRows, A.pointers.data(), A.columns.data());
+}
+
+int64_t profile(const MatrixCRS& A) {
+    return preorder::profile(A.nRows, A.pointers.data(), A.columns.data());
+}
@@ -0,0 +1,28 @@
+// Copyright 2022 Kolesnikov Gleb
+#ifndef MODULES_TASK_3_KOLESNIKOV_G_CRS_MULT_REORDER_H_
+#define MODULES_TASK_3_KOLESNIKOV_G_CRS_MULT_REORDER_H_
+
+#include <cstdint>
+#include <vector>
+#include "../../../modules/task_3/kolesnikov_g_crs_mult/crs_mult.h"
+
+// Row i of the result is row p[i] of A and column j is column q[j]
+// (0-based, p[new] = old), the columns of every row come out sorted.
+// permute(A, order, order) renumbers a square matrix symmetrically.
+MatrixCRS permute(const MatrixCRS& A, const std::vector<int>& p,
+    const std::vector<int>& q);
+
+// Orderings of a square matrix for permute(A, order, order), computed on
+// the pattern of A + A^T with tbb: reverse Cuthill-McKee, which narrows
+// the band, or `parts` parts of a recursive bisection, which keeps the
+// rows of a part on a compact range of x.
+std::vector<int> rcmOrder(const MatrixCRS& A);
+std::vector<int> partitionOrder(const MatrixCRS& A, int parts);
+
+// max |i - j| over the entries
+int bandwidth(const MatrixCRS& A);
+
+// sum over the rows of i - (first column <= i)
+int64_t profile(const MatrixCRS& A);
+
+#endif  // MODULES_TASK_3_KOLESNIKOV_G_CRS_MULT_REORDER_H_
@@ -0,0 +1,191 @@
+// Copyright 2022 Kolesnikov Gleb
+#include "../../../modules/task_3/kolesnikov_g_crs_mult/sparse_ops.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "tbb/tbb.h"
+#define PARALLEL_SCAN_TBB
+#include "../../../3rdparty/unapproved/parallel_scan.h"
+
+namespace {
+// a row this many times longer than the other is searched, not merged
+const int kSearchRatio = 8;
+
+// calls f(p, q) for every x[p] == y[q], looking every y[q] up in x
+template <class F>
+void searchEach(const int* x, int nx, const int* y, int ny, const F& f) {
+    const int* from = x;
+    for (int q = 0; q < ny; ++q) {
+        from = std::lower_bound(from, x + nx, y[q]);
+        if (from == x + nx)
+            return;
+        if (*from == y[q])
+            f(static_cast<int>(from - x), q);
+    }
+}
+
+// calls f(p, q) for every column x[p] == y[q] of the sorted x[0, nx) and
+// y[0, ny)
+template <class F>
+void intersect(const int* x, int nx, const int* y, int ny, const F& f) {
+    if (nx > kSearchRatio * ny) {
+        searchEach(x, nx, y, ny, f);
+    } else if (ny > kSearchRatio * nx) {
+        searchEach(y, ny, x, nx, [&](int q, int p) { f(p, q); });
+    } else {
+        int p = 0, q = 0;
+        while (p < nx && q < ny) {
+            if (x[p] < y[q]) {
+                ++p;
+            } else if (x[p] > y[q]) {
+                ++q;
+            } else {
+                f(p++, q++);
+            }
+        }
+    }
+}
+
+// Builds a nR x nC matrix row by row in parallel. bound(i) is at least
+// the length of row i; fill(i, cols, values) writes row i there and
+// returns its length. The rows are then packed together.
+template <class Bound, class Fill>
+MatrixCRS buildRows(int nC, int nR, const Bound& bound, const Fill& fill) {
+    std::vector<int64_t> room(nR + 1);
+    tbb::parallel_for(0, nR, [&](int i) { room[i] = bound(i); });
+    room[nR] = pscan::exclusive_scan_tbb(room.data(), room.data(), nR);
+    std::vector<int> columns(room[nR]);
+    std::vector<double> values(room[nR]);
+    std::vector<int> length(nR + 1);
+    tbb::parallel_for(0, nR, [&](int i) {
+        length[i] = fill(i, columns.data() + room[i],
+            values.data() + room[i]);
+    });
+
+    MatrixCRS C(nC, nR);
+    C.pointers.resize(nR + 1);
+    C.pointers[nR] = pscan::exclusive_scan_tbb(length.data(),
+        C.pointers.data(), nR);
+    if (C.pointers[nR] == room[nR]) {
+        C.columns.swap(columns);
+        C.values.swap(values);
+        return C;
+    }
+    C.columns.resize(C.pointers[nR]);
+    C.values.resize(C.pointers[nR]);
+    tbb::parallel_for(0, nR, [&](int i) {
+        std::copy(columns.begin() + room[i],
+            columns.begin() + room[i] + length[i],
+            C.columns.begin() + C.pointers[i]);
+        std::copy(values.begin() + room[i],
+            values.begin() + room[i] + length[i],
+            C.values.begin() + C.pointers[i]);
+    });
+    return C;
+}
+
+int rowLength(const MatrixCRS& A, int i) {
+    return A.pointers[i + 1] - A.pointers[i];
+}
+
+void checkSameSize(const MatrixCRS& A, const MatrixCRS& B) {
+    if (A.nRows != B.nRows || A.nColumns != B.nColumns) {
+        throw std::runtime_error("Error! Matrix sizes do not match!\n");
+    }
+}
+}  // namespace
+
+MatrixCRS maskedMult(const MatrixCRS& A, const MatrixCRS& B,
+    const MatrixCRS& M) {
+    if (A.nColumns != B.nRows) {
+        throw std::runtime_error("Error! Incorrect numbers of rows!\n");
+    }
+    if (M.nRows != A.nRows || M.nColumns != B.nColumns) {
+        throw std::runtime_error("Error! Mask size does not match!\n");
+    }
+    // the sums of a row, one per entry of its mask row
+    tbb::enumerable_thread_specific<std::vector<double>> sums;
+    return buildRows(M.nColumns, M.nRows,
+        [&](int i) { return A.pointers[i] < A.pointers[i + 1]
+                         ? rowLength(M, i) : 0; },
+        [&](int i, int* columns, double* values) {
+            const int* mask = M.columns.data() + M.pointers[i];
+            const int maskLength = rowLength(M, i);
+            if (maskLength == 0 || A.pointers[i] == A.pointers[i + 1])
+                return 0;
+            std::vector<double>& sum = sums.local();
+            sum.assign(maskLength, 0.0);
+            for (int ka = A.pointers[i]; ka < A.pointers[i + 1]; ++ka) {
+                const int k = A.columns[ka];
+                const double a = A.values[ka];
+                const int first = B.pointers[k];
+                intersect(B.columns.data() + first, rowLength(B, k), mask,
+                    maskLength, [&](int p, int q) {
+                        sum[q] += a * B.values[first + p];
+                    });
+            }
+            int n = 0;
+            for (int q = 0; q < maskLength; ++q) {
+                if (sum[q] != 0) {
+                    columns[n] = mask[q];
+                    values[n++] = sum[q];
+                }
+            }
+            return n;
+        });
+}
+
+MatrixCRS ewiseAdd(const MatrixCRS& A, const MatrixCRS& B) {
+    checkSameSize(A, B);
+    return buildRows(A.nColumns, A.nRows,
+        [&](int i) { return rowLength(A, i) + rowLength(B, i); },
+        [&](int i, int* columns, double* values) {
+            int n = 0;
+            auto put = [&](int column, double value) {
+                if (value != 0) {
+                    columns[n] = column;
+                    values[n++] = value;
+                }
+            };
+            int ka = A.pointers[i], kb = B.pointers[i];
+            const int ea = A.pointers[i + 1], eb = B.pointers[i + 1];
+            while (ka < ea && kb < eb) {
+                if (A.columns[ka] < B.columns[kb]) {
+                    put(A.columns[ka], A.values[ka]);
+                    ++ka;
+                } else if (A.columns[ka] > B.columns[kb]) {
+                    put(B.columns[kb], B.values[kb]);
+                    ++kb;
+                } else {
+                    put(A.columns[ka], A.values[ka] + B.values[kb]);
+                    ++ka;
+                    ++kb;
+                }
+            }
+            for (; ka < ea; ++ka)
+                put(A.columns[ka], A.values[ka]);
+            for (; kb < eb; ++kb)
+                put(B.columns[kb], B.values[kb]);
+            return n;
+        });
+}
+
+MatrixCRS ewiseMult(const MatrixCRS& A, const MatrixCRS& B) {
+    checkSameSize(A, B);
+    return buildRows(A.nColumns, A.nRows,
+        [&](int i) { return std::min(rowLength(A, i), rowLength(B, i)); },
+        [&](int i, int* columns, double* values) {
+            int n = 0;
+            const int ka = A.pointers[i], kb = B.pointers[i];
+            intersect(A.columns.data() + ka, rowLength(A, i),
+                B.columns.data() + kb, rowLength(B, i), [&](int p, int q) {
+                    const double value = A.values[ka + p] * B.values[kb + q];
+                    if (value != 0) {
+                        columns[n] = A.columns[ka + p];
+                        values[n++] = value;
+                    }
+                });
+            return n;
+        });
+}
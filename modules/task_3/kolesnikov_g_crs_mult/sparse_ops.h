@@ -0,0 +1,26 @@
+// Copyright 2022 Kolesnikov Gleb
+#ifndef MODULES_TASK_3_KOLESNIKOV_G_CRS_MULT_SPARSE_OPS_H_
+#define MODULES_TASK_3_KOLESNIKOV_G_CRS_MULT_SPARSE_OPS_H_
+
+#include "../../../modules/task_3/kolesnikov_g_crs_mult/crs_mult.h"
+
+// The operations below need the columns of every row sorted, as the
+// dense constructor makes them, and drop the entries that come out zero,
+// as dot does. The rows are computed in parallel with tbb.
+
+// C = (A B) .* M: only the entries of A B at the positions M stores are
+// computed, the values of M are not used. Unlike dot, B is not passed
+// transposed. For every a(i, k) the row k of B is intersected with the
+// row i of M, by a merge or, when the row of B is much longer, by binary
+// searches, so the work outside the mask is skipped. (L L) .* L of the
+// lower triangle L of a graph holds the triangles through every edge.
+MatrixCRS maskedMult(const MatrixCRS& A, const MatrixCRS& B,
+    const MatrixCRS& M);
+
+// A + B, the rows merged by their union
+MatrixCRS ewiseAdd(const MatrixCRS& A, const MatrixCRS& B);
+
+// A .* B, the rows merged by their intersection
+MatrixCRS ewiseMult(const MatrixCRS& A, const MatrixCRS& B);
+
+#endif  // MODULES_TASK_3_KOLESNIKOV_G_CRS_MULT_SPARSE_OPS_H_
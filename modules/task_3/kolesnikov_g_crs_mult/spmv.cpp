@@ -0,0 +1,194 @@
+// Copyright 2022 Kolesnikov Gleb
+#include "../../../modules/task_3/kolesnikov_g_crs_mult/spmv.h"
+#include <algorithm>
+#include <chrono>  // NOLINT [build/c++11]
+#include <cstdint>
+#include <stdexcept>
+#include <thread>  // NOLINT [build/c++11]
+#include <vector>
+#include "tbb/tbb.h"
+
+namespace {
+// chunks shorter than this many rows + nonzeros are not worth a task
+const int64_t kMinPath = 1 << 12;
+
+// what a chunk leaves for its successors: the sum over the beginning of
+// the row it stopped in
+struct Carry {
+    int row;
+    std::vector<double> sum;
+};
+
+// number of row ends among the first d items of the merge of the row
+// ends (pointers[1..nRows]) with the nonzero indices 0, 1, ..., nnz - 1
+int pathRow(const MatrixCRS& A, int64_t d) {
+    int64_t nnz = A.values.size();
+    int64_t lo = std::max<int64_t>(0, d - nnz);
+    int64_t hi = std::min<int64_t>(d, A.nRows);
+    while (lo < hi) {
+        int64_t mid = (lo + hi) / 2;
+        if (A.pointers[mid + 1] <= d - 1 - mid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return static_cast<int>(lo);
+}
+
+void spmvChunk(const MatrixCRS& A, const double* x, double* y,
+    int64_t dBegin, int64_t dEnd, Carry* carry) {
+    int row = pathRow(A, dBegin);
+    const int rowEnd = pathRow(A, dEnd);
+    int j = static_cast<int>(dBegin - row);
+    const int jEnd = static_cast<int>(dEnd - rowEnd);
+    for (; row < rowEnd; ++row) {
+        double sum = 0;
+        for (; j < A.pointers[row + 1]; ++j)
+            sum += A.values[j] * x[A.columns[j]];
+        y[row] = sum;
+    }
+    double sum = 0;
+    for (; j < jEnd; ++j)
+        sum += A.values[j] * x[A.columns[j]];
+    carry->row = rowEnd;
+    carry->sum.assign(1, sum);
+}
+
+// K > 0: block width known at compile time, the k sums stay in registers
+// and the update of a row of Y is unrolled; K == 0: any k
+template <int K>
+void spmmChunk(const MatrixCRS& A, const double* X, int k, double* Y,
+    int64_t dBegin, int64_t dEnd, Carry* carry) {
+    const int width = K > 0 ? K : k;
+    int row = pathRow(A, dBegin);
+    const int rowEnd = pathRow(A, dEnd);
+    int j = static_cast<int>(dBegin - row);
+    const int jEnd = static_cast<int>(dEnd - rowEnd);
+    std::vector<double> acc(K > 0 ? 0 : width);
+    double fixed[K > 0 ? K : 1];
+    double* sum = K > 0 ? fixed : acc.data();
+    for (; row <= rowEnd; ++row) {
+        std::fill(sum, sum + width, 0.0);
+        const int stop = row < rowEnd ? A.pointers[row + 1] : jEnd;
+        for (; j < stop; ++j) {
+            const double v = A.values[j];
+            const double* xRow = X +
+                static_cast<int64_t>(A.columns[j]) * width;
+            for (int c = 0; c < width; ++c)
+                sum[c] += v * xRow[c];
+        }
+        if (row < rowEnd)
+            std::copy(sum, sum + width, Y + static_cast<int64_t>(row) * width);
+    }
+    carry->row = rowEnd;
+    carry->sum.assign(sum, sum + width);
+}
+
+int chunkCount(const MatrixCRS& A, SpmvBackend backend) {
+    int64_t path = static_cast<int64_t>(A.nRows) + A.values.size();
+    int64_t workers = backend == SpmvBackend::Tbb
+        ? 4 * static_cast<int64_t>(tbb::this_task_arena::max_concurrency())
+        : std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<int>(std::max<int64_t>(1,
+        std::min(workers, path / kMinPath)));
+}
+
+template <class Body>
+void forChunks(int chunks, SpmvBackend backend, const Body& body) {
+    if (backend == SpmvBackend::Tbb) {
+        tbb::parallel_for(0, chunks, body);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (int c = 1; c < chunks; ++c)
+        threads.emplace_back(body, c);
+    body(0);
+    for (auto& thread : threads)
+        thread.join();
+}
+
+template <class Kernel>
+std::vector<double> mergePathProduct(const MatrixCRS& A, int k,
+    SpmvBackend backend, const Kernel& kernel) {
+    std::vector<double> Y(static_cast<size_t>(A.nRows) * k);
+    const int chunks = chunkCount(A, backend);
+    const int64_t path = static_cast<int64_t>(A.nRows) + A.values.size();
+    std::vector<Carry> carries(chunks);
+    forChunks(chunks, backend, [&](int c) {
+        kernel(path * c / chunks, path * (c + 1) / chunks, Y.data(),
+            &carries[c]);
+    });
+    // the chunk that finishes a row has already written it
+    for (const Carry& carry : carries) {
+        if (carry.row >= A.nRows)
+            continue;
+        double* y = Y.data() + static_cast<int64_t>(carry.row) * k;
+        for (int c = 0; c < k; ++c)
+            y[c] += carry.sum[c];
+    }
+    return Y;
+}
+}  // namespace
+
+std::vector<double> spmv(const MatrixCRS& A, const std::vector<double>& x,
+    SpmvBackend backend) {
+    if (static_cast<int>(x.size()) != A.nColumns) {
+        throw std::runtime_error("Error! Vector size does not match!\n");
+    }
+    return mergePathProduct(A, 1, backend,
+        [&](int64_t dBegin, int64_t dEnd, double* y, Carry* carry) {
+            spmvChunk(A, x.data(), y, dBegin, dEnd, carry);
+        });
+}
+
+std::vector<double> spmm(const MatrixCRS& A, const std::vector<double>& X,
+    int k, SpmvBackend backend) {
+    if (k <= 0 || X.size() != static_cast<size_t>(A.nColumns) * k) {
+        throw std::runtime_error("Error! Block size does not match!\n");
+    }
+    auto product = [&](void (*chunk)(const MatrixCRS&, const double*, int,
+        double*, int64_t, int64_t, Carry*)) {
+        return mergePathProduct(A, k, backend,
+            [&](int64_t dBegin, int64_t dEnd, double* Y, Carry* carry) {
+                chunk(A, X.data(), k, Y, dBegin, dEnd, carry);
+            });
+    };
+    switch (k) {
+    case 4: return product(spmmChunk<4>);
+    case 8: return product(spmmChunk<8>);
+    case 16: return product(spmmChunk<16>);
+    case 32: return product(spmmChunk<32>);
+    case 64: return product(spmmChunk<64>);
+    default: return product(spmmChunk<0>);
+    }
+}
+
+double spmvBytes(const MatrixCRS& A, int k) {
+    double matrix = A.values.size() * (sizeof(double) + sizeof(int)) +
+        A.pointers.size() * sizeof(int);
+    double vectors = (static_cast<double>(A.nColumns) + A.nRows) * k *
+        sizeof(double);
+    return matrix + vectors;
+}
+
+double streamTriadGBs(size_t n, SpmvBackend backend) {
+    std::vector<double> a(n), b(n, 1.0), c(n, 2.0);
+    const double s = 3.0;
+    const int chunks = backend == SpmvBackend::Tbb
+        ? 4 * tbb::this_task_arena::max_concurrency()
+        : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    auto triad = [&](int t) {
+        size_t begin = n * t / chunks, end = n * (t + 1) / chunks;
+        for (size_t i = begin; i < end; ++i)
+            a[i] = b[i] + s * c[i];
+    };
+    double best = 0;
+    for (int repeat = 0; repeat < 5; ++repeat) {
+        auto start = std::chrono::steady_clock::now();
+        forChunks(chunks, backend, triad);
+        std::chrono::duration<double> time =
+            std::chrono::steady_clock::now() - start;
+        best = std::max(best, 3.0 * sizeof(double) * n / time.count() / 1e9);
+    }
+    return best;
+}
@@ -0,0 +1,31 @@
+// Copyright 2022 Kolesnikov Gleb
+#ifndef MODULES_TASK_3_KOLESNIKOV_G_CRS_MULT_SPMV_H_
+#define MODULES_TASK_3_KOLESNIKOV_G_CRS_MULT_SPMV_H_
+
+#include <cstddef>
+#include <vector>
+#include "../../../modules/task_3/kolesnikov_g_crs_mult/crs_mult.h"
+
+enum class SpmvBackend { Tbb, Thread };
+
+// y = A x. The work is cut along the merge path of row ends and nonzeros
+// (Merrill, Garland), so every chunk gets the same rows + nonzeros count
+// no matter how long the rows are; a row split between two chunks is
+// finished by a fix-up of the chunk carries.
+std::vector<double> spmv(const MatrixCRS& A, const std::vector<double>& x,
+    SpmvBackend backend = SpmvBackend::Tbb);
+
+// Y = A X for k right-hand sides. X (A.nColumns x k) and Y (A.nRows x k)
+// are stored row by row so that every nonzero updates k contiguous values
+std::vector<double> spmm(const MatrixCRS& A, const std::vector<double>& X,
+    int k, SpmvBackend backend = SpmvBackend::Tbb);
+
+// bytes one spmm with k right-hand sides has to move at least: the
+// matrix once, X and Y once each
+double spmvBytes(const MatrixCRS& A, int k);
+
+// bandwidth of the STREAM triad a[i] = b[i] + s * c[i] over arrays of n
+// doubles in GB/s, the roofline SpMV is measured against
+double streamTriadGBs(size_t n, SpmvBackend backend = SpmvBackend::Tbb);
+
+#endif  // MODULES_TASK_3_KOLESNIKOV_G_CRS_MULT_SPMV_H_
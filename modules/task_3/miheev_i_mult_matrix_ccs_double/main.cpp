@@ -3,10 +3,51 @@
 #include <gtest/gtest.h>
 #include <time.h>
 
+#include <algorithm>
+#include <numeric>
+#include <random>
 #include <vector>
 
+#include "../../../3rdparty/unapproved/sparse_reorder.h"
 #include "../../../modules/task_3/miheev_i_mult_matrix_ccs_double/matrix_ccs_tbb.h"
 
+namespace {
+// 5-point Laplacian of a k x k grid, rows sorted in every column
+SprMatCCS gridMatrix(int k) {
+  std::vector<double> val;
+  std::vector<int> rows;
+  std::vector<int> ptr{1};
+  auto add = [&](int row, double value) {
+    rows.push_back(row + 1);
+    val.push_back(value);
+  };
+  for (int j = 0; j < k * k; j++) {
+    const int x = j % k, y = j / k;
+    if (y > 0) add(j - k, -1);
+    if (x > 0) add(j - 1, -1);
+    add(j, 4);
+    if (x < k - 1) add(j + 1, -1);
+    if (y < k - 1) add(j + k, -1);
+    ptr.push_back(static_cast<int>(rows.size()) + 1);
+  }
+  return SprMatCCS(k * k, static_cast<int>(val.size()), val, rows, ptr);
+}
+
+std::vector<int> shuffled(int n, unsigned seed) {
+  std::vector<int> p(n);
+  std::iota(p.begin(), p.end(), 0);
+  std::shuffle(p.begin(), p.end(), std::mt19937(seed));
+  return p;
+}
+
+bool isPermutation(std::vector<int> p, int n) {
+  std::sort(p.begin(), p.end());
+  for (int i = 0; i < n; i++)
+    if (p[i] != i) return false;
+  return static_cast<int>(p.size()) == n;
+}
+}  // namespace
+
 TEST(SprMatCCS_Test, Sparse_matrix_multiplication_int) {
   int cap = 3;
   int dim = 3;
@@ -208,3 +249,172 @@ TEST(SprMatCCS_Test, Sparse_matrix_multiplication_perf5000) {
 
   EXPECT_TRUE(C_seq == C_tdd);
 }
+
+TEST(SprMatCCS_Test, Permute_small) {
+  // A = [1 0 2; 0 3 0; 4 0 5], rows p = {2, 0, 1}, columns q = {1, 2, 0}
+  std::vector<double> val{1, 4, 3, 2, 5};
+  std::vector<int> rows{1, 3, 2, 1, 3};
+  std::vector<int> ptr{1, 3, 4, 6};
+  SprMatCCS A(3, 5, val, rows, ptr);
+
+  SprMatCCS B = A.permute({2, 0, 1}, {1, 2, 0});
+
+  // B = [0 5 4; 0 2 1; 3 0 0]
+  std::vector<double> res_val{3, 5, 2, 4, 1};
+  std::vector<int> res_rows{3, 1, 2, 1, 2};
+  std::vector<int> res_ptr{1, 2, 4, 6};
+  EXPECT_TRUE(B == SprMatCCS(3, 5, res_val, res_rows, res_ptr));
+  EXPECT_TRUE(A.permute({0, 1, 2}, {0, 1, 2}) == A);
+  EXPECT_ANY_THROW(A.permute({0, 0, 1}, {0, 1, 2}));
+  EXPECT_ANY_THROW(A.permute({0, 1}, {0, 1, 2}));
+}
+
+TEST(SprMatCCS_Test, Permute_commutes_with_product) {
+  const int dim = 300;
+  SprMatCCS A, B;
+  A.randMat(dim, 4);
+  B.randMat(dim, 4);
+  // randMat leaves the rows of a column unsorted, permute sorts them
+  std::vector<int> id = shuffled(dim, 0);
+  std::sort(id.begin(), id.end());
+  A = A.permute(id, id);
+  B = B.permute(id, id);
+
+  std::vector<int> p = shuffled(dim, 7);
+  SprMatCCS C = A.ParallelMult(B).permute(p, p);
+  EXPECT_TRUE(A.permute(p, p).ParallelMult(B.permute(p, p)) == C);
+}
+
+TEST(SprMatCCS_Test, Rcm_restores_a_band) {
+  const int k = 40;
+  std::vector<int> p = shuffled(k * k, 3);
+  SprMatCCS scrambled = gridMatrix(k).permute(p, p);
+  std::vector<int> order = scrambled.rcmOrder();
+  ASSERT_TRUE(isPermutation(order, k * k));
+
+  SprMatCCS banded = scrambled.permute(order, order);
+  EXPECT_GT(scrambled.bandwidth(), 10 * k);
+  EXPECT_LE(banded.bandwidth(), 2 * k);
+  EXPECT_LT(banded.profile(), scrambled.profile() / 10);
+}
+
+TEST(SprMatCCS_Test, Rcm_levels_in_parallel_chunks) {
+  // a random graph has levels wide enough to be split between threads,
+  // the ordering must not depend on the split
+  const int n = 60000;
+  std::mt19937 gen(11);
+  std::vector<int> ptr{0}, idx;
+  for (int i = 0; i < n; i++) {
+    for (int k = 0; k < 3; k++) idx.push_back(gen() % n);
+    ptr.push_back(static_cast<int>(idx.size()));
+  }
+  preorder::graph g = preorder::symmetric_graph_std(n, ptr.data(),
+                                                    idx.data());
+  std::vector<int> serial = preorder::rcm_order_seq(g);
+  std::vector<int> split = preorder::rcm_order(g, 4, pscan::for_each_std());
+  ASSERT_TRUE(isPermutation(serial, n));
+  EXPECT_EQ(serial, split);
+}
+
+TEST(SprMatCCS_Test, Partition_keeps_parts_together) {
+  const int k = 64, parts = 8;
+  std::vector<int> p = shuffled(k * k, 5);
+  SprMatCCS scrambled = gridMatrix(k).permute(p, p);
+  std::vector<int> order = scrambled.partitionOrder(parts);
+  ASSERT_TRUE(isPermutation(order, k * k));
+
+  // edges between the parts: about a grid line per cut, not 7 / 8 of all
+  SprMatCCS ordered = scrambled.permute(order, order);
+  std::vector<int> rows = ordered.getRows(), ptr = ordered.getPtr();
+  const int size = k * k / parts;
+  int cut = 0;
+  for (int j = 0; j < k * k; j++)
+    for (int t = ptr[j]; t < ptr[j + 1]; t++)
+      cut += (rows[t - 1] - 1) / size != j / size;
+  EXPECT_LT(cut, 2 * parts * k);
+}
+
+TEST(SprMatCCS_Test, Matrix_vector_product) {
+  SprMatCCS A;
+  A.randMat(3000, 12);
+  std::vector<double> x(3000);
+  for (int j = 0; j < 3000; j++) x[j] = j % 5 - 2;
+  std::vector<double> expected(3000, 0);
+  std::vector<double> val = A.getValues();
+  std::vector<int> rows = A.getRows();
+  std::vector<int> ptr = A.getPtr();
+  for (int j = 0; j < 3000; j++)
+    for (int t = ptr[j]; t < ptr[j + 1]; t++)
+      expected[rows[t - 1] - 1] += val[t - 1] * x[j];
+
+  // 36000 nonzeros are cut into chunks, the integer values keep the sums
+  // exact whatever the order
+  tbb::task_arena arena(4);
+  std::vector<double> y;
+  arena.execute([&] { y = A.ParallelMultVec(x); });
+  EXPECT_EQ(expected, y);
+  EXPECT_EQ(gridMatrix(4).ParallelMultVec(std::vector<double>(16, 1)),
+            std::vector<double>({2, 1, 1, 2, 1, 0, 0, 1, 1, 0, 0, 1, 2, 1, 1,
+                                 2}));
+  EXPECT_EQ(expected, A.ParallelMultVec(x, pspmv::Backend::Thread));
+  EXPECT_ANY_THROW(A.ParallelMultVec(std::vector<double>(2999)));
+}
+
+TEST(SprMatCCS_Test, Matrix_block_product) {
+  SprMatCCS A;
+  A.randMat(1000, 8);
+  std::vector<double> val = A.getValues();
+  std::vector<int> rows = A.getRows();
+  std::vector<int> ptr = A.getPtr();
+  tbb::task_arena arena(4);
+  // 5 takes the kernel of any width, 4 and 32 the fixed ones
+  for (int k : {4, 5, 32}) {
+    std::vector<double> X(1000 * k);
+    for (size_t j = 0; j < X.size(); j++) X[j] = static_cast<int>(j % 7) - 3;
+    std::vector<double> expected(1000 * k, 0);
+    for (int j = 0; j < 1000; j++)
+      for (int t = ptr[j]; t < ptr[j + 1]; t++)
+        for (int c = 0; c < k; c++)
+          expected[(rows[t - 1] - 1) * k + c] += val[t - 1] * X[j * k + c];
+
+    std::vector<double> Y;
+    arena.execute([&] { Y = A.ParallelMultBlock(X, k); });
+    EXPECT_EQ(expected, Y) << k;
+    EXPECT_EQ(expected, A.ParallelMultBlock(X, k, pspmv::Backend::Thread))
+        << k;
+  }
+  EXPECT_ANY_THROW(A.ParallelMultBlock(std::vector<double>(1000 * 4), 3));
+}
+
+TEST(SprMatCCS_Test, Reordering_perf) {
+  const int k = 80;
+  std::vector<int> p = shuffled(k * k, 9);
+  SprMatCCS scrambled = gridMatrix(k).permute(p, p);
+
+  double start = clock();
+  std::vector<int> rcm = scrambled.rcmOrder();
+  std::cout << "RCM time: " << (clock() - start) / CLOCKS_PER_SEC << " sec"
+            << std::endl;
+  std::vector<int> part = scrambled.partitionOrder(16);
+
+  SprMatCCS byRcm = scrambled.permute(rcm, rcm);
+  SprMatCCS byPart = scrambled.permute(part, part);
+  double times[3];
+  SprMatCCS* mats[3] = {&scrambled, &byRcm, &byPart};
+  const char* names[3] = {"scrambled", "RCM", "partition"};
+  SprMatCCS products[3];
+  for (int m = 0; m < 3; m++) {
+    start = clock();
+    products[m] = mats[m]->ParallelMult(*mats[m]);
+    times[m] = (clock() - start) / CLOCKS_PER_SEC;
+    std::cout << names[m] << ": bandwidth " << mats[m]->bandwidth()
+              << ", profile " << mats[m]->profile() << ", product "
+              << times[m] << " sec" << std::endl;
+  }
+  std::cout << "Product speedup: RCM " << times[0] / times[1]
+            << ", partition " << times[0] / times[2] << std::endl;
+
+  std::vector<int> rcmInv(rcm.size());
+  for (size_t i = 0; i < rcm.size(); i++) rcmInv[rcm[i]] = i;
+  EXPECT_TRUE(products[1].permute(rcmInv, rcmInv) == products[0]);
+}
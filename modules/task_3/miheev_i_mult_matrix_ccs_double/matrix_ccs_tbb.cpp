@@ -2,6 +2,12 @@
 
 #include "../../../modules/task_3/miheev_i_mult_matrix_ccs_double/matrix_ccs_tbb.h"
 
+#include <algorithm>
+#include <utility>
+
+#define PARALLEL_SCAN_TBB
+#include "../../../3rdparty/unapproved/sparse_reorder.h"
+
 bool isZero(const double num) { return std::abs(num) < 0.00000001; }
 bool isEqual(double x, double y) { return std::fabs(x - y) < 0.00000001; }
 inline int Grain(int x) {
@@ -11,6 +17,29 @@ inline int Grain(int x) {
     return 1;
 }
 
+namespace {
+// the 1-based pointers and rows shifted to 0-based
+void zeroBased(const std::vector<int>& ptr, const std::vector<int>& rows,
+               std::vector<int>* ptr0, std::vector<int>* rows0) {
+  if (ptr.empty()) {  // a default-constructed matrix
+    ptr0->assign(1, 0);
+    rows0->clear();
+    return;
+  }
+  ptr0->resize(ptr.size());
+  rows0->resize(rows.size());
+  for (size_t i = 0; i < ptr.size(); i++) (*ptr0)[i] = ptr[i] - 1;
+  for (size_t i = 0; i < rows.size(); i++) (*rows0)[i] = rows[i] - 1;
+}
+
+preorder::graph patternGraph(int dim, const std::vector<int>& ptr,
+                             const std::vector<int>& rows) {
+  std::vector<int> ptr0, rows0;
+  zeroBased(ptr, rows, &ptr0, &rows0);
+  return preorder::symmetric_graph_tbb(dim, ptr0.data(), rows0.data());
+}
+}  // namespace
+
 SprMatCCS::~SprMatCCS() {
   this->val.clear();
   this->rows.clear();
@@ -210,6 +239,25 @@ SprMatCCS SprMatCCS::ParallelMult(SprMatCCS mat) {
   return res;
 }
 
+std::vector<double> SprMatCCS::ParallelMultVec(const std::vector<double>& x,
+                                               pspmv::Backend backend) const {
+  return ParallelMultBlock(x, 1, backend);
+}
+
+std::vector<double> SprMatCCS::ParallelMultBlock(const std::vector<double>& X,
+                                                 int k,
+                                                 pspmv::Backend backend) const {
+  if (k <= 0 || X.size() != static_cast<size_t>(this->dim) * k)
+    throw "wrong sizes";
+  std::vector<double> Y(static_cast<size_t>(this->dim) * k);
+  if (this->ptr.empty()) return Y;  // a default-constructed matrix
+  // the pointers and the rows are 1-based
+  pspmv::ccs_spmm_any(backend, this->dim, this->dim, this->ptr.data(),
+                      this->rows.data(), this->val.data(), 1, X.data(), k,
+                      Y.data());
+  return Y;
+}
+
 void SprMatCCS::shwVal() {
   for (int i = 0; i < this->cap; i++) {
     std::cout << val[i] << " ";
@@ -224,3 +272,56 @@ void SprMatCCS::shwVal() {
   }
   std::cout << "\n";
 }
+
+SprMatCCS SprMatCCS::permute(const std::vector<int>& p,
+                             const std::vector<int>& q) const {
+  std::vector<int> pInv, qInv;
+  if (!preorder::invert(p, dim, &pInv) || !preorder::invert(q, dim, &qInv))
+    throw "wrong permutation";
+
+  std::vector<int> count(dim);
+  for (int j = 0; j < dim; j++) count[j] = ptr[q[j] + 1] - ptr[q[j]];
+  SprMatCCS res(dim, cap);
+  res.ptr.resize(dim + 1);
+  res.ptr[dim] = pscan::exclusive_scan_tbb(count.data(), res.ptr.data(), dim,
+                                           1);
+  res.val.resize(cap);
+  res.rows.resize(cap);
+  tbb::parallel_for(tbb::blocked_range<int>(0, dim),
+                    [&](const tbb::blocked_range<int>& rg) {
+                      std::vector<std::pair<int, double>> column;
+                      for (int j = rg.begin(); j < rg.end(); j++) {
+                        column.clear();
+                        for (int k = ptr[q[j]]; k < ptr[q[j] + 1]; k++)
+                          column.push_back(std::make_pair(
+                              pInv[rows[k - 1] - 1] + 1, val[k - 1]));
+                        std::sort(column.begin(), column.end());
+                        int at = res.ptr[j] - 1;
+                        for (const auto& e : column) {
+                          res.rows[at] = e.first;
+                          res.val[at++] = e.second;
+                        }
+                      }
+                    });
+  return res;
+}
+
+std::vector<int> SprMatCCS::rcmOrder() const {
+  return preorder::rcm_order_tbb(patternGraph(dim, ptr, rows));
+}
+
+std::vector<int> SprMatCCS::partitionOrder(int parts) const {
+  return preorder::partition_order_tbb(patternGraph(dim, ptr, rows), parts);
+}
+
+int SprMatCCS::bandwidth() const {
+  std::vector<int> ptr0, rows0;
+  zeroBased(ptr, rows, &ptr0, &rows0);
+  return preorder::bandwidth(dim, ptr0.data(), rows0.data());
+}
+
+int64_t SprMatCCS::profile() const {
+  std::vector<int> ptr0, rows0;
+  zeroBased(ptr, rows, &ptr0, &rows0);
+  return preorder::profile(dim, ptr0.data(), rows0.data());
+}
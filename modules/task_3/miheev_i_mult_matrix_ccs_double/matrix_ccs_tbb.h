@@ -5,10 +5,13 @@
 
 #include <tbb/tbb.h>
 
+#include <cstdint>
 #include <iostream>
 #include <random>
 #include <vector>
 
+#include "../../../3rdparty/unapproved/ccs_spmv.h"
+
 class SprMatCCS {
  private:
   int dim;                  // number of matrix dimension
@@ -48,6 +51,28 @@ class SprMatCCS {
   bool operator!=(const SprMatCCS& mat) { return !(*this == mat); }
 
   SprMatCCS ParallelMult(SprMatCCS mat);
+  // this * x: the columns are cut into chunks of about equal nonzeros,
+  // every chunk scatters into its own copy of the result, the copies are
+  // summed by rows (3rdparty/unapproved/ccs_spmv.h), on TBB or std::thread
+  std::vector<double> ParallelMultVec(
+      const std::vector<double>& x,
+      pspmv::Backend backend = pspmv::Backend::Tbb) const;
+  // this * X for k right-hand sides, X (dim x k) and the result stored row
+  // by row; k = 4, 8, 16, 32 and 64 use kernels of fixed width
+  std::vector<double> ParallelMultBlock(
+      const std::vector<double>& X, int k,
+      pspmv::Backend backend = pspmv::Backend::Tbb) const;
+
+  // row i of the result is row p[i], column j is column q[j] (0-based,
+  // p[new] = old); the rows of every column come out sorted
+  SprMatCCS permute(const std::vector<int>& p,
+                    const std::vector<int>& q) const;
+  // orderings of the pattern of A + A^T, for permute(order, order):
+  // reverse Cuthill-McKee, or `parts` parts of a recursive bisection
+  std::vector<int> rcmOrder() const;
+  std::vector<int> partitionOrder(int parts) const;
+  int bandwidth() const;
+  int64_t profile() const;  // of the columns: sum of j - first row <= j
 
   void shwVal();
 };
@@ -1,12 +1,17 @@
 // Copyright 2022 Uglinskii Bogdan
 #include "../../../modules/task_3/uglinskii_b_crs_matrix/crs_multiplication.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <random>
 
 #include "tbb/blocked_range.h"
 #include "tbb/parallel_for.h"
 
+#define PARALLEL_SCAN_TBB
+#include "../../../3rdparty/unapproved/parallel_scan.h"
+
 void InitializeMatrix(int rows, int col, int NZ, MatrixCRS *M) {
   M->N = rows;
   M->M = col;
@@ -287,12 +292,10 @@ int CRSMultiplyTBB(MatrixCRS A, MatrixCRS B, MatrixCRS *C) {
   }
   B = Transpose(B);
 
-  std::vector<double> vals;
-  std::vector<int> col;
-  std::vector<int> row_idx{0};
-
   std::vector<std::vector<double>> local_vals(A.N);
   std::vector<std::vector<int>> local_col(A.N);
+  // one more zero count at the end: the exclusive scan puts NZ there
+  std::vector<int> row_NZ(A.N + 1, 0);
   int grain_size = 4;
   tbb::parallel_for(
       tbb::blocked_range<int>(0, A.N, grain_size),
@@ -313,23 +316,27 @@ int CRSMultiplyTBB(MatrixCRS A, MatrixCRS B, MatrixCRS *C) {
               local_vals[i].push_back(S);
             }
           }
+          row_NZ[i] = local_col[i].size();
         }
       });
 
-  int rows_NZ = 0;
-  for (int i = 0; i < A.N; i++) {
-    col.insert(col.end(), local_col[i].begin(), local_col[i].end());
-    vals.insert(vals.end(), local_vals[i].begin(), local_vals[i].end());
-
-    rows_NZ += local_col[i].size();
-    row_idx.push_back(rows_NZ);
-  }
-
-  InitializeMatrix(A.N, B.N, col.size(), C);
-
-  C->col.assign(col.begin(), col.end());
-  C->value.assign(vals.begin(), vals.end());
-  C->row_index.assign(row_idx.begin(), row_idx.end());
+  // row pointers are the prefix sums of the row counts, then every row
+  // is copied to its place in parallel
+  InitializeMatrix(A.N, B.N, 0, C);
+  C->NZ = pscan::exclusive_scan_tbb(row_NZ.data(), C->row_index.data(),
+                                    row_NZ.size());
+  C->col.resize(C->NZ);
+  C->value.resize(C->NZ);
+  tbb::parallel_for(tbb::blocked_range<int>(0, A.N, grain_size),
+                    [&](tbb::blocked_range<int> iter_range) {
+                      for (int i = iter_range.begin(); i < iter_range.end();
+                           i++) {
+                        std::copy(local_col[i].begin(), local_col[i].end(),
+                                  C->col.begin() + C->row_index[i]);
+                        std::copy(local_vals[i].begin(), local_vals[i].end(),
+                                  C->value.begin() + C->row_index[i]);
+                      }
+                    });
 
   return 0;
 }
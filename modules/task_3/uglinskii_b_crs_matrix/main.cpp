@@ -127,6 +127,19 @@ TEST(Multiplication_parallel, 35x35_75) {
   ASSERT_TRUE(CompareMatrixCRS(matrix_C, C_tbb));
 }
 
+TEST(Multiplication_parallel, 30x30_exact_storage) {
+  MatrixCRS matrix_A = GenerateRandomMatrixCRS(30, 30, 90);
+  MatrixCRS matrix_B = GenerateRandomMatrixCRS(30, 30, 90);
+
+  MatrixCRS matrix_C, C_tbb;
+  CRSMultiply(matrix_A, matrix_B, &matrix_C);
+  CRSMultiplyTBB(matrix_A, matrix_B, &C_tbb);
+  ASSERT_EQ(31u, C_tbb.row_index.size());
+  ASSERT_EQ(static_cast<size_t>(C_tbb.NZ), C_tbb.col.size());
+  ASSERT_EQ(static_cast<size_t>(C_tbb.NZ), C_tbb.value.size());
+  ASSERT_TRUE(CompareMatrixCRS(matrix_C, C_tbb));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -1,6 +1,9 @@
 // Copyright 2022 Bakalina Darya
 #include <gtest/gtest.h>
 #include <vector>
+#include <algorithm>
+#include <random>
+#include "../../../3rdparty/unapproved/parallel_merge.h"
 #include "../../../3rdparty/unapproved/unapproved.h"
 #include "./shell_sort_std.h"
 
@@ -55,6 +58,57 @@ TEST(Parallel_algorithm, vector_with_one_size) {
     ASSERT_NO_THROW(v = parallel_shell_sort(v, 2));
 }
 
+TEST(Parallel_algorithm, parallel_shell_sort_big_vector_8_threads) {
+    std::vector<int> v = create_random_vector(10007);
+    std::vector<int> res = v;
+    std::sort(res.begin(), res.end());
+    ASSERT_EQ(res, parallel_shell_sort(v, 8));
+}
+
+TEST(Parallel_algorithm, more_threads_than_elements) {
+    std::vector<int> v = { 3, 1, 2 };
+    std::vector<int> res = { 1, 2, 3 };
+    ASSERT_EQ(res, parallel_shell_sort(v, 8));
+}
+
+TEST(Parallel_algorithm, parallel_merge_k_runs_with_duplicates) {
+    std::mt19937 gen(17);
+    std::vector<std::vector<int>> runs(7);
+    std::vector<int> expected;
+    for (std::size_t i = 0; i < runs.size(); i++) {
+        runs[i].resize(i == 3 ? 0 : gen() % 500);
+        for (int& val : runs[i]) {
+            val = gen() % 20;
+        }
+        std::sort(runs[i].begin(), runs[i].end());
+        expected.insert(expected.end(), runs[i].begin(), runs[i].end());
+    }
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<pmerge::sorted_span<int>> spans;
+    for (const auto& run : runs) {
+        spans.push_back({ run.data(), run.size() });
+    }
+    for (std::size_t threads = 1; threads <= 9; threads++) {
+        std::vector<int> out(expected.size());
+        pmerge::parallel_merge(spans, out.data(), threads);
+        ASSERT_EQ(expected, out);
+    }
+}
+
+TEST(Parallel_algorithm, merge_path_splits_cover_rank) {
+    std::vector<int> a = { 1, 2, 2, 2, 7 };
+    std::vector<int> b = { 2, 2, 3 };
+    std::vector<pmerge::sorted_span<int>> spans = {
+        { a.data(), a.size() }, { b.data(), b.size() } };
+    std::vector<std::size_t> splits = pmerge::merge_path_splits(spans, 4);
+    ASSERT_EQ(4u, splits[0]);
+    ASSERT_EQ(0u, splits[1]);
+    splits = pmerge::merge_path_splits(spans, 6);
+    ASSERT_EQ(4u, splits[0]);
+    ASSERT_EQ(2u, splits[1]);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <iostream>
 #include "../../../modules/task_4/bakalina_d_shell_merge_sort/shell_sort_std.h"
+#include "../../../3rdparty/unapproved/parallel_merge.h"
 #include "../../../3rdparty/unapproved/unapproved.h"
 
 std::vector<int> create_random_vector(int size_n) {
@@ -92,25 +93,29 @@ std::vector<int> merge_two_vector(std::vector<int> vctr_1, std::vector<int> vctr
     return res;
 }
 
-std::vector <int> shell_sort(const std::vector <int>& v) {
-    int size_n = v.size();
-    if (size_n < 1) {
-        throw "Wrong size";
-    }
+void shell_sort_inplace(int* data, int size_n) {
     int iter = 0;
     int i = 0;
     int j = 0;
     int tmp = 0;
-    std::vector <int> res(v);
     for (iter = size_n / 2; iter > 0; iter /= 2) {
         for (i = iter; i < size_n; i++) {
-            for (j = i - iter; j >= 0 && res[j] > res[j + iter]; j -= iter) {
-                tmp = res[j];
-                res[j] = res[j + iter];
-                res[j + iter] = tmp;
+            for (j = i - iter; j >= 0 && data[j] > data[j + iter]; j -= iter) {
+                tmp = data[j];
+                data[j] = data[j + iter];
+                data[j + iter] = tmp;
             }
         }
     }
+}
+
+std::vector <int> shell_sort(const std::vector <int>& v) {
+    int size_n = v.size();
+    if (size_n < 1) {
+        throw "Wrong size";
+    }
+    std::vector <int> res(v);
+    shell_sort_inplace(res.data(), size_n);
     return res;
 }
 
@@ -147,21 +152,27 @@ std::vector <int> parallel_shell_sort(std::vector<int> vctr, std::size_t num_thr
     if (size < 1) {
         throw "Wrong size. It should be greater than 0.";
     }
-    std::vector<std::vector<int>> splited = partition(vctr, num_threads);
+    if (num_threads <= 0) {
+        throw "Invalid number of threads";
+    }
+    num_threads = std::min(num_threads, size);
+
+    // chunks are sorted in place and merged straight from vctr
+    std::vector<pmerge::sorted_span<int>> chunks(num_threads);
     std::vector<std::thread> thrds;
-    std::vector<int> res;
     for (std::size_t i = 0; i < num_threads; i++) {
-        thrds.push_back(std::thread([&splited, i]() {
-            splited[i] = shell_sort(splited[i]);
+        std::size_t start = size * i / num_threads;
+        std::size_t finish = size * (i + 1) / num_threads;
+        chunks[i] = { vctr.data() + start, finish - start };
+        thrds.push_back(std::thread([&vctr, start, finish]() {
+            shell_sort_inplace(vctr.data() + start, finish - start);
             }));
     }
     for (auto& t : thrds) {
         t.join();
     }
-    res = splited[0];
-    for (std::size_t i = 1; i < num_threads; i++) {
-        res = merge_two_vector(res, splited[i]);
-    }
 
+    std::vector<int> res(size);
+    pmerge::parallel_merge(chunks, res.data(), num_threads);
     return res;
 }
@@ -1,6 +1,7 @@
 // Copyright 2018 Nesterov Alexander
 #include "../../modules/task_4/gordey_m_matrix_mult_std/gordey_m_matrix_mult.h"
 #include <omp.h>
+#include "../../../3rdparty/unapproved/parallel_scan.h"
 double* create_random_matrix(int size_n) {
     std::random_device dev;
     std::mt19937 gen(dev());
@@ -126,9 +127,8 @@ void transport(SparseM* v) {
 
 SparseM Mult_parallel(const SparseM& A, const SparseM& B) {
     SparseM C(A);
-    std::vector<double>vals;
-    std::vector<int> rows;
-    std::vector<int>col_idx(B.cols, 0);
+    // one more zero count at the end: the exclusive scan puts NZ there
+    std::vector<int>col_idx(B.cols + 1, 0);
 
     const int nthreads = std::thread::hardware_concurrency();
     const int delta = (B.cols / nthreads) + 1;
@@ -140,24 +140,29 @@ SparseM Mult_parallel(const SparseM& A, const SparseM& B) {
         threads[thread] =
         std::thread(mult_part, thread*delta,
         std::min((thread + 1)*delta, B.cols),
-        B, C, &col_idx, &row, &value, thread);
+        std::cref(B), std::cref(C), &col_idx, &row, &value, thread);
     }
     for (int i = 0; i < nthreads; i++) {
         threads[i].join();
-        for (size_t j = 0; j < value[i].size(); j++) {
-            vals.push_back(value[i][j]);
-            rows.push_back(row[i][j]);
-        }
     }
-    int sum = 0;
-    for (size_t i = 0; i < col_idx.size(); i++) {
-        int tmp = col_idx[i];
-        col_idx[i] = sum;
-        sum = tmp + sum;
+    // column pointers are the prefix sums of the column counts, every
+    // thread then copies its columns to their place
+    int nz = pscan::exclusive_scan_std(col_idx.data(), col_idx.data(),
+                                       col_idx.size());
+    C.row.resize(nz);
+    C.value.resize(nz);
+    for (int thread = 0; thread < nthreads; thread++) {
+        int at = col_idx[std::min(thread*delta, B.cols)];
+        threads[thread] = std::thread([&C, &row, &value, thread, at] {
+            std::copy(row[thread].begin(), row[thread].end(),
+                      C.row.begin() + at);
+            std::copy(value[thread].begin(), value[thread].end(),
+                      C.value.begin() + at);
+        });
+    }
+    for (int i = 0; i < nthreads; i++) {
+        threads[i].join();
     }
-    col_idx.emplace_back(sum);
     C.col_idx = std::move((col_idx));
-    C.row = std::move(rows);
-    C.value = std::move(vals);
     return C;
 }
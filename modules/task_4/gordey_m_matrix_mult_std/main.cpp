@@ -1,7 +1,9 @@
 // Copyright 2018 Nesterov Alexander
 #include <gtest/gtest.h>
+#include <cstdint>
 #include <vector>
 #include "../../../3rdparty/unapproved/unapproved.h"
+#include "../../../3rdparty/unapproved/parallel_scan.h"
 #include "./gordey_m_matrix_mult.h"
 
 TEST(SPARSE_MATRIX_MULT_SEQ, CREATE_MATRIX) {
@@ -97,6 +99,31 @@ TEST(SPARSE_MATRIX_MULT_SEQ, MULT_4) {
     ASSERT_EQ(D, C);
 }
 
+TEST(SPARSE_MATRIX_MULT_STD, PARALLEL_SCAN) {
+    const int n = 1 << 20;
+    std::vector<int64_t> counts(n);
+    std::vector<double> weights(n);
+    for (int i = 0; i < n; i++) {
+        counts[i] = i % 5;
+        weights[i] = 0.5 * (i % 3);
+    }
+    std::vector<int64_t> offsets(n);
+    int64_t total = pscan::exclusive_scan_std(counts.data(), offsets.data(),
+                                              n, int64_t(3));
+    double sum = pscan::inclusive_scan_std(weights.data(), weights.data(),
+                                           n);
+    int64_t expected = 3;
+    double expected_sum = 0;
+    for (int i = 0; i < n; i++) {
+        ASSERT_EQ(expected, offsets[i]);
+        expected += counts[i];
+        expected_sum += 0.5 * (i % 3);
+        ASSERT_DOUBLE_EQ(expected_sum, weights[i]);
+    }
+    ASSERT_EQ(expected, total);
+    ASSERT_DOUBLE_EQ(expected_sum, sum);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,618 @@
+// Copyright 2022 Ivanov Arkady
+#ifndef MODULES_TASK_4_IVANOV_A_RADIX_BATCHERS_MERGESORT_STD_BITONIC_SIMD_H_
+#define MODULES_TASK_4_IVANOV_A_RADIX_BATCHERS_MERGESORT_STD_BITONIC_SIMD_H_
+
+#include <stdint.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define BITONIC_X86
+#include <immintrin.h>
+// The vector types are built for their ISA whatever the target of the
+// build is, the CPU is checked before they are used
+#define BITONIC_SSE41 __attribute__((target("sse4.1")))
+#define BITONIC_AVX2 __attribute__((target("avx2")))
+#endif  // BITONIC_X86
+
+#include <algorithm>
+#include <type_traits>
+
+/*
+* In-register bitonic networks for the radix-Batcher sorter.
+* Every vector type V provides:
+*       reg, lanes, load, store, min, max, reverse,
+*       swap(reg, lane distance), blend<mask>(lo, hi)
+* blend takes the lanes of hi which bits are set in mask. The results go
+* out through a pointer and the registers come in by reference: a vector
+* passed by value between functions built for different ISAs changes the
+* calling convention. The result may only alias the input of min, max
+* and blend.
+* The scalar reference (ScalarVec) runs the very same network on a plain
+* array. sortArray and mergeArrays run sortBlock and mergeRuns with AVX2,
+* then SSE4.1, then the scalar reference, as the CPU supports at run time.
+*/
+namespace bitonic {
+
+template<int D>
+using Dist = std::integral_constant<int, D>;
+
+// Lane i takes the greater element on step (k, j) of the network
+constexpr int hiMask(int lanes, int k, int j, int i = 0) {
+    return i == lanes ? 0 :
+        ((((i & j) != 0) != ((i & k) != 0)) ? (1 << i) : 0) |
+        hiMask(lanes, k, j, i + 1);
+}
+
+// 4 x 32-bit lane mask -> 8 x 16-bit lane mask for _mm_blend_epi16
+constexpr int expandMask(int mask, int i = 0) {
+    return i == 4 ? 0 :
+        (((mask >> i) & 1) ? (3 << (2 * i)) : 0) | expandMask(mask, i + 1);
+}
+
+// <ScalarReference>
+template<class T, int W>
+struct ScalarVec {
+    typedef T value_type;
+    struct reg {
+        T v[W];
+    };
+    static const int lanes = W;
+
+    static void load(reg* r, const T* p) {
+        std::copy(p, p + W, r->v);
+    }
+    static void store(T* p, const reg& a) {
+        std::copy(a.v, a.v + W, p);
+    }
+    static void min(reg* r, const reg& a, const reg& b) {
+        for (int i = 0; i < W; i++)
+            r->v[i] = std::min(a.v[i], b.v[i]);
+    }
+    static void max(reg* r, const reg& a, const reg& b) {
+        for (int i = 0; i < W; i++)
+            r->v[i] = std::max(a.v[i], b.v[i]);
+    }
+    static void reverse(reg* r, const reg& a) {
+        for (int i = 0; i < W; i++)
+            r->v[i] = a.v[W - 1 - i];
+    }
+    template<int D>
+    static void swap(reg* r, const reg& a, Dist<D>) {
+        for (int i = 0; i < W; i++)
+            r->v[i] = a.v[i ^ D];
+    }
+    template<int M>
+    static void blend(reg* r, const reg& lo, const reg& hi) {
+        for (int i = 0; i < W; i++)
+            r->v[i] = ((M >> i) & 1) ? hi.v[i] : lo.v[i];
+    }
+};
+// </ScalarReference>
+
+#ifdef BITONIC_X86
+// <SSE4>
+struct SseInt32 {
+    typedef int32_t value_type;
+    typedef __m128i reg;
+    static const int lanes = 4;
+
+    BITONIC_SSE41 static void load(reg* r, const int32_t* p) {
+        *r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    BITONIC_SSE41 static void store(int32_t* p, const reg& a) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a);
+    }
+    BITONIC_SSE41 static void min(reg* r, const reg& a, const reg& b) {
+        *r = _mm_min_epi32(a, b);
+    }
+    BITONIC_SSE41 static void max(reg* r, const reg& a, const reg& b) {
+        *r = _mm_max_epi32(a, b);
+    }
+    BITONIC_SSE41 static void reverse(reg* r, const reg& a) {
+        *r = _mm_shuffle_epi32(a, 0x1B);
+    }
+    BITONIC_SSE41 static void swap(reg* r, const reg& a, Dist<2>) {
+        *r = _mm_shuffle_epi32(a, 0x4E);
+    }
+    BITONIC_SSE41 static void swap(reg* r, const reg& a, Dist<1>) {
+        *r = _mm_shuffle_epi32(a, 0xB1);
+    }
+    template<int M>
+    BITONIC_SSE41 static void blend(reg* r, const reg& lo, const reg& hi) {
+        *r = _mm_blend_epi16(lo, hi, Dist<expandMask(M)>::value);
+    }
+};
+
+struct SseUInt32 : SseInt32 {
+    typedef uint32_t value_type;
+
+    BITONIC_SSE41 static void load(reg* r, const uint32_t* p) {
+        *r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    BITONIC_SSE41 static void store(uint32_t* p, const reg& a) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a);
+    }
+    BITONIC_SSE41 static void min(reg* r, const reg& a, const reg& b) {
+        *r = _mm_min_epu32(a, b);
+    }
+    BITONIC_SSE41 static void max(reg* r, const reg& a, const reg& b) {
+        *r = _mm_max_epu32(a, b);
+    }
+};
+
+struct SseDouble {
+    typedef double value_type;
+    typedef __m128d reg;
+    static const int lanes = 2;
+
+    BITONIC_SSE41 static void load(reg* r, const double* p) {
+        *r = _mm_loadu_pd(p);
+    }
+    BITONIC_SSE41 static void store(double* p, const reg& a) {
+        _mm_storeu_pd(p, a);
+    }
+    BITONIC_SSE41 static void min(reg* r, const reg& a, const reg& b) {
+        *r = _mm_min_pd(a, b);
+    }
+    BITONIC_SSE41 static void max(reg* r, const reg& a, const reg& b) {
+        *r = _mm_max_pd(a, b);
+    }
+    BITONIC_SSE41 static void reverse(reg* r, const reg& a) {
+        *r = _mm_shuffle_pd(a, a, 1);
+    }
+    BITONIC_SSE41 static void swap(reg* r, const reg& a, Dist<1>) {
+        *r = _mm_shuffle_pd(a, a, 1);
+    }
+    template<int M>
+    BITONIC_SSE41 static void blend(reg* r, const reg& lo, const reg& hi) {
+        *r = _mm_blend_pd(lo, hi, M);
+    }
+};
+// </SSE4>
+
+// <AVX2>
+struct Avx2Int32 {
+    typedef int32_t value_type;
+    typedef __m256i reg;
+    static const int lanes = 8;
+
+    BITONIC_AVX2 static void load(reg* r, const int32_t* p) {
+        *r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    BITONIC_AVX2 static void store(int32_t* p, const reg& a) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+    }
+    BITONIC_AVX2 static void min(reg* r, const reg& a, const reg& b) {
+        *r = _mm256_min_epi32(a, b);
+    }
+    BITONIC_AVX2 static void max(reg* r, const reg& a, const reg& b) {
+        *r = _mm256_max_epi32(a, b);
+    }
+    BITONIC_AVX2 static void reverse(reg* r, const reg& a) {
+        *r = _mm256_permutevar8x32_epi32(a,
+            _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    }
+    BITONIC_AVX2 static void swap(reg* r, const reg& a, Dist<4>) {
+        *r = _mm256_permute2x128_si256(a, a, 1);
+    }
+    BITONIC_AVX2 static void swap(reg* r, const reg& a, Dist<2>) {
+        *r = _mm256_shuffle_epi32(a, 0x4E);
+    }
+    BITONIC_AVX2 static void swap(reg* r, const reg& a, Dist<1>) {
+        *r = _mm256_shuffle_epi32(a, 0xB1);
+    }
+    template<int M>
+    BITONIC_AVX2 static void blend(reg* r, const reg& lo, const reg& hi) {
+        *r = _mm256_blend_epi32(lo, hi, M);
+    }
+};
+
+struct Avx2UInt32 : Avx2Int32 {
+    typedef uint32_t value_type;
+
+    BITONIC_AVX2 static void load(reg* r, const uint32_t* p) {
+        *r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    BITONIC_AVX2 static void store(uint32_t* p, const reg& a) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+    }
+    BITONIC_AVX2 static void min(reg* r, const reg& a, const reg& b) {
+        *r = _mm256_min_epu32(a, b);
+    }
+    BITONIC_AVX2 static void max(reg* r, const reg& a, const reg& b) {
+        *r = _mm256_max_epu32(a, b);
+    }
+};
+
+struct Avx2Double {
+    typedef double value_type;
+    typedef __m256d reg;
+    static const int lanes = 4;
+
+    BITONIC_AVX2 static void load(reg* r, const double* p) {
+        *r = _mm256_loadu_pd(p);
+    }
+    BITONIC_AVX2 static void store(double* p, const reg& a) {
+        _mm256_storeu_pd(p, a);
+    }
+    BITONIC_AVX2 static void min(reg* r, const reg& a, const reg& b) {
+        *r = _mm256_min_pd(a, b);
+    }
+    BITONIC_AVX2 static void max(reg* r, const reg& a, const reg& b) {
+        *r = _mm256_max_pd(a, b);
+    }
+    BITONIC_AVX2 static void reverse(reg* r, const reg& a) {
+        *r = _mm256_permute4x64_pd(a, 0x1B);
+    }
+    BITONIC_AVX2 static void swap(reg* r, const reg& a, Dist<2>) {
+        *r = _mm256_permute2f128_pd(a, a, 1);
+    }
+    BITONIC_AVX2 static void swap(reg* r, const reg& a, Dist<1>) {
+        *r = _mm256_permute_pd(a, 0x5);
+    }
+    template<int M>
+    BITONIC_AVX2 static void blend(reg* r, const reg& lo, const reg& hi) {
+        *r = _mm256_blend_pd(lo, hi, M);
+    }
+};
+// </AVX2>
+#endif  // BITONIC_X86
+
+// <Network>
+// Compare-exchange steps j, j / 2, ..., 1 of the stage k
+template<class V, int K, int J>
+struct Steps {
+    static void apply(typename V::reg* v) {
+        typename V::reg p, lo, hi;
+        V::swap(&p, *v, Dist<J>());
+        V::min(&lo, *v, p);
+        V::max(&hi, *v, p);
+        V::template blend<hiMask(V::lanes, K, J)>(v, lo, hi);
+        Steps<V, K, J / 2>::apply(v);
+    }
+};
+
+template<class V, int K>
+struct Steps<V, K, 0> {
+    static void apply(typename V::reg*) {}
+};
+
+template<class V, int K, bool Done = (K > V::lanes)>
+struct Stages {
+    static void apply(typename V::reg* v) {
+        Steps<V, K, K / 2>::apply(v);
+        Stages<V, K * 2>::apply(v);
+    }
+};
+
+template<class V, int K>
+struct Stages<V, K, true> {
+    static void apply(typename V::reg*) {}
+};
+
+// Sorts the lanes of a single register
+template<class V>
+void sortRegister(typename V::reg* v) {
+    Stages<V, 2>::apply(v);
+}
+
+// a and b are sorted, on exit a holds the lower and b the upper half
+template<class V>
+void mergeRegisters(typename V::reg* a, typename V::reg* b) {
+    typename V::reg r;
+    V::reverse(&r, *b);
+    V::max(b, *a, r);
+    V::min(a, *a, r);
+    Steps<V, 2 * V::lanes, V::lanes / 2>::apply(a);
+    Steps<V, 2 * V::lanes, V::lanes / 2>::apply(b);
+}
+// </Network>
+
+// <ArrayKernels>
+template<class T>
+void scalarMerge(const T* a, int na, const T* b, int nb, T* out) {
+    int i = 0, j = 0;
+    while (i < na && j < nb)
+        *out++ = (b[j] < a[i]) ? b[j++] : a[i++];
+    out = std::copy(a + i, a + na, out);
+    std::copy(b + j, b + nb, out);
+}
+
+// Merges sorted a[0, na) and b[0, nb) into out lanes elements at a time:
+// the next register always comes from the run with the smaller head, so
+// everything stored is not greater than anything left
+template<class V>
+void mergeRuns(const typename V::value_type* a, int na,
+    const typename V::value_type* b, int nb, typename V::value_type* out) {
+    typedef typename V::value_type T;
+    const int W = V::lanes;
+    if (na < W || nb < W) {
+        scalarMerge(a, na, b, nb, out);
+        return;
+    }
+
+    typename V::reg lo, hi;
+    V::load(&lo, a);
+    V::load(&hi, b);
+    int i = W, j = W;
+    while (true) {
+        mergeRegisters<V>(&lo, &hi);
+        V::store(out, lo);
+        out += W;
+
+        bool takeA = j >= nb || (i < na && a[i] <= b[j]);
+        if (takeA && i + W <= na) {
+            V::load(&lo, a + i);
+            i += W;
+        } else if (!takeA && j + W <= nb) {
+            V::load(&lo, b + j);
+            j += W;
+        } else {
+            break;
+        }
+    }
+
+    // Three sorted leftovers: the register and both tails
+    T rest[W];
+    V::store(rest, hi);
+    int k = 0;
+    while (k < W || i < na || j < nb) {
+        if (k < W && (i >= na || rest[k] <= a[i]) &&
+            (j >= nb || rest[k] <= b[j]))
+            *out++ = rest[k++];
+        else if (i < na && (j >= nb || a[i] <= b[j]))
+            *out++ = a[i++];
+        else
+            *out++ = b[j++];
+    }
+}
+
+// Sorts data[0, n): every register-sized piece is sorted in place, then
+// the runs are merged bottom-up ping-ponging with tmp (n elements)
+template<class V>
+void sortBlock(typename V::value_type* data, int n,
+    typename V::value_type* tmp) {
+    typedef typename V::value_type T;
+    const int W = V::lanes;
+    int full = n - n % W;
+    for (int i = 0; i < full; i += W) {
+        typename V::reg v;
+        V::load(&v, data + i);
+        sortRegister<V>(&v);
+        V::store(data + i, v);
+    }
+    for (int i = full + 1; i < n; i++) {
+        T key = data[i];
+        int j = i;
+        for (; j > full && key < data[j - 1]; j--)
+            data[j] = data[j - 1];
+        data[j] = key;
+    }
+
+    T* src = data;
+    T* dst = tmp;
+    for (int width = W; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = std::min(lo + width, n);
+            int hi = std::min(lo + 2 * width, n);
+            mergeRuns<V>(src + lo, mid - lo, src + mid, hi - mid, dst + lo);
+        }
+        std::swap(src, dst);
+    }
+    if (src != data)
+        std::copy(src, src + n, data);
+}
+
+// Number of elements a[0, i) that the lower n of merge(a, b) takes,
+// the rest of it is b[0, n - i). Both runs have n elements
+template<class T>
+int coRank(const T* a, const T* b, int n) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int i = (lo + hi) / 2;
+        if (b[n - i - 1] >= a[i])
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+// </ArrayKernels>
+
+// <Kernels>
+// Every kernel is one function of the ISA of V with the whole network
+// flattened into it, the intrinsics are not inlined into code built for
+// another ISA. sortLanes and mergeLanes run sortRegister and
+// mergeRegisters on memory.
+template<class V>
+struct ScalarKernels {
+    typedef typename V::value_type T;
+    static const int lanes = V::lanes;
+
+    static void sort(T* data, int n, T* tmp) {
+        sortBlock<V>(data, n, tmp);
+    }
+    static void merge(const T* a, int na, const T* b, int nb, T* out) {
+        mergeRuns<V>(a, na, b, nb, out);
+    }
+    static void sortLanes(T* p) {
+        typename V::reg v;
+        V::load(&v, p);
+        sortRegister<V>(&v);
+        V::store(p, v);
+    }
+    static void mergeLanes(T* a, T* b) {
+        typename V::reg lo, hi;
+        V::load(&lo, a);
+        V::load(&hi, b);
+        mergeRegisters<V>(&lo, &hi);
+        V::store(a, lo);
+        V::store(b, hi);
+    }
+};
+
+#ifdef BITONIC_X86
+template<class V>
+struct Sse41Kernels {
+    typedef typename V::value_type T;
+    static const int lanes = V::lanes;
+
+    __attribute__((target("sse4.1"), flatten))
+    static void sort(T* data, int n, T* tmp) {
+        sortBlock<V>(data, n, tmp);
+    }
+    __attribute__((target("sse4.1"), flatten))
+    static void merge(const T* a, int na, const T* b, int nb, T* out) {
+        mergeRuns<V>(a, na, b, nb, out);
+    }
+    __attribute__((target("sse4.1"), flatten))
+    static void sortLanes(T* p) {
+        typename V::reg v;
+        V::load(&v, p);
+        sortRegister<V>(&v);
+        V::store(p, v);
+    }
+    __attribute__((target("sse4.1"), flatten))
+    static void mergeLanes(T* a, T* b) {
+        typename V::reg lo, hi;
+        V::load(&lo, a);
+        V::load(&hi, b);
+        mergeRegisters<V>(&lo, &hi);
+        V::store(a, lo);
+        V::store(b, hi);
+    }
+};
+
+template<class V>
+struct Avx2Kernels {
+    typedef typename V::value_type T;
+    static const int lanes = V::lanes;
+
+    __attribute__((target("avx2"), flatten))
+    static void sort(T* data, int n, T* tmp) {
+        sortBlock<V>(data, n, tmp);
+    }
+    __attribute__((target("avx2"), flatten))
+    static void merge(const T* a, int na, const T* b, int nb, T* out) {
+        mergeRuns<V>(a, na, b, nb, out);
+    }
+    __attribute__((target("avx2"), flatten))
+    static void sortLanes(T* p) {
+        typename V::reg v;
+        V::load(&v, p);
+        sortRegister<V>(&v);
+        V::store(p, v);
+    }
+    __attribute__((target("avx2"), flatten))
+    static void mergeLanes(T* a, T* b) {
+        typename V::reg lo, hi;
+        V::load(&lo, a);
+        V::load(&hi, b);
+        mergeRegisters<V>(&lo, &hi);
+        V::store(a, lo);
+        V::store(b, hi);
+    }
+};
+#endif  // BITONIC_X86
+// </Kernels>
+
+// <Dispatch>
+enum Isa { ISA_SCALAR, ISA_SSE41, ISA_AVX2 };
+
+inline Isa detectIsa() {
+#ifdef BITONIC_X86
+    if (__builtin_cpu_supports("avx2"))
+        return ISA_AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return ISA_SSE41;
+#endif  // BITONIC_X86
+    return ISA_SCALAR;
+}
+
+// The best ISA of this CPU, checked once
+inline Isa cpuIsa() {
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+// The kernels of every ISA for T, only the scalar ones by default
+template<class T>
+struct Simd {
+    typedef ScalarKernels<ScalarVec<T, 4> > scalar;
+    static const bool hasVectors = false;
+};
+
+#ifdef BITONIC_X86
+template<> struct Simd<int32_t> {
+    typedef ScalarKernels<ScalarVec<int32_t, 4> > scalar;
+    typedef Sse41Kernels<SseInt32> sse41;
+    typedef Avx2Kernels<Avx2Int32> avx2;
+    static const bool hasVectors = true;
+};
+template<> struct Simd<uint32_t> {
+    typedef ScalarKernels<ScalarVec<uint32_t, 4> > scalar;
+    typedef Sse41Kernels<SseUInt32> sse41;
+    typedef Avx2Kernels<Avx2UInt32> avx2;
+    static const bool hasVectors = true;
+};
+template<> struct Simd<double> {
+    typedef ScalarKernels<ScalarVec<double, 4> > scalar;
+    typedef Sse41Kernels<SseDouble> sse41;
+    typedef Avx2Kernels<Avx2Double> avx2;
+    static const bool hasVectors = true;
+};
+#endif  // BITONIC_X86
+
+template<class T, bool = Simd<T>::hasVectors>
+struct Dispatch {
+    static void sort(T* data, int n, T* tmp) {
+        Simd<T>::scalar::sort(data, n, tmp);
+    }
+    static void merge(const T* a, int na, const T* b, int nb, T* out) {
+        Simd<T>::scalar::merge(a, na, b, nb, out);
+    }
+};
+
+template<class T>
+struct Dispatch<T, true> {
+    static void sort(T* data, int n, T* tmp) {
+        switch (cpuIsa()) {
+        case ISA_AVX2:
+            Simd<T>::avx2::sort(data, n, tmp);
+            break;
+        case ISA_SSE41:
+            Simd<T>::sse41::sort(data, n, tmp);
+            break;
+        default:
+            Simd<T>::scalar::sort(data, n, tmp);
+        }
+    }
+    static void merge(const T* a, int na, const T* b, int nb, T* out) {
+        switch (cpuIsa()) {
+        case ISA_AVX2:
+            Simd<T>::avx2::merge(a, na, b, nb, out);
+            break;
+        case ISA_SSE41:
+            Simd<T>::sse41::merge(a, na, b, nb, out);
+            break;
+        default:
+            Simd<T>::scalar::merge(a, na, b, nb, out);
+        }
+    }
+};
+
+// sortBlock and mergeRuns with the best kernels of this CPU
+template<class T>
+void sortArray(T* data, int n, T* tmp) {
+    Dispatch<T>::sort(data, n, tmp);
+}
+
+template<class T>
+void mergeArrays(const T* a, int na, const T* b, int nb, T* out) {
+    Dispatch<T>::merge(a, na, b, nb, out);
+}
+// </Dispatch>
+
+}  // namespace bitonic
+
+#endif  // MODULES_TASK_4_IVANOV_A_RADIX_BATCHERS_MERGESORT_STD_BITONIC_SIMD_H_
@@ -1,6 +1,9 @@
 // Copyright 2022 Ivanov Arkady
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <limits>
+
 #include "./rbms.h"
 
 
@@ -22,7 +25,7 @@ bool isRndSortTestCorrect(size_t size, int degree, T from, T to) {
     std::vector<T> checkVector(data);
 
     radixBatchersMergesort_std<T>(&data, degree);
-    radixSort<T>(&checkVector, 0, size);
+    std::sort(checkVector.begin(), checkVector.end());
 
     return isVecSame(data, checkVector);
 }
@@ -48,8 +51,88 @@ bool isEfficiencyTestCorrect(size_t size, const int degree) {
 
     return isVecSame(data, checkVector);
 }
+
+bool isSimdEfficiencyTestCorrect(size_t size, const int degree) {
+    std::vector<uint32_t> data(size);
+    fillVecWithRandValues<uint32_t>(data.data(), size, 0, ~0);
+    std::vector<uint32_t> checkVector(data);
+
+    volatile double st1 = omp_get_wtime();
+    radixBatchersMergesort_std<uint32_t>(&checkVector, degree, false);
+    volatile double st2 = omp_get_wtime();
+
+    volatile double pt1 = omp_get_wtime();
+    radixBatchersMergesort_std<uint32_t>(&data, degree);
+    volatile double pt2 = omp_get_wtime();
+
+    std::cout << "Scalar path time: " << st2 - st1 << std::endl;
+    std::cout << "SIMD path time: " << pt2 - pt1 << std::endl;
+    std::cout << "Ratio scalar/SIMD: " << (st2 - st1) / (pt2 - pt1)
+        << std::endl << std::flush;
+
+    return isVecSame(data, checkVector);
+}
 #endif  // USE_EFFICIENCY_TESTS
 
+// K holds the kernels of one vector type
+template<class K>
+bool isNetworkCorrect(int runs) {
+    typedef typename K::T T;
+    const int W = K::lanes;
+    for (int run = 0; run < runs; run++) {
+        std::vector<T> a(W), b(W);
+        for (int i = 0; i < W; i++) {
+            a[i] = static_cast<T>(getRandValue<int>(-50, 50));
+            b[i] = static_cast<T>(getRandValue<int>(-50, 50));
+        }
+        std::vector<T> expected(a);
+        std::sort(expected.begin(), expected.end());
+        K::sortLanes(a.data());
+        if (!isVecSame(a, expected))
+            return false;
+
+        std::sort(b.begin(), b.end());
+        expected.insert(expected.end(), b.begin(), b.end());
+        std::sort(expected.begin(), expected.end());
+        K::mergeLanes(a.data(), b.data());
+        std::vector<T> merged(a);
+        merged.insert(merged.end(), b.begin(), b.end());
+        if (!isVecSame(merged, expected))
+            return false;
+    }
+    return true;
+}
+
+// every kernel set of T this CPU runs
+template<class T>
+bool isNetworkCorrectOnCpu(int runs) {
+    typedef bitonic::Simd<T> S;
+    if (!isNetworkCorrect<typename S::scalar>(runs))
+        return false;
+#ifdef BITONIC_X86
+    if (bitonic::cpuIsa() >= bitonic::ISA_SSE41 &&
+        !isNetworkCorrect<typename S::sse41>(runs))
+        return false;
+    if (bitonic::cpuIsa() >= bitonic::ISA_AVX2 &&
+        !isNetworkCorrect<typename S::avx2>(runs))
+        return false;
+#endif  // BITONIC_X86
+    return true;
+}
+
+template<class T>
+bool isBlockSortCorrect(int size) {
+    std::vector<T> data(size);
+    for (int i = 0; i < size; i++)
+        data[i] = static_cast<T>(getRandValue<int>(-1000, 1000)) / 4;
+    std::vector<T> expected(data), tmp(size), reference(data);
+    std::sort(expected.begin(), expected.end());
+
+    bitonic::sortArray<T>(data.data(), size, tmp.data());
+    bitonic::Simd<T>::scalar::sort(reference.data(), size, tmp.data());
+    return isVecSame(data, expected) && isVecSame(reference, expected);
+}
+
 // [12, 11, ..., 10, 1] -> [1, 2, ..., 11, 12] on 4 threads
 TEST(rbms_check, can_sort_diff_sized_vect_1) {
     ASSERT_TRUE(isStrictDescendingTest(12, 2));
@@ -94,6 +177,91 @@ TEST(rbms_check, rnd_vecSize_rnd_vec_4_thr_short_int) {
     ASSERT_TRUE(isRndSortTestCorrect<uint16_t>(size, 2, 0, ~0));
 }
 
+TEST(rbms_check, bitonic_network_int32) {
+    ASSERT_TRUE(isNetworkCorrectOnCpu<int32_t>(200));
+    ASSERT_TRUE(isNetworkCorrectOnCpu<uint32_t>(200));
+    ASSERT_TRUE((isNetworkCorrect<bitonic::ScalarKernels<
+        bitonic::ScalarVec<int32_t, 8> > >(200)));
+}
+
+TEST(rbms_check, bitonic_network_double) {
+    ASSERT_TRUE(isNetworkCorrectOnCpu<double>(200));
+}
+
+TEST(rbms_check, bitonic_block_sort_odd_sizes) {
+    for (int size : {0, 1, 7, 9, 31, 100, 1001}) {
+        ASSERT_TRUE(isBlockSortCorrect<int32_t>(size));
+        ASSERT_TRUE(isBlockSortCorrect<double>(size));
+    }
+}
+
+// negative keys are padded and sorted correctly on 4 threads
+TEST(rbms_check, rnd_vec_4_thr_signed_int) {
+    ASSERT_TRUE(isRndSortTestCorrect<int32_t>(1001, 2, -100000, 100000));
+}
+
+TEST(rbms_check, rnd_vec_8_thr_double) {
+    std::vector<double> data(5003);
+    for (double& val : data)
+        val = getRandValue<int>(-1000000, 1000000) / 128.0;
+    std::vector<double> checkVector(data);
+    std::sort(checkVector.begin(), checkVector.end());
+
+    radixBatchersMergesort_std<double>(&data, 3);
+    ASSERT_TRUE(isVecSame(data, checkVector));
+}
+
+// the padding of 5003 keys to 8 blocks must not push the +inf out
+TEST(rbms_check, rnd_vec_8_thr_double_with_inf) {
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> data(5003);
+    for (double& val : data)
+        val = getRandValue<int>(-1000000, 1000000) / 128.0;
+    data[17] = inf;
+    data[4000] = -inf;
+    data[5002] = inf;
+    std::vector<double> checkVector(data);
+    std::sort(checkVector.begin(), checkVector.end());
+
+    radixBatchersMergesort_std<double>(&data, 3);
+    ASSERT_TRUE(isVecSame(data, checkVector));
+    ASSERT_EQ(inf, data.back());
+}
+
+TEST(rbms_check, simd_and_scalar_paths_match) {
+    std::vector<uint32_t> data(20000);
+    fillVecWithRandValues<uint32_t>(data.data(), data.size(), 0, ~0);
+    std::vector<uint32_t> checkVector(data);
+
+    radixBatchersMergesort_std<uint32_t>(&data, 2);
+    radixBatchersMergesort_std<uint32_t>(&checkVector, 2, false);
+    ASSERT_TRUE(isVecSame(data, checkVector));
+    ASSERT_TRUE(isAscending(data.data(), data.size()));
+}
+
+TEST(rbms_check, barrier_is_reusable) {
+    const int numThreads = 4, rounds = 1000;
+    Barrier barrier(numThreads);
+    std::vector<int> counters(numThreads, 0);
+    std::atomic<bool> isCorrect(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int r = 1; r <= rounds; r++) {
+                counters[t] = r;
+                barrier.wait();
+                for (int other = 0; other < numThreads; other++)
+                    if (counters[other] != r)
+                        isCorrect = false;
+                barrier.wait();
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    ASSERT_TRUE(isCorrect);
+}
+
 #if USE_EFFICIENCY_TESTS == 1
 
 // 1 000 000 elements on 4 threads
@@ -115,6 +283,23 @@ TEST(rbms_efficiency_check, test_100mil_8thrd) {
 TEST(rbms_efficiency_check, test_100mil_16thrd) {
     ASSERT_TRUE(isEfficiencyTestCorrect(100000000, 4));
 }
+
+// SIMD leaves and merges against the scalar path, 1M .. 256M elements
+TEST(rbms_efficiency_check, test_simd_1mil_8thrd) {
+    ASSERT_TRUE(isSimdEfficiencyTestCorrect(1000000, 3));
+}
+
+TEST(rbms_efficiency_check, test_simd_16mil_8thrd) {
+    ASSERT_TRUE(isSimdEfficiencyTestCorrect(16000000, 3));
+}
+
+TEST(rbms_efficiency_check, test_simd_64mil_16thrd) {
+    ASSERT_TRUE(isSimdEfficiencyTestCorrect(64000000, 4));
+}
+
+TEST(rbms_efficiency_check, test_simd_256mil_16thrd) {
+    ASSERT_TRUE(isSimdEfficiencyTestCorrect(256000000, 4));
+}
 #endif  // USE_EFFICIENCY_TESTS
 
 
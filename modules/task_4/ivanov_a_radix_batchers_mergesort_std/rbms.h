@@ -22,39 +22,30 @@
 #include <condition_variable>  // NOLINT [build/c++11]
 #include <mutex>  // NOLINT [build/c++11]
 #include <thread>  // NOLINT [build/c++11]
+#include <limits>
+#include <type_traits>
+
+#include "./bitonic_simd.h"
 
 
 /*
-* Barrier class
-* In parallel code can't be called sequentially
-* or there will be a possibility of a deadlock +
-* barrier crossing of single thread
-* NOT TO DO: {
+* Sense-reversing barrier
+* Every crossing flips the shared sense, a thread waits until the sense
+* differs from the one it arrived with, so the same barrier can be used
+* for any number of consecutive waits: {
 *       // work
 *       barrier.wait();
 *       // work
 *       barrier.wait();
 * }
-*
-* insted use 2 alternating barriers: {
-*       // work
-*       barrier1.wait();
-*       // work
-*       barrier2.wait();
-*       // work
-*       barrier1.wait();
-*       // work
-*       barrier2.wait();
-*       // etc
-* }
 */
 class Barrier {
  private:
     const unsigned int threadCount;
-    volatile unsigned int threadsWaiting;
+    unsigned int threadsWaiting;
+    bool sense;
     std::condition_variable waitVariable;
     std::mutex mutex;
-    volatile bool isLocked;
 
  public:
     Barrier() = delete;
@@ -64,22 +55,18 @@ class Barrier {
     explicit Barrier(unsigned int n) :
         threadCount(n),
         threadsWaiting(0),
-        isLocked(true) {}
-
+        sense(false) {}
 
     void wait() {
         std::unique_lock<std::mutex> lk(mutex);
-        ++threadsWaiting;
-        if (threadsWaiting >= threadCount) {
+        const bool arrivalSense = sense;
+        if (++threadsWaiting == threadCount) {
             threadsWaiting = 0;
-            isLocked = false;
-
+            sense = !sense;
             lk.unlock();
             waitVariable.notify_all();
         } else {
-            while (isLocked && threadsWaiting != 0)
-                waitVariable.wait(lk);
-            isLocked = true;  // to make reusable
+            waitVariable.wait(lk, [&] { return sense != arrivalSense; });
         }
     }
 };
@@ -154,6 +141,20 @@ void radixSort(std::vector<T>* data, int offset, int count) {
             data->operator[](i + offset) = res[i];
     }
 }
+// Radix sort only orders unsigned keys correctly and its 256 * sizeof(T)
+// counters do not pay off on small blocks, the bitonic SIMD merge sort
+// takes the rest
+const int SIMD_LEAF_LIMIT = 4096;
+
+template<class T>
+void sortLeaf(std::vector<T>* data, int offset, int count) {
+    if (std::is_unsigned<T>::value && count > SIMD_LEAF_LIMIT) {
+        radixSort<T>(data, offset, count);
+        return;
+    }
+    std::vector<T> tmp(count);
+    bitonic::sortArray<T>(data->data() + offset, count, tmp.data());
+}
 // </RadixSortPart>
 
 // <ServiceFunctions>
@@ -232,7 +233,7 @@ bool isVecSame(const std::vector<T>& v1, const std::vector<T>& v2) {
 
 // <STD REALISATION>
 template<class T>
-void mergeFragments(T* data, T* res, T* partnerData,
+void mergeFragmentsScalar(T* data, T* res, T* partnerData,
     int blockSize, int selfID, int partnerID) {
     if (selfID == partnerID)
         return;
@@ -304,15 +305,39 @@ void mergeFragments(T* data, T* res, T* partnerData,
     }
 }
 
+// Keeps the lower (selfID < partnerID) or the upper half of the two
+// merged blocks. Both threads find the same split point of the pair, so
+// each of them merges exactly its own blockSize elements with SIMD
 template<class T>
-void singleThreadComputing(int selfID, Barrier* b1, Barrier* b2, Barrier* b3,
+void mergeFragments(T* data, T* res, T* partnerData,
+    int blockSize, int selfID, int partnerID) {
+    if (selfID == partnerID)
+        return;
+
+    bool isLeft = selfID < partnerID;
+    const T* low = isLeft ? data : partnerData;
+    const T* high = isLeft ? partnerData : data;
+    int split = bitonic::coRank(low, high, blockSize);
+
+    if (isLeft)
+        bitonic::mergeArrays<T>(low, split, high, blockSize - split, res);
+    else
+        bitonic::mergeArrays<T>(low + split, blockSize - split,
+            high + blockSize - split, split, res);
+}
+
+template<class T>
+void singleThreadComputing(int selfID, Barrier* barrier,
     T** from, T** to, std::vector<T>* data, int blockSize,
-    int degree, T* mainData) {
+    int degree, T* mainData, bool useSimd) {
     // sort step
-    radixSort<T>(data, selfID * blockSize, blockSize);
+    if (useSimd)
+        sortLeaf<T>(data, selfID * blockSize, blockSize);
+    else
+        radixSort<T>(data, selfID * blockSize, blockSize);
 
     // barrier
-    b3->wait();
+    barrier->wait();
 
     // merge step
     // Batcher's merge network realisation
@@ -322,12 +347,17 @@ void singleThreadComputing(int selfID, Barrier* b1, Barrier* b2, Barrier* b3,
         for (int step = 1; step <= stage; step++) {
             partnerID = partner(selfID, stage, step);
 
-            mergeFragments(from[selfID], to[selfID], from[partnerID], blockSize, selfID, partnerID);
-            b1->wait();
+            if (useSimd)
+                mergeFragments(from[selfID], to[selfID], from[partnerID],
+                    blockSize, selfID, partnerID);
+            else
+                mergeFragmentsScalar(from[selfID], to[selfID],
+                    from[partnerID], blockSize, selfID, partnerID);
+            barrier->wait();
 
             if (selfID != partnerID)
                 std::swap(from[selfID], to[selfID]);
-            b2->wait();
+            barrier->wait();
 
             if (stage == degree && step == degree) {
                 for (int i = 0; i < blockSize; i++)
@@ -335,26 +365,36 @@ void singleThreadComputing(int selfID, Barrier* b1, Barrier* b2, Barrier* b3,
             }
         }
     }
-    b3->wait();
+    barrier->wait();
 }
 
+// The padding sorts after every key, max() would sort before a +inf of
+// the data and push it out when the padding is cut off. A +inf padding
+// ties with it, the kept prefix is the same
 template<class T>
-void radixBatchersMergesort_std(std::vector<T>* data, int degree) {
-    if (degree == 0) {  // numThreads = 1
-        radixSort<T>(data, 0, data->size());
-        return;
-    }
+T padValue() {
+    return std::numeric_limits<T>::has_infinity ?
+        std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+}
 
+// useSimd = false runs the former radix leaves + scalar merge path
+template<class T>
+void radixBatchersMergesort_std(std::vector<T>* data, int degree,
+    bool useSimd = true) {
     int numThreads = 1 << degree;
-    if (numThreads > static_cast<int>(data->size())) {
-        radixSort<T>(data, 0, data->size());
+    if (degree == 0 || numThreads > static_cast<int>(data->size())) {
+        if (useSimd)
+            sortLeaf<T>(data, 0, data->size());
+        else
+            radixSort<T>(data, 0, data->size());
         return;
     }
 
     size_t oldSize = data->size();
     bool isResized = false;
     if (oldSize % numThreads != 0) {
-        data->resize(oldSize + (numThreads - oldSize % numThreads), ~0);
+        data->resize(oldSize + (numThreads - oldSize % numThreads),
+            padValue<T>());
         isResized = true;
     }
 
@@ -373,15 +413,15 @@ void radixBatchersMergesort_std(std::vector<T>* data, int degree) {
     T* mainData = data->data();
 
 
-    Barrier b1(numThreads), b2(numThreads), b3(numThreads);
+    Barrier barrier(numThreads);
 
     std::vector<std::thread> threads;
 
 
     for (int selfID = 0; selfID < numThreads; selfID++) {
         threads.emplace_back(singleThreadComputing<T>,
-            selfID, &b1, &b2, &b3,
-            from, to, data, blockSize, degree, mainData);
+            selfID, &barrier,
+            from, to, data, blockSize, degree, mainData, useSimd);
 
 #if WIN32 == 1 && USE_EFFICIENCY_TESTS == 1
         unsigned int offset;
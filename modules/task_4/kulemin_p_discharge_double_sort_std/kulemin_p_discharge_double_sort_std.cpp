@@ -5,8 +5,10 @@
 #include <random>
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
 #include "../../modules/task_4/kulemin_p_discharge_double_sort_std/kulemin_p_discharge_double_sort_std.h"
 #include "../../../3rdparty/unapproved/unapproved.h"
+#include "../../../3rdparty/unapproved/double_keys.h"
 
 vector* create_random_vector(int size_n) {
     std::random_device dev;
@@ -17,45 +19,121 @@ vector* create_random_vector(int size_n) {
     }
     return in;
 }
-void discharge(vector* v, std::vector<std::list<double>>* list,
-int begin, int end, size_t byte) {
-    for (int i = begin; i < end; i++) {
-        unsigned char* pt = (unsigned char*)(v->ptr + i);
-        (*list)[*(pt + byte)].push_back(v->ptr[i]);
-    }
+namespace {
+using dkeys::kDigitMask;
+using dkeys::kDigitSize;
+using dkeys::load_key;
+using dkeys::store_key;
+
+template <class Func>
+void run_threads(int nthreads, Func func) {
+    std::vector<std::thread> threads(nthreads);
+    for (int t = 0; t < nthreads; t++)
+        threads[t] = std::thread(func, t);
+    for (auto& thread : threads)
+        thread.join();
 }
-void union_from_lists(std::list<double> *lists, vector* v) {
-    int j = v->last_el;
-    while (!lists->empty()) {
-        v->ptr[j] = ((*lists).front());
-        (*lists).pop_front();
-        j++;
+}  // namespace
+
+void double_radix_sort(double* data, int size, double* scratch) {
+    if (size < 2)
+        return;
+    std::vector<double> own_scratch;
+    if (scratch == nullptr) {
+        own_scratch.resize(size);
+        scratch = own_scratch.data();
     }
-    v->last_el = j;
+
+    dkeys::sort(data, size, scratch);
 }
-void discharge_sort(vector* v) {
-    const int nthreads = std::thread::hardware_concurrency();
-    std::thread* threads = new std::thread[nthreads];
-    const int delta = (v->size / nthreads) + 1;
-    std::vector<std::list<double>>* lists =
-    new std::vector<std::list<double>>[nthreads];
-    for (int i = 0; i < nthreads; i++)lists[i].resize(256);
-    for (size_t j = 0; j < sizeof(double); j++) {
-        v->last_el = 0;
-        for (int i = 0; i < nthreads; i++) {
-            threads[i] = std::thread(discharge, v, &(lists[i]),
-            i*delta, std::min((i + 1)*delta, v->size), j);
-            threads[i].join();
+
+void double_radix_sort_std(double* data, int size, int nthreads) {
+    if (nthreads <= 0)
+        nthreads = std::max(1u, std::thread::hardware_concurrency());
+    nthreads = std::min(nthreads, size / static_cast<int>(kDigitSize) + 1);
+    if (nthreads == 1) {
+        double_radix_sort(data, size);
+        return;
+    }
+
+    std::vector<int> bounds(nthreads + 1);
+    for (int t = 0; t <= nthreads; t++)
+        bounds[t] = static_cast<int>(static_cast<int64_t>(size) * t / nthreads);
+
+    std::vector<uint64_t> local_min(nthreads, ~0ull);
+    std::vector<uint64_t> local_max(nthreads, 0);
+    run_threads(nthreads, [&](int t) {
+        for (int i = bounds[t]; i < bounds[t + 1]; i++) {
+            uint64_t key = dkeys::to_key(load_key(data, i));
+            store_key(data, i, key);
+            local_min[t] = std::min(local_min[t], key);
+            local_max[t] = std::max(local_max[t], key);
         }
-        for (int t = 0; t < 256; t++) {
-            for (int k = 0; k < nthreads; k++) {
-                union_from_lists(&lists[k][t], v);
-            }
+    });
+
+    int shift = dkeys::top_digit_shift(
+        *std::min_element(local_min.begin(), local_min.end()),
+        *std::max_element(local_max.begin(), local_max.end()));
+
+    std::vector<double> scratch(size);
+    std::vector<size_t> offsets(nthreads * kDigitSize, 0);
+    run_threads(nthreads, [&](int t) {
+        size_t* count = offsets.data() + t * kDigitSize;
+        for (int i = bounds[t]; i < bounds[t + 1]; i++)
+            count[(load_key(data, i) >> shift) & kDigitMask]++;
+    });
+
+    std::vector<size_t> bucket_begin(kDigitSize + 1);
+    size_t offset = 0;
+    for (int d = 0; d < kDigitSize; d++) {
+        bucket_begin[d] = offset;
+        for (int t = 0; t < nthreads; t++) {
+            size_t tmp_count = offsets[t * kDigitSize + d];
+            offsets[t * kDigitSize + d] = offset;
+            offset += tmp_count;
         }
-        v->last_el = 0;
     }
-    delete[] lists;
-    delete[] threads;
+    bucket_begin[kDigitSize] = offset;
+
+    run_threads(nthreads, [&](int t) {
+        size_t* cursor = offsets.data() + t * kDigitSize;
+        for (int i = bounds[t]; i < bounds[t + 1]; i++) {
+            uint64_t key = load_key(data, i);
+            store_key(scratch.data(), cursor[(key >> shift) & kDigitMask]++,
+                      key);
+        }
+    });
+
+    // Buckets are already in their final places, each thread takes a
+    // contiguous range of them holding about size / nthreads keys
+    std::vector<int> first_bucket(nthreads + 1, kDigitSize);
+    first_bucket[0] = 0;
+    for (int t = 1, d = 0; t < nthreads; t++) {
+        size_t target = static_cast<size_t>(size) * t / nthreads;
+        while (d < kDigitSize && bucket_begin[d + 1] <= target)
+            d++;
+        first_bucket[t] = d;
+    }
+
+    run_threads(nthreads, [&](int t) {
+        std::vector<size_t> count(dkeys::kMaxPasses * kDigitSize);
+        for (int d = first_bucket[t]; d < first_bucket[t + 1]; d++) {
+            size_t begin = bucket_begin[d];
+            size_t n = bucket_begin[d + 1] - begin;
+            if (n == 0)
+                continue;
+            double* sorted = dkeys::lsd_sort_keys(scratch.data() + begin,
+                                                  data + begin, n, shift,
+                                                  count.data());
+            for (size_t i = 0; i < n; i++)
+                store_key(data, begin + i,
+                          dkeys::from_key(load_key(sorted, i)));
+        }
+    });
+}
+
+void discharge_sort(vector* v) {
+    double_radix_sort_std(v->ptr, v->size);
 }
 bool check_vectors(double* st, double* sd, int size) {
     bool res = true;
@@ -2,7 +2,6 @@
 #ifndef MODULES_TASK_4_KULEMIN_P_DISCHARGE_DOUBLE_SORT_STD_KULEMIN_P_DISCHARGE_DOUBLE_SORT_STD_H_
 #define MODULES_TASK_4_KULEMIN_P_DISCHARGE_DOUBLE_SORT_STD_KULEMIN_P_DISCHARGE_DOUBLE_SORT_STD_H_
 #include <vector>
-#include <list>
 struct vector {
     double* ptr;
     int last_el;
@@ -28,6 +27,7 @@ struct vector {
     }
     vector& operator= (const vector& in) {
         if (this != &in) {
+            delete[] this->ptr;
             this->ptr = new double[in.size];
             this->size = in.size;
             this->last_el = in.last_el;
@@ -37,7 +37,13 @@ struct vector {
     }
 };
 vector* create_random_vector(int size_n);
-void union_from_lists(std::list<double>* lists, vector* v);
+// In place sort by the IEEE-754 bit pattern of the keys with 11-bit LSD
+// passes. scratch must hold size doubles, nullptr makes it allocate one
+void double_radix_sort(double* data, int size, double* scratch = nullptr);
+// Partitions the keys by their most significant digit on nthreads threads,
+// then every thread sorts its own buckets in place, no merge is needed.
+// nthreads == 0 means std::thread::hardware_concurrency()
+void double_radix_sort_std(double* data, int size, int nthreads = 0);
 void discharge_sort(vector* v);
 bool check_vectors(double* st, double* sd, int size);
 void copy_vectors(double* st, double* sd, int size);
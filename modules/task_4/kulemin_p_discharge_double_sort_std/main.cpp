@@ -1,6 +1,10 @@
 // Copyright 2018 Nesterov Alexander
 #include <gtest/gtest.h>
 #include <vector>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <cmath>
 #include "../../../3rdparty/unapproved/unapproved.h"
 #include "../../modules/task_4/kulemin_p_discharge_double_sort_std/kulemin_p_discharge_double_sort_std.h"
 
@@ -60,6 +64,44 @@ TEST(Parallel_Operations_OpenMP, Test_200) {
     delete sd;
     ASSERT_EQ(true, res);
 }
+TEST(Parallel_Operations_OpenMP, Test_Special_Values) {
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> data = {std::nan(""), 3.5, -inf, 0.0, -1e-300,
+        inf, -0.0, -7.25, 1e300, 0.0, -0.0};
+    double_radix_sort(data.data(), static_cast<int>(data.size()));
+    std::vector<double> expected = {-inf, -7.25, -1e-300, -0.0, -0.0,
+        0.0, 0.0, 3.5, 1e300, inf};
+    ASSERT_TRUE(std::isnan(data.back()));
+    ASSERT_EQ(expected, std::vector<double>(data.begin(), data.end() - 1));
+    ASSERT_TRUE(std::signbit(data[3]) && std::signbit(data[4]));
+    ASSERT_FALSE(std::signbit(data[5]) || std::signbit(data[6]));
+}
+TEST(Parallel_Operations_OpenMP, Test_Negative_Parallel) {
+    int count = 100000;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1e6, 1e6);
+    std::vector<double> data(count);
+    for (double& val : data) val = dist(gen);
+    std::vector<double> expected = data;
+    std::sort(expected.begin(), expected.end());
+    for (int nthreads = 2; nthreads <= 5; nthreads++) {
+        std::vector<double> local = data;
+        double_radix_sort_std(local.data(), count, nthreads);
+        ASSERT_EQ(expected, local);
+    }
+}
+TEST(Parallel_Operations_OpenMP, Test_Narrow_Range_Parallel) {
+    int count = 50000;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> dist(1.0, 2.0);
+    std::vector<double> data(count);
+    for (double& val : data) val = dist(gen);
+    data[100] = data[200];
+    std::vector<double> expected = data;
+    std::sort(expected.begin(), expected.end());
+    double_radix_sort_std(data.data(), count, 4);
+    ASSERT_EQ(expected, data);
+}
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -1,9 +1,20 @@
 // Copyright 2022 Novozhilov Alexander
 #include <omp.h>
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
 #include <vector>
 #include "./matrix_mult.h"
 
+namespace {
+std::string writeFile(const std::string& text) {
+    const std::string path = "novozhilov_matrix_market_test.mtx";
+    std::ofstream(path) << text;
+    return path;
+}
+}  // namespace
+
 TEST(Matrix_Multiplication_STD, get_works) {
     SparseMatrix matrix(3, 3);
     EXPECT_NO_THROW(matrix.get(1, 1));
@@ -42,6 +53,87 @@ TEST(Matrix_Multiplication_STD, parallel_multiplication_returns_same_result) {
     ASSERT_TRUE(result1 == result2);
 }
 
+TEST(Matrix_Multiplication_STD, parallel_multiplication_heavy_and_light_rows) {
+    // rows 0 and 1 of the product are full (dense accumulator), the rest
+    // have at most two products each (hash accumulator)
+    const int size = 200;
+    std::vector<std::vector<std::complex<int>>> a(size,
+        std::vector<std::complex<int>>(size));
+    std::vector<std::vector<std::complex<int>>> b = a;
+    for (int j = 0; j < size; j++) {
+        a[0][j] = std::complex<int>(1, j % 3);
+        a[1][j] = std::complex<int>(j % 5, -1);
+        b[j][j] = std::complex<int>(2, 1);
+        b[j][(j * 7) % size] += std::complex<int>(-1, 3);
+    }
+    for (int i = 2; i < size; i++) {
+        a[i][(i * 11) % size] = std::complex<int>(3, -2);
+    }
+    SparseMatrix matrix1(a);
+    SparseMatrix matrix2(b);
+    ASSERT_TRUE(matrix1.multiply_parallel(matrix2)
+        == matrix1.multiply_seq(matrix2));
+}
+
+TEST(Matrix_Multiplication_STD, read_matrix_market_general) {
+    const std::string path = writeFile(
+        "%%MatrixMarket matrix coordinate complex general\n"
+        "% a comment\n"
+        "3 4 4\n"
+        "3 1 -2 5\n"
+        "1 4 7 0\n"
+        "1 2 1 -1\n"
+        "2 3 0 3\n");
+    SparseMatrix expected(std::vector<std::vector<std::complex<int>>>{
+        {{0, 0}, {1, -1}, {0, 0}, {7, 0}},
+        {{0, 0}, {0, 0}, {0, 3}, {0, 0}},
+        {{-2, 5}, {0, 0}, {0, 0}, {0, 0}}});
+    for (unsigned threads = 1; threads <= 3; threads++) {
+        ASSERT_TRUE(readMatrixMarket(path, threads) == expected);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(Matrix_Multiplication_STD, read_matrix_market_symmetries) {
+    std::string path = writeFile(
+        "%%MatrixMarket matrix coordinate integer symmetric\n"
+        "2 2 2\n1 1 4\n2 1 -3\n");
+    SparseMatrix symmetric(std::vector<std::vector<std::complex<int>>>{
+        {{4, 0}, {-3, 0}}, {{-3, 0}, {0, 0}}});
+    ASSERT_TRUE(readMatrixMarket(path, 2) == symmetric);
+
+    path = writeFile(
+        "%%MatrixMarket matrix coordinate complex hermitian\n"
+        "2 2 2\n1 1 2 0\n2 1 1 3\n");
+    SparseMatrix hermitian(std::vector<std::vector<std::complex<int>>>{
+        {{2, 0}, {1, -3}}, {{1, 3}, {0, 0}}});
+    ASSERT_TRUE(readMatrixMarket(path, 2) == hermitian);
+
+    path = writeFile(
+        "%%MatrixMarket matrix coordinate pattern skew-symmetric\n"
+        "2 2 1\n2 1\n");
+    SparseMatrix skew(std::vector<std::vector<std::complex<int>>>{
+        {{0, 0}, {-1, 0}}, {{1, 0}, {0, 0}}});
+    ASSERT_TRUE(readMatrixMarket(path, 2) == skew);
+    std::remove(path.c_str());
+}
+
+TEST(Matrix_Multiplication_STD, read_matrix_market_rejects_bad_files) {
+    const char* bad[] = {
+        "%%MatrixMarket matrix coordinate real general\n1 1 1\n1 1 1.5\n",
+        "%%MatrixMarket matrix coordinate integer general\n1 1 1\n1 1 2.5\n",
+        "%%MatrixMarket matrix coordinate integer general\n"
+        "1 1 1\n1 1 2147483648\n",
+        "%%MatrixMarket matrix coordinate integer general\n2 2 2\n1 1 1\n",
+        "%%MatrixMarket matrix coordinate integer general\n2 2 1\n3 1 1\n",
+        "%%MatrixMarket matrix coordinate integer symmetric\n3 2 1\n2 1 1\n"};
+    for (const char* text : bad) {
+        const std::string path = writeFile(text);
+        EXPECT_ANY_THROW(readMatrixMarket(path, 2)) << text;
+        std::remove(path.c_str());
+    }
+}
+
 // TEST(Matrix_Multiplication_STD, parallel_multiplication_works) {
 //   SparseMatrix matrix1(100, 100);
 //   SparseMatrix matrix2(100, 100);
@@ -1,9 +1,15 @@
 // Copyright 2022 Novozhilov Alexander
 #include <omp.h>
+#include <algorithm>
+#include <thread>  // NOLINT [build/c++11]
 #include <vector>
 #include <string>
 #include <random>
 #include <iostream>
+#include <utility>
+#include "../../../3rdparty/unapproved/matrix_market.h"
+#include "../../../3rdparty/unapproved/parallel_scan.h"
+#include "../../../3rdparty/unapproved/row_accumulator.h"
 #include "../../../modules/task_4/novozhilov_a_matrix_multiplication/matrix_mult.h"
 
 SparseMatrix::SparseMatrix(int _m, int _n) {
@@ -43,6 +49,42 @@ SparseMatrix::SparseMatrix(std::vector<std::vector<std::complex<int>>> matrix) {
     }
 }
 
+SparseMatrix::SparseMatrix(int _m, int _n,
+                           std::vector<std::complex<int>> _values,
+                           std::vector<int> _columnIndexes,
+                           std::vector<int> _rowCounter)
+    : m(_m), n(_n), values(std::move(_values)),
+      columnIndexes(std::move(_columnIndexes)),
+      rowCounter(std::move(_rowCounter)) {
+    if (static_cast<int>(rowCounter.size()) != m + 1
+        || rowCounter[m] != static_cast<int>(values.size())
+        || columnIndexes.size() != values.size()) {
+        throw std::invalid_argument("inconsistent CRS arrays");
+    }
+}
+
+SparseMatrix readMatrixMarket(const std::string& path, unsigned threads) {
+    mmarket::FileMap file(path);
+    const mmarket::Header header = mmarket::read_header(file, path);
+    if (header.field == mmarket::Field::Real) {
+        throw std::runtime_error("real Matrix Market values are not integers");
+    }
+    mmarket::Csr<int, std::complex<int>> csr =
+        mmarket::read_entries<int, std::complex<int>>(file, header, threads,
+            [](mmarket::Cursor& in, mmarket::Field field) {
+                if (field == mmarket::Field::Pattern) {
+                    return std::complex<int>(1, 0);
+                }
+                const int re = in.integer<int>();
+                const int im =
+                    field == mmarket::Field::Complex ? in.integer<int>() : 0;
+                return std::complex<int>(re, im);
+            });
+    return SparseMatrix(static_cast<int>(csr.rows),
+                        static_cast<int>(csr.cols), std::move(csr.val),
+                        std::move(csr.col_index), std::move(csr.row_index));
+}
+
 SparseMatrix SparseMatrix::multiply_seq(const SparseMatrix& matrix) const {
     if (n != matrix.m) {
         throw std::invalid_argument("invalid matrix size");
@@ -65,39 +107,94 @@ SparseMatrix SparseMatrix::multiply_parallel(const SparseMatrix& matrix) const {
     if (n != matrix.m) {
         throw std::invalid_argument("invalid matrix size");
     }
-    std::vector<std::thread> threads;
-    std::vector<std::vector<std::complex<int>>> resultMatrix = getEmptyMatrix(m, matrix.n);
-    int nthreads = std::thread::hardware_concurrency();
-    int step = m / nthreads;
-    int remains = m % nthreads;
-    if (step == 0) {
-        return multiply_seq(matrix);
-    }
-    for (int i = 0, currentThread = 0; i < m; i+=step, currentThread++) {
-        int from = i;
-        int to = i + step;
-        if (currentThread == nthreads - 1 && remains != 0) {
-            to += remains;
-            i = m;
+    // Gustavson: row i of the result accumulates a(i, k) * row k of matrix
+    // in a dense or a hash accumulator picked by its product count. The
+    // right values are split into re/im so that the products of a(i, k)
+    // with a whole row are computed by vector code
+    const std::vector<int>& bRow = matrix.rowCounter;
+    std::vector<int> bRe(matrix.values.size()), bIm(matrix.values.size());
+    for (size_t j = 0; j < matrix.values.size(); j++) {
+        bRe[j] = matrix.values[j].real();
+        bIm[j] = matrix.values[j].imag();
+    }
+
+    // rows are split between the threads by their product counts
+    std::vector<size_t> products(m + 1, 0);
+    for (int i = 0; i < m; i++) {
+        for (int k = rowCounter[i]; k < rowCounter[i + 1]; k++) {
+            products[i] += bRow[columnIndexes[k] + 1] - bRow[columnIndexes[k]];
         }
-        threads.push_back(std::thread(
-            [from, to, this, &matrix, &resultMatrix]() {
-                std::complex<int> tmp;
-                for (int i = from; i < to; i++) {
-                    for (int j = 0; j < matrix.n; j++) {
-                        tmp = std::complex<int>();
-                        for (int k = 0; k < n; k++) {
-                            tmp += get(i, k) * matrix.get(k, j);
-                        }
-                        resultMatrix[i][j] = tmp;
-                    }
+    }
+    std::vector<size_t> productStart(m + 1);
+    const size_t total = pscan::exclusive_scan_std(products.data(),
+        productStart.data(), m + 1);
+    int nthreads = std::max(1u, std::thread::hardware_concurrency());
+    nthreads = std::max(1, std::min(nthreads, m));
+    std::vector<int> firstRow(nthreads + 1, m);
+    firstRow[0] = 0;
+    for (int t = 1; t < nthreads; t++) {
+        firstRow[t] = std::lower_bound(productStart.begin(),
+            productStart.end() - 1, total / nthreads * t)
+            - productStart.begin();
+    }
+
+    // every thread collects its rows in its own arrays, the row counts
+    // become rowCounter through a prefix sum and the arrays are copied out
+    std::vector<int> rowNonZeros(m + 1, 0);
+    std::vector<std::vector<int>> threadCol(nthreads);
+    std::vector<std::vector<std::complex<int>>> threadVal(nthreads);
+    auto worker = [&](int t) {
+        rowacc::RowAccumulator<int, int> acc(matrix.n);
+        std::vector<int> re, im;
+        for (int i = firstRow[t]; i < firstRow[t + 1]; i++) {
+            acc.begin(products[i]);
+            for (int k = rowCounter[i]; k < rowCounter[i + 1]; k++) {
+                const int ar = values[k].real(), ai = values[k].imag();
+                const int begin = bRow[columnIndexes[k]];
+                const int count = bRow[columnIndexes[k] + 1] - begin;
+                if (static_cast<int>(re.size()) < count) {
+                    re.resize(count);
+                    im.resize(count);
+                }
+                const int* br = bRe.data() + begin;
+                const int* bi = bIm.data() + begin;
+                for (int j = 0; j < count; j++) {
+                    re[j] = ar * br[j] - ai * bi[j];
+                    im[j] = ar * bi[j] + ai * br[j];
                 }
-            }));
+                acc.add(matrix.columnIndexes.data() + begin, re.data(),
+                    im.data(), count);
+            }
+            const size_t before = threadCol[t].size();
+            acc.finish([&](int c, int valueRe, int valueIm) {
+                threadCol[t].push_back(c);
+                threadVal[t].push_back(std::complex<int>(valueRe, valueIm));
+            });
+            rowNonZeros[i] = static_cast<int>(threadCol[t].size() - before);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < nthreads; t++) {
+        threads.push_back(std::thread(worker, t));
     }
-    for (int i = 0; i < static_cast<int>(threads.size()); i++) {
-        threads[i].join();
+    worker(0);
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
     }
-    return SparseMatrix(resultMatrix);
+
+    std::vector<int> resultRows(m + 1);
+    const int nonZeros = pscan::exclusive_scan_std(rowNonZeros.data(),
+        resultRows.data(), m + 1);
+    std::vector<int> resultCols(nonZeros);
+    std::vector<std::complex<int>> resultValues(nonZeros);
+    for (int t = 0; t < nthreads; t++) {
+        std::copy(threadCol[t].begin(), threadCol[t].end(),
+            resultCols.begin() + resultRows[firstRow[t]]);
+        std::copy(threadVal[t].begin(), threadVal[t].end(),
+            resultValues.begin() + resultRows[firstRow[t]]);
+    }
+    return SparseMatrix(m, matrix.n, std::move(resultValues),
+        std::move(resultCols), std::move(resultRows));
 }
 
 int SparseMatrix::getM() const {
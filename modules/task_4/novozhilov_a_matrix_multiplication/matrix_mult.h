@@ -18,6 +18,9 @@ class SparseMatrix {
  public:
     SparseMatrix(int m, int n);
     explicit SparseMatrix(std::vector<std::vector<std::complex<int>>> matrix);
+    // takes ready CRS arrays, the columns of every row sorted
+    SparseMatrix(int m, int n, std::vector<std::complex<int>> values,
+                 std::vector<int> columnIndexes, std::vector<int> rowCounter);
     SparseMatrix multiply_seq(const SparseMatrix& matrix)const;
     SparseMatrix multiply_parallel(const SparseMatrix& matrix)const;
     int getM()const;
@@ -32,5 +35,12 @@ class SparseMatrix {
     std::vector<std::vector<std::complex<int>>> getEmptyMatrix(int m, int n) const;
 };
 
+// Reads a Matrix Market coordinate file of integer, complex (with
+// integral parts) or pattern field and any symmetry straight into CRS
+// with the parallel reader of 3rdparty/unapproved/matrix_market.h: the
+// file is mapped, parsed by threads and put in row order by a counting
+// sort, no dense matrix is built. A real field is rejected.
+// threads == 0 means std::thread::hardware_concurrency()
+SparseMatrix readMatrixMarket(const std::string& path, unsigned threads = 0);
 
 #endif  // MODULES_TASK_4_NOVOZHILOV_A_MATRIX_MULTIPLICATION_MATRIX_MULT_H_
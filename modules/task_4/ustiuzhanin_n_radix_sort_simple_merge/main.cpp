@@ -2,6 +2,8 @@
 #include <gtest/gtest.h>
 #include <vector>
 #include <iostream>
+#include <chrono>  // NOLINT [build/c++11]
+#include <thread>  // NOLINT [build/c++11]
 #include "./radix_sort.h"
 
 using std::vector;
@@ -65,6 +67,50 @@ TEST(STD_RADIX_SORT, TEST_WRONG_DATA) {
     ASSERT_ANY_THROW(radixSortSTD(&data));
 }
 
+TEST(STD_RADIX_SORT, TEST_SAME_AS_SEQUENTIAL) {
+    vector<int> data;
+    size_t size = 100000;
+    size_t countRad = 9;
+
+    randomVector(&data, size, countRad);
+    vector<int> check = data;
+    radixSort(&check);
+
+    for (int threads = 1; threads <= 8; threads++) {
+        vector<int> local = data;
+        radixSortSTD(&local, threads);
+        ASSERT_EQ(check, local);
+    }
+}
+
+TEST(STD_RADIX_SORT, TEST_THROUGHPUT) {
+    vector<int> data;
+    size_t size = 200000;
+    size_t countRad = 9;
+
+    randomVector(&data, size, countRad);
+    vector<int> check = data;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    radixSortDecimal(&check);
+    auto end = std::chrono::high_resolution_clock::now();
+    double baseTime = std::chrono::duration<double>(end - start).count();
+    cout << "Decimal list sort: " << size / baseTime << " keys/sec\n";
+
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= maxThreads; threads++) {
+        vector<int> local = data;
+        start = std::chrono::high_resolution_clock::now();
+        radixSortSTD(&local, threads);
+        end = std::chrono::high_resolution_clock::now();
+        double time = std::chrono::duration<double>(end - start).count();
+        cout << "Byte LSD sort, " << threads << " threads: "
+             << size / time << " keys/sec, speedup "
+             << baseTime / time << '\n';
+        ASSERT_EQ(check, local);
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
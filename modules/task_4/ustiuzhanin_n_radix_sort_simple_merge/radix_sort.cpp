@@ -8,6 +8,7 @@
 #include <string>
 #include "../../../pp_2022_spring/modules/task_4/ustiuzhanin_n_radix_sort_simple_merge/radix_sort.h"
 #include "../../../3rdparty/unapproved/unapproved.h"
+#include "../../../3rdparty/unapproved/parallel_scan.h"
 
 using std::vector;
 using std::list;
@@ -44,13 +45,36 @@ size_t rad(size_t value) {
     return counter;
 }
 
-void radixSort(vector<int>* data) {
+const size_t kRadixBits = 8;
+const size_t kRadixSize = 1 << kRadixBits;
+const unsigned kRadixMask = kRadixSize - 1;
+
+void checkNonNegative(const vector<int>& data) {
+    if (std::find_if(data.begin(), data.end(), [](int val) {
+        return val < 0; }) != data.end())
+        throw std::string("Try sort numbers less then 0");
+}
+
+// Number of 8-bit digits needed to represent every key of the array
+size_t countBytePasses(const vector<int>& data) {
+    unsigned maxVal = *std::max_element(data.begin(), data.end());
+    size_t passes = 0;
+    while (maxVal != 0) {
+        maxVal >>= kRadixBits;
+        passes++;
+    }
+    return passes;
+}
+
+unsigned getByte(int val, size_t pass) {
+    return (static_cast<unsigned>(val) >> (pass * kRadixBits)) & kRadixMask;
+}
+
+void radixSortDecimal(vector<int>* data) {
     if (!data->size())
         return;
 
-    if (std::find_if(data->begin(), data->end(), [](int val) {
-        return val < 0; }) != data->end())
-        throw std::string("Try sort numbers less then 0");
+    checkNonNegative(*data);
 
     size_t maxRad = rad(*std::max_element(data->begin(), data->end()));
 
@@ -72,6 +96,40 @@ void radixSort(vector<int>* data) {
     }
 }
 
+void radixSort(vector<int>* data) {
+    if (!data->size())
+        return;
+
+    checkNonNegative(*data);
+    size_t passes = countBytePasses(*data);
+
+    vector<int> buffer(data->size());
+    int* src = data->data();
+    int* dst = buffer.data();
+    size_t count[kRadixSize];
+
+    for (size_t pass = 0; pass < passes; pass++) {
+        std::fill(count, count + kRadixSize, 0);
+        for (size_t i = 0; i < data->size(); i++)
+            count[getByte(src[i], pass)]++;
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < kRadixSize; digit++) {
+            size_t tmp = count[digit];
+            count[digit] = offset;
+            offset += tmp;
+        }
+
+        for (size_t i = 0; i < data->size(); i++)
+            dst[count[getByte(src[i], pass)]++] = src[i];
+
+        std::swap(src, dst);
+    }
+
+    if (src != data->data())
+        std::copy(src, src + data->size(), data->data());
+}
+
 vector<int> simpleMerge(const vector<int>& firstVector,
     const vector<int>& secondVector) {
     vector<int> resultVector(firstVector.size() + secondVector.size());
@@ -97,53 +155,65 @@ vector<int> simpleMerge(const vector<int>& firstVector,
     return resultVector;
 }
 
-void radixSortSTD(vector<int>* data) {
+void radixSortSTD(vector<int>* data, int numberOfThread) {
     if (!data->size())
         return;
 
-    if (std::find_if(data->begin(), data->end(), [](int val) {
-        return val < 0; }) != data->end())
-        throw std::string("Try sort numbers less then 0");
-
-    int numberOfThread = std::thread::hardware_concurrency();
-    int dataPortion = data->size() / numberOfThread;
-
-    vector<vector<int>> vecOfVec(numberOfThread);
-
-    std::promise<vector<int>>* promises =
-        new std::promise<vector<int>>[numberOfThread];
-    std::future<vector<int>>* futures =
-        new std::future<vector<int>>[numberOfThread];
-    std::thread* threads = new std::thread[numberOfThread];
-
-    for (int i = 0; i < numberOfThread; ++i) {
-        futures[i] = promises[i].get_future();
-        vector<int> local;
-
-        if (i != numberOfThread - 1) {
-            local = { data->begin() + i * dataPortion,
-                     data->begin() + (i + 1) * dataPortion };
-        } else {
-            local = { data->begin() + i * dataPortion, data->end() };
+    checkNonNegative(*data);
+    size_t passes = countBytePasses(*data);
+
+    if (numberOfThread <= 0)
+        numberOfThread = std::max(1u, std::thread::hardware_concurrency());
+    size_t threads = std::min(static_cast<size_t>(numberOfThread),
+                              data->size());
+    size_t dataPortion = data->size() / threads;
+
+    vector<size_t> bounds(threads + 1);
+    for (size_t t = 0; t < threads; t++)
+        bounds[t] = t * dataPortion;
+    bounds[threads] = data->size();
+
+    vector<int> buffer(data->size());
+    int* src = data->data();
+    int* dst = buffer.data();
+    // Digit-major table: entry digit * threads + t counts the keys of the
+    // digit in chunk t, so its exclusive scan gives every chunk a cursor
+    // right after the keys of the digit in chunks 0..t-1 and the scatter
+    // stays stable
+    vector<size_t> offsets(kRadixSize * threads);
+    vector<std::thread> workers(threads);
+
+    for (size_t pass = 0; pass < passes; pass++) {
+        for (size_t t = 0; t < threads; t++) {
+            workers[t] = std::thread([&, t]() {
+                size_t count[kRadixSize] = {};
+                for (size_t i = bounds[t]; i < bounds[t + 1]; i++)
+                    count[getByte(src[i], pass)]++;
+                for (size_t digit = 0; digit < kRadixSize; digit++)
+                    offsets[digit * threads + t] = count[digit];
+            });
         }
+        for (auto& worker : workers)
+            worker.join();
+
+        pscan::exclusive_scan_std(offsets.data(), offsets.data(),
+                                  offsets.size());
+
+        for (size_t t = 0; t < threads; t++) {
+            workers[t] = std::thread([&, t]() {
+                size_t cursor[kRadixSize];
+                for (size_t digit = 0; digit < kRadixSize; digit++)
+                    cursor[digit] = offsets[digit * threads + t];
+                for (size_t i = bounds[t]; i < bounds[t + 1]; i++)
+                    dst[cursor[getByte(src[i], pass)]++] = src[i];
+            });
+        }
+        for (auto& worker : workers)
+            worker.join();
 
-        threads[i] = std::thread([](vector<int>* commonVector,
-            std::promise<vector<int>>&& pr) {
-            radixSort(commonVector);
-            pr.set_value(std::move(*commonVector));
-            }, &local, std::move(promises[i]));
-        threads[i].join();
-        vecOfVec[i] = futures[i].get();
-    }
-
-    vector<int> resultVector = vecOfVec[0];
-    for (int i = 1; i < numberOfThread; ++i) {
-        resultVector = simpleMerge(resultVector, vecOfVec[i]);
+        std::swap(src, dst);
     }
 
-    delete[] promises;
-    delete[] futures;
-    delete[] threads;
-
-    *data = resultVector;
+    if (src != data->data())
+        std::copy(src, src + data->size(), data->data());
 }
@@ -9,9 +9,11 @@ using std::vector;
 void randomVector(vector<int>* data, size_t size, size_t rad);
 size_t rad(size_t value);
 int getNum(int val, size_t pos);
+void radixSortDecimal(vector<int>* data);
 void radixSort(vector<int>* data);
 vector<int> simpleMerge(const vector<int>& firstVector,
     const vector<int>& secondVector);
-void radixSortSTD(vector<int>* data);
+// numberOfThread == 0 means std::thread::hardware_concurrency()
+void radixSortSTD(vector<int>* data, int numberOfThread = 0);
 
 #endif  // MODULES_TASK_4_USTIUZHANIN_N_RADIX_SORT_SIMPLE_MERGE_RADIX_SORT_H_
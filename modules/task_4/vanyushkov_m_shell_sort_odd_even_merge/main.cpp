@@ -1,7 +1,12 @@
 // Copyright 2022 Vanyushkov Maxim
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>  // NOLINT [build/c++11]
 #include "./sort.h"
 
+// set to 1 to compare the thread placement policies on a large array
+#define USE_PLACEMENT_BENCHMARK 0
+
 bool test(int size) {
     std::vector<int> vec_seq = getRandomVector(size);
     std::vector<int> vec_par = vec_seq;
@@ -44,6 +49,63 @@ TEST(ShellSort, test_size_12323) {
     ASSERT_TRUE(test(12323));
 }
 
+TEST(ShellSort, every_placement_sorts) {
+    std::vector<int> expected = getRandomVector(20011);
+    std::vector<int> vec_compact = expected, vec_scatter = expected;
+    std::sort(expected.begin(), expected.end());
+    ShellSortParallel(&vec_compact, Placement::Compact);
+    ShellSortParallel(&vec_scatter, Placement::Scatter, 7);
+    ASSERT_EQ(expected, vec_compact);
+    ASSERT_EQ(expected, vec_scatter);
+}
+
+TEST(ShellSort, placement_cpus_are_a_permutation) {
+    std::vector<int> compact = placementCpus(Placement::Compact);
+    std::vector<int> scatter = placementCpus(Placement::Scatter);
+    ASSERT_TRUE(placementCpus(Placement::None).empty());
+    for (size_t i = 1; i < compact.size(); i++) {
+        ASSERT_LE(numaNodeOfCpu(compact[i - 1]), numaNodeOfCpu(compact[i]));
+    }
+    std::sort(scatter.begin(), scatter.end());
+    std::sort(compact.begin(), compact.end());
+    ASSERT_EQ(compact, scatter);
+    if (!compact.empty()) {
+        // pinned in a thread of its own, the later tests keep every CPU
+        bool pinned = false;
+        std::thread scratch([&pinned, &compact] {
+            pinned = pinThisThread(compact.front());
+        });
+        scratch.join();
+        ASSERT_TRUE(pinned);
+    }
+}
+
+TEST(ShellSort, more_threads_than_keys) {
+    std::vector<int> vec = { 3, 1, 2 };
+    ShellSortParallel(&vec, Placement::Scatter, 8);
+    ASSERT_EQ(std::vector<int>({ 1, 2, 3 }), vec);
+}
+
+#if USE_PLACEMENT_BENCHMARK == 1
+TEST(ShellSort, placement_benchmark) {
+    const int size = 1 << 24;
+    std::vector<int> source = getRandomVector(size);
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const char* names[] = { "none", "compact", "scatter" };
+    const Placement policies[] = { Placement::None, Placement::Compact,
+                                   Placement::Scatter };
+    for (int p = 0; p < 3; p++) {
+        std::vector<int> vec = source;
+        auto start = std::chrono::high_resolution_clock::now();
+        ShellSortParallel(&vec, policies[p], threads);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << names[p] << ": " << std::chrono::duration_cast
+            <std::chrono::milliseconds>(end - start).count() << " ms\n";
+        ASSERT_TRUE(checkSort(vec));
+    }
+}
+#endif
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
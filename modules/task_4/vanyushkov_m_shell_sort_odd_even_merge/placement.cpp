@@ -0,0 +1,81 @@
+// Copyright 2022 Vanyushkov Maxim
+#include "../../../modules/task_4/vanyushkov_m_shell_sort_odd_even_merge/placement.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+int numaNodeOfCpu(int cpu) {
+#ifdef HAVE_LIBNUMA
+    if (numa_available() >= 0) {
+        int node = numa_node_of_cpu(cpu);
+        return node < 0 ? 0 : node;
+    }
+#endif
+    (void)cpu;
+    return 0;
+}
+
+std::vector<int> placementCpus(Placement policy) {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    if (policy == Placement::None) {
+        return cpus;
+    }
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return cpus;
+    }
+    // allowed CPUs grouped by node, in CPU order inside a node
+    std::map<int, std::vector<int>> byNode;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            byNode[numaNodeOfCpu(cpu)].push_back(cpu);
+        }
+    }
+    if (policy == Placement::Compact) {
+        for (const auto& node : byNode) {
+            cpus.insert(cpus.end(), node.second.begin(), node.second.end());
+        }
+    } else {
+        for (size_t i = 0; ; i++) {
+            bool any = false;
+            for (const auto& node : byNode) {
+                if (i < node.second.size()) {
+                    cpus.push_back(node.second[i]);
+                    any = true;
+                }
+            }
+            if (!any) {
+                break;
+            }
+        }
+    }
+#else
+    (void)policy;
+#endif
+    return cpus;
+}
+
+bool pinThisThread(int cpu) {
+    if (cpu < 0) {
+        return false;
+    }
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
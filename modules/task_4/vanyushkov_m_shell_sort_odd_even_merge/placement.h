@@ -0,0 +1,24 @@
+// Copyright 2022 Vanyushkov Maxim
+#ifndef MODULES_TASK_4_VANYUSHKOV_M_SHELL_SORT_ODD_EVEN_MERGE_PLACEMENT_H_
+#define MODULES_TASK_4_VANYUSHKOV_M_SHELL_SORT_ODD_EVEN_MERGE_PLACEMENT_H_
+
+#include <vector>
+
+// Where worker threads run. None leaves it to the OS; Compact fills the
+// cores of one NUMA node before moving to the next (neighbouring ranks
+// share caches and memory); Scatter deals ranks out round-robin over the
+// nodes (more memory bandwidth for few threads)
+enum class Placement { None, Compact, Scatter };
+
+// CPUs for ranks 0, 1, ... in policy order, rank r runs on
+// cpus[r % cpus.size()]. Empty for None or where pinning is unsupported
+std::vector<int> placementCpus(Placement policy);
+
+// NUMA node of cpu, 0 without libnuma
+int numaNodeOfCpu(int cpu);
+
+// Binds the calling thread to cpu (pthread_setaffinity_np), false if
+// that is not possible here. cpu < 0 is a no-op
+bool pinThisThread(int cpu);
+
+#endif  // MODULES_TASK_4_VANYUSHKOV_M_SHELL_SORT_ODD_EVEN_MERGE_PLACEMENT_H_
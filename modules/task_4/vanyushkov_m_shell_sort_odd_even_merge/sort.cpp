@@ -1,5 +1,6 @@
 // Copyright 2022 Vanyushkov Maxim
 #include "../../../modules/task_4/vanyushkov_m_shell_sort_odd_even_merge/sort.h"
+#include <algorithm>
 #include <random>
 // #include "../../../3rdparty/unapproved/unapproved.h"
 
@@ -51,28 +52,49 @@ std::vector<int> merge(const std::vector<int>& vec_1,
     return vec_res;
 }
 
-void ShellSortParallel(std::vector<int>* vec) {
-    unsigned PROC_SIZE = 4;
-    unsigned delta = vec->size() / PROC_SIZE;
+void ShellSortParallel(std::vector<int>* vec, Placement placement,
+                       unsigned threads) {
+    unsigned PROC_SIZE = std::max(1u, threads);
+    vec_size_t delta = vec->size() / PROC_SIZE;
+    std::vector<int> cpus = placementCpus(placement);
+    auto cpuOf = [&cpus](unsigned rank) {
+        return cpus.empty() ? -1 : cpus[rank % cpus.size()];
+    };
+
     std::vector<std::vector<int>> proc_res(PROC_SIZE);
-    std::thread* t = new std::thread[PROC_SIZE];
+    std::vector<std::thread> t;
     for (unsigned rank = 0; rank < PROC_SIZE; rank++) {
+        auto begin = vec->begin() + rank * delta;
         auto end = vec->begin() + (rank + 1) * delta;
         if (PROC_SIZE - 1 == rank) {
             end = vec->end();
         }
-        proc_res[rank] = { vec->begin() + rank * delta, end };
-        t[rank] = std::thread(ShellSortSequantial, &proc_res[rank]);
+        t.emplace_back([&proc_res, &cpuOf, rank, begin, end] {
+            pinThisThread(cpuOf(rank));
+            proc_res[rank].assign(begin, end);
+            ShellSortSequantial(&proc_res[rank]);
+        });
     }
-    for (unsigned rank = 0; rank < PROC_SIZE; rank++) {
-        // if (t[rank].joinable()) t[rank].join();
-        t[rank].join();
+    for (auto& th : t) {
+        th.join();
     }
-    *vec = proc_res[0];
-    for (vec_size_t i = 1; i < proc_res.size(); i++) {
-        *vec = merge(*vec, proc_res[i]);
+
+    for (unsigned step = 1; step < PROC_SIZE; step <<= 1) {
+        t.clear();
+        for (unsigned rank = 0; rank + step < PROC_SIZE; rank += 2 * step) {
+            t.emplace_back([&proc_res, &cpuOf, rank, step] {
+                pinThisThread(cpuOf(rank));
+                std::vector<int> res = merge(proc_res[rank],
+                                             proc_res[rank + step]);
+                proc_res[rank].swap(res);
+                std::vector<int>().swap(proc_res[rank + step]);
+            });
+        }
+        for (auto& th : t) {
+            th.join();
+        }
     }
-    delete[] t;
+    vec->swap(proc_res[0]);
 }
 
 bool checkSort(const std::vector<int>& vec) {
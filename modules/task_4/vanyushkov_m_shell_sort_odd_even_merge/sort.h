@@ -6,10 +6,17 @@
 #include <vector>
 #include <chrono>  // NOLINT [build/c++11]
 #include <thread>  // NOLINT [build/c++11]
+#include "./placement.h"
 
 std::vector<int> getRandomVector(int size);
 void ShellSortSequantial(std::vector<int>* vec);
-void ShellSortParallel(std::vector<int>* vec);
+// Every thread copies its own chunk (first touch puts the pages on its
+// NUMA node) and sorts it, then the chunks are merged pairwise; the merge
+// of ranks i and i + step runs on the CPU of rank i into a vector it
+// allocates itself, so the result of each round stays node-local
+void ShellSortParallel(std::vector<int>* vec,
+                       Placement placement = Placement::None,
+                       unsigned threads = 4);
 bool checkSort(const std::vector<int>& vec);
 
 #endif  // MODULES_TASK_4_VANYUSHKOV_M_SHELL_SORT_ODD_EVEN_MERGE_SORT_H_
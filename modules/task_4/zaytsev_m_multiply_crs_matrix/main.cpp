@@ -1,6 +1,7 @@
 // Copyright 2022 Zaytsev Mikhail
 #include <gtest/gtest.h>
 #include <complex>
+#include <map>
 #include <random>
 #include <vector>
 
@@ -27,6 +28,44 @@ getRandomVector(const size_t rows, const size_t cols) {
   return result;
 }
 
+// about nonZerosPerRow entries per row, integer parts so that sums are
+// exact in any order
+std::vector<std::vector<std::pair<size_t, std::complex<double>>>>
+getSparseVector(const size_t rows, const size_t cols,
+                const size_t nonZerosPerRow) {
+  std::vector<std::vector<std::pair<size_t, std::complex<double>>>> result(
+      rows);
+  std::mt19937 gen(rows + cols);
+  for (size_t i = 0; i < rows; ++i) {
+    std::map<size_t, std::complex<double>> row;
+    for (size_t k = 0; k < nonZerosPerRow; ++k)
+      row[gen() % cols] =
+          std::complex<double>(gen() % 19 + 1.0, gen() % 19 - 9.0);
+    result[i].assign(row.begin(), row.end());
+  }
+  return result;
+}
+
+// row by row reference product on the input vectors
+std::vector<std::vector<std::pair<size_t, std::complex<double>>>>
+referenceProduct(
+    const std::vector<std::vector<std::pair<size_t, std::complex<double>>>>&
+        first,
+    const std::vector<std::vector<std::pair<size_t, std::complex<double>>>>&
+        second) {
+  std::vector<std::vector<std::pair<size_t, std::complex<double>>>> result(
+      first.size());
+  for (size_t i = 0; i < first.size(); ++i) {
+    std::map<size_t, std::complex<double>> row;
+    for (auto& a : first[i])
+      for (auto& b : second[a.first]) row[b.first] += a.second * b.second;
+    for (auto& elem : row)
+      if (elem.second != std::complex<double>(0.0, 0.0))
+        result[i].push_back(elem);
+  }
+  return result;
+}
+
 TEST(ParallelMultiply, Matrix6x6) {
   size_t numberOfRows = 6;
   size_t numberOfColumns = 6;
@@ -112,6 +151,60 @@ TEST(ParallelMultiply, Matrix10x10) {
   ASSERT_EQ(isEq, true);
 }
 
+TEST(ParallelMultiply, Sparse3000x3000Dense) {
+  const size_t n = 3000;
+  auto first = getSparseVector(n, n, 20);
+  auto second = getSparseVector(n + 1, n, 20);
+  second.pop_back();
+
+  MatrixCRS expected(n, n, referenceProduct(first, second));
+  auto parallelMatrix =
+      getParallelMult(MatrixCRS(n, n, first), MatrixCRS(n, n, second));
+
+  ASSERT_TRUE(expected == parallelMatrix);
+}
+
+TEST(ParallelMultiply, Sparse2000x200000Hash) {
+  const size_t rows = 2000, inner = 5000, cols = 200000;
+  auto first = getSparseVector(rows, inner, 20);
+  auto second = getSparseVector(inner, cols, 20);
+
+  MatrixCRS expected(rows, cols, referenceProduct(first, second));
+  auto parallelMatrix = getParallelMult(MatrixCRS(rows, inner, first),
+                                        MatrixCRS(inner, cols, second));
+
+  ASSERT_TRUE(expected == parallelMatrix);
+}
+
+TEST(ParallelMultiply, CancelledEntriesAreDropped) {
+  // row 0 of the product is (1 - 1, 2), row 1 is (0, 0), row 2 is (3, 6)
+  MatrixCRS first(3, 2, {{{0, 1.0}, {1, 1.0}}, {}, {{0, 3.0}}});
+  MatrixCRS second(2, 2, {{{0, 1.0}, {1, 2.0}}, {{0, -1.0}}});
+  MatrixCRS expected(3, 2, {{{1, 2.0}}, {}, {{0, 3.0}, {1, 6.0}}});
+
+  auto parallelMatrix = getParallelMult(first, second);
+  auto sequentialMatrix = first * second;
+
+  ASSERT_TRUE(expected == parallelMatrix);
+  ASSERT_TRUE(sequentialMatrix == parallelMatrix);
+}
+
+TEST(ParallelMultiply, TransponseMatchesRows) {
+  const size_t rows = 300, cols = 500;
+  auto pairs = getSparseVector(rows, cols, 10);
+  MatrixCRS matrix(rows, cols, pairs);
+  matrix.transponse();
+
+  std::vector<std::vector<std::pair<size_t, std::complex<double>>>> expected(
+      cols);
+  for (size_t i = 0; i < rows; ++i)
+    for (auto& elem : pairs[i]) expected[elem.first].push_back({i, elem.second});
+
+  ASSERT_TRUE(MatrixCRS(cols, rows, expected) == matrix);
+  matrix.transponse();
+  ASSERT_TRUE(MatrixCRS(rows, cols, pairs) == matrix);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
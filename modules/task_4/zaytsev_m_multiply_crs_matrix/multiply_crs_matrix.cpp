@@ -1,9 +1,13 @@
 // Copyright 2022 Zaytsev Mikhail
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
+#include "../../../3rdparty/unapproved/parallel_scan.h"
+#include "../../../3rdparty/unapproved/parallel_transpose.h"
 #include "../../../3rdparty/unapproved/unapproved.h"
 #include "../../../modules/task_4/zaytsev_m_multiply_crs_matrix/multiply_crs_matrix.h"
 
@@ -68,31 +72,20 @@ vector<pair<size_t, complex<double>>> MatrixCRS::getRow(
   return result;
 }
 void MatrixCRS::transponse() {
-  vector<vector<pair<size_t, complex<double>>>> intermediateResult(
-      m_numberOfColumns);
-
-  for (size_t i = 0; i < m_accumulateNonZeros.size() - 1; ++i) {
-    for (size_t el = m_accumulateNonZeros[i]; el < m_accumulateNonZeros[i + 1];
-         ++el) {
-      intermediateResult[m_columnsOfValues[el]].push_back({i, m_values[el]});
-    }
-  }
+  // rows are counted by the pointers, a matrix still being filled has fewer
+  vector<size_t> accumulateNonZeros(m_numberOfColumns + 1);
+  vector<size_t> columnsOfValues(m_values.size());
+  vector<complex<double>> values(m_values.size());
+  ptranspose::transpose_std(m_accumulateNonZeros.size() - 1, m_numberOfColumns,
+                            m_accumulateNonZeros.data(),
+                            m_columnsOfValues.data(), m_values.data(),
+                            accumulateNonZeros.data(), columnsOfValues.data(),
+                            values.data());
 
   std::swap(m_numberOfRows, m_numberOfColumns);
-  m_accumulateNonZeros.clear();
-  m_columnsOfValues.clear();
-  m_values.clear();
-
-  m_accumulateNonZeros.push_back(0);
-
-  for (auto& vec : intermediateResult) {
-    m_accumulateNonZeros.push_back(
-        m_accumulateNonZeros[m_accumulateNonZeros.size() - 1] + vec.size());
-    for (auto& elem : vec) {
-      m_columnsOfValues.push_back(elem.first);
-      m_values.push_back(elem.second);
-    }
-  }
+  m_accumulateNonZeros.swap(accumulateNonZeros);
+  m_columnsOfValues.swap(columnsOfValues);
+  m_values.swap(values);
 }
 
 complex<double> multiplicationUnit(
@@ -162,60 +155,267 @@ bool MatrixCRS::operator==(const MatrixCRS& otherMatrix) {
   return true;
 }
 
-MatrixCRS getParallelMult(const MatrixCRS& first, const MatrixCRS& second) {
-  assert(first.m_numberOfColumns == second.m_numberOfRows);
+namespace {
+// rows with fewer columns than this get a dense accumulator per thread
+const size_t kDenseColumns = 1 << 16;
+const size_t kEmptySlot = static_cast<size_t>(-1);
+
+struct CRSView {
+  const size_t* rowStart;
+  const size_t* columns;
+  const complex<double>* values;
+};
+
+// Accumulator for one output row indexed directly by column
+class DenseAccumulator {
+  vector<complex<double>> m_sum;
+  vector<char> m_used;
+  vector<size_t> m_columns;
+
+ public:
+  explicit DenseAccumulator(const size_t numberOfColumns)
+      : m_sum(numberOfColumns), m_used(numberOfColumns, 0), m_columns() {}
+
+  void prepare(const size_t) {}
+  void mark(const size_t column) {
+    if (!m_used[column]) {
+      m_used[column] = 1;
+      m_columns.push_back(column);
+    }
+  }
+  void add(const size_t column, const complex<double>& value) {
+    mark(column);
+    m_sum[column] += value;
+  }
+  size_t size() const { return m_columns.size(); }
+  void clear() {
+    for (size_t column : m_columns) {
+      m_used[column] = 0;
+      m_sum[column] = 0;
+    }
+    m_columns.clear();
+  }
+  // writes the nonzero sums in column order, returns their number
+  size_t flush(size_t* columns, complex<double>* values) {
+    std::sort(m_columns.begin(), m_columns.end());
+    size_t count = 0;
+    for (size_t column : m_columns) {
+      if (m_sum[column] != complex<double>(0.0, 0.0)) {
+        columns[count] = column;
+        values[count++] = m_sum[column];
+      }
+    }
+    clear();
+    return count;
+  }
+};
+
+// Open addressing hash table with at least twice as many slots as the
+// row has products, for matrices too wide for a dense accumulator
+class HashAccumulator {
+  vector<size_t> m_keys;
+  vector<complex<double>> m_sum;
+  vector<size_t> m_slots;
+  size_t m_mask;
+
+  size_t find(const size_t column) {
+    size_t slot = static_cast<size_t>(
+                      static_cast<uint64_t>(column) * 0x9E3779B97F4A7C15ull >>
+                      32) & m_mask;
+    while (m_keys[slot] != kEmptySlot && m_keys[slot] != column)
+      slot = (slot + 1) & m_mask;
+    if (m_keys[slot] == kEmptySlot) {
+      m_keys[slot] = column;
+      m_slots.push_back(slot);
+    }
+    return slot;
+  }
 
-  MatrixCRS result(first.m_numberOfRows, second.m_numberOfColumns);
-  MatrixCRS transponseSecond = second;
-  transponseSecond.transponse();
+ public:
+  HashAccumulator() : m_keys(), m_sum(), m_slots(), m_mask(0) {}
+
+  void prepare(const size_t rowProducts) {
+    size_t capacity = 16;
+    while (capacity < 2 * rowProducts) capacity *= 2;
+    if (m_keys.size() < capacity) {
+      m_keys.assign(capacity, kEmptySlot);
+      m_sum.assign(capacity, complex<double>(0.0, 0.0));
+    }
+    m_mask = capacity - 1;
+  }
+  void mark(const size_t column) { find(column); }
+  void add(const size_t column, const complex<double>& value) {
+    m_sum[find(column)] += value;
+  }
+  size_t size() const { return m_slots.size(); }
+  void clear() {
+    for (size_t slot : m_slots) {
+      m_keys[slot] = kEmptySlot;
+      m_sum[slot] = 0;
+    }
+    m_slots.clear();
+  }
+  // the columns are sorted on their own, plain keys sort much faster
+  // than slots compared through the table
+  size_t flush(size_t* columns, complex<double>* values) {
+    const size_t size = m_slots.size();
+    for (size_t i = 0; i < size; ++i) columns[i] = m_keys[m_slots[i]];
+    std::sort(columns, columns + size);
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i) {
+      const complex<double> sum = m_sum[find(columns[i])];
+      if (sum != complex<double>(0.0, 0.0)) {
+        columns[count] = columns[i];
+        values[count++] = sum;
+      }
+    }
+    clear();
+    return count;
+  }
+};
+
+template <class Function>
+void forEachThread(const size_t numberOfThread, Function function) {
+  vector<std::future<void>> futures;
+  for (size_t thread = 0; thread < numberOfThread; ++thread)
+    futures.push_back(std::async(std::launch::async, function, thread));
+  for (auto& future : futures) future.get();
+}
 
-  int numberOfThread = std::thread::hardware_concurrency();
-  int dataPortion = first.m_numberOfRows / numberOfThread;
+size_t rowProducts(const CRSView& a, const CRSView& b, const size_t row) {
+  size_t products = 0;
+  for (size_t k = a.rowStart[row]; k < a.rowStart[row + 1]; ++k)
+    products += b.rowStart[a.columns[k] + 1] - b.rowStart[a.columns[k]];
+  return products;
+}
 
-  vector<std::pair<size_t, size_t>> vectorOfRange(numberOfThread);
-  std::future<void>* futures = new std::future<void>[numberOfThread];
+// Symbolic phase: the number of distinct columns in every row of a * b
+template <class Accumulator>
+void countRow(const CRSView& a, const CRSView& b, const size_t row,
+              Accumulator* accumulator, size_t* rowNonZeros) {
+  accumulator->prepare(rowProducts(a, b, row));
+  for (size_t k = a.rowStart[row]; k < a.rowStart[row + 1]; ++k)
+    for (size_t j = b.rowStart[a.columns[k]]; j < b.rowStart[a.columns[k] + 1];
+         ++j)
+      accumulator->mark(b.columns[j]);
+  rowNonZeros[row] = accumulator->size();
+  accumulator->clear();
+}
 
-  vector<vector<pair<size_t, complex<double>>>> intermediateResult(
-      first.m_numberOfRows);
+// Numeric phase: row of a * b written to columns/values, returns the
+// number of entries that did not cancel to zero
+template <class Accumulator>
+size_t multiplyRow(const CRSView& a, const CRSView& b, const size_t row,
+                   Accumulator* accumulator, size_t* columns,
+                   complex<double>* values) {
+  accumulator->prepare(rowProducts(a, b, row));
+  for (size_t k = a.rowStart[row]; k < a.rowStart[row + 1]; ++k) {
+    const complex<double> factor = a.values[k];
+    for (size_t j = b.rowStart[a.columns[k]]; j < b.rowStart[a.columns[k] + 1];
+         ++j)
+      accumulator->add(b.columns[j], factor * b.values[j]);
+  }
+  return accumulator->flush(columns, values);
+}
 
-  for (int i = 0; i < numberOfThread; ++i) {
-    if (i != numberOfThread - 1) {
-      vectorOfRange[i] = {i * dataPortion, (i + 1) * dataPortion};
-    } else {
-      vectorOfRange[i] = {i * dataPortion, first.m_numberOfRows};
+template <class Accumulator>
+void gustavson(const CRSView& a, const CRSView& b, const size_t numberOfRows,
+               const vector<size_t>& rowBounds, Accumulator prototype,
+               vector<size_t>* rowStart, vector<size_t>* columns,
+               vector<complex<double>>* values) {
+  const size_t numberOfThread = rowBounds.size() - 1;
+  vector<size_t> rowNonZeros(numberOfRows + 1, 0);
+  forEachThread(numberOfThread, [&](const size_t thread) {
+    Accumulator accumulator(prototype);
+    for (size_t i = rowBounds[thread]; i < rowBounds[thread + 1]; ++i)
+      countRow(a, b, i, &accumulator, rowNonZeros.data());
+  });
+
+  rowStart->resize(numberOfRows + 1);
+  size_t nonZeros = pscan::exclusive_scan_std(
+      rowNonZeros.data(), rowStart->data(), numberOfRows + 1);
+  columns->resize(nonZeros);
+  values->resize(nonZeros);
+
+  // rowNonZeros now receives the entries left after cancellation
+  std::atomic<bool> cancelled(false);
+  forEachThread(numberOfThread, [&](const size_t thread) {
+    Accumulator accumulator(prototype);
+    for (size_t i = rowBounds[thread]; i < rowBounds[thread + 1]; ++i) {
+      size_t at = (*rowStart)[i];
+      rowNonZeros[i] = multiplyRow(a, b, i, &accumulator,
+                                   columns->data() + at, values->data() + at);
+      if (rowNonZeros[i] != (*rowStart)[i + 1] - at) cancelled = true;
     }
-
-    futures[i] = std::async(
-        std::launch::async,
-        [&](const int currentThread) {
-          for (size_t i = vectorOfRange[currentThread].first;
-               i < vectorOfRange[currentThread].second; ++i) {
-            auto currentRow = first.getRow(i);
-            for (size_t j = 0; j < transponseSecond.m_numberOfRows; ++j) {
-              auto currentCol = transponseSecond.getRow(j);
-              auto res = multiplicationUnit(currentRow, currentCol);
-              if (res != complex<double>(0.0, 0.0)) {
-                intermediateResult[i].push_back({j, res});
-              }
-            }
-          }
-        },
-        i);
-  }
-
-  for (int i = 0; i < numberOfThread; ++i)
-    futures[i].get();
-
-  for (auto& vec : intermediateResult) {
-    result.m_accumulateNonZeros.push_back(
-        result.m_accumulateNonZeros[result.m_accumulateNonZeros.size() - 1] +
-        vec.size());
-    for (auto& elem : vec) {
-      result.m_columnsOfValues.push_back(elem.first);
-      result.m_values.push_back(elem.second);
+  });
+  if (!cancelled) return;
+
+  // some sums were exactly zero: close the gaps they left
+  vector<size_t> compactStart(numberOfRows + 1);
+  nonZeros = pscan::exclusive_scan_std(rowNonZeros.data(),
+                                       compactStart.data(), numberOfRows + 1);
+  vector<size_t> compactColumns(nonZeros);
+  vector<complex<double>> compactValues(nonZeros);
+  forEachThread(numberOfThread, [&](const size_t thread) {
+    for (size_t i = rowBounds[thread]; i < rowBounds[thread + 1]; ++i) {
+      std::copy_n(columns->begin() + (*rowStart)[i], rowNonZeros[i],
+                  compactColumns.begin() + compactStart[i]);
+      std::copy_n(values->begin() + (*rowStart)[i], rowNonZeros[i],
+                  compactValues.begin() + compactStart[i]);
     }
-  }
+  });
+  rowStart->swap(compactStart);
+  columns->swap(compactColumns);
+  values->swap(compactValues);
+}
+}  // namespace
+
+// Gustavson's row-by-row product: row i of the result is the sum of the
+// rows of second picked by the nonzeros of row i of first, so the work is
+// proportional to the number of products, not to rows * columns. Rows are
+// split between threads by their product counts; a symbolic pass counts
+// the nonzeros of every row, a prefix sum turns them into row starts and
+// the numeric pass writes every row straight to its place
+MatrixCRS getParallelMult(const MatrixCRS& first, const MatrixCRS& second) {
+  assert(first.m_numberOfColumns == second.m_numberOfRows);
+
+  MatrixCRS result(first.m_numberOfRows, second.m_numberOfColumns);
+  const size_t numberOfRows = first.m_numberOfRows;
+  const CRSView a = {first.m_accumulateNonZeros.data(),
+                     first.m_columnsOfValues.data(), first.m_values.data()};
+  const CRSView b = {second.m_accumulateNonZeros.data(),
+                     second.m_columnsOfValues.data(), second.m_values.data()};
+
+  size_t numberOfThread = std::max(1u, std::thread::hardware_concurrency());
+  numberOfThread = std::max<size_t>(1, std::min(numberOfThread, numberOfRows));
+
+  // rows are cut where the running product count crosses thread * total /
+  // numberOfThread
+  vector<size_t> products(numberOfRows + 1, 0);
+  forEachThread(numberOfThread, [&](const size_t thread) {
+    for (size_t i = numberOfRows * thread / numberOfThread;
+         i < numberOfRows * (thread + 1) / numberOfThread; ++i)
+      products[i] = rowProducts(a, b, i);
+  });
+  const size_t total = pscan::exclusive_scan_std(
+      products.data(), products.data(), numberOfRows + 1);
+  vector<size_t> rowBounds(numberOfThread + 1, numberOfRows);
+  rowBounds[0] = 0;
+  for (size_t thread = 1; thread < numberOfThread; ++thread)
+    rowBounds[thread] =
+        std::lower_bound(products.begin(), products.end() - 1,
+                         total / numberOfThread * thread) -
+        products.begin();
+
+  if (second.m_numberOfColumns <= kDenseColumns)
+    gustavson(a, b, numberOfRows, rowBounds,
+              DenseAccumulator(second.m_numberOfColumns),
+              &result.m_accumulateNonZeros, &result.m_columnsOfValues,
+              &result.m_values);
+  else
+    gustavson(a, b, numberOfRows, rowBounds, HashAccumulator(),
+              &result.m_accumulateNonZeros, &result.m_columnsOfValues,
+              &result.m_values);
 
-  delete[] futures;
   return result;
 }
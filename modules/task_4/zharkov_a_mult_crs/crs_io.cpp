@@ -0,0 +1,134 @@
+// Copyright 2022 Zharkov Andrey
+#include "../../../modules/task_4/zharkov_a_mult_crs/crs_io.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+const char kMagic[8] = {'C', 'R', 'S', 'C', 'P', 'X', '0', '1'};
+
+struct BinaryHeader {
+  char magic[8];
+  uint64_t row, col, nonZeros;
+  uint64_t rowOffset, colOffset, valOffset;
+  uint64_t reserved;
+};
+
+static_assert(sizeof(BinaryHeader) == 64, "the header takes 64 bytes");
+static_assert(sizeof(size_t) == sizeof(uint64_t),
+              "the arrays are mapped as size_t, which must have 64 bits");
+static_assert(sizeof(cpx) == 2 * sizeof(double), "cpx is two doubles");
+
+uint64_t align64(uint64_t offset) { return (offset + 63) / 64 * 64; }
+}  // namespace
+
+CRS_Matrix readMatrixMarket(const std::string& path, unsigned threads) {
+  mmarket::FileMap file(path);
+  const mmarket::Header header = mmarket::read_header(file, path);
+  mmarket::Csr<size_t, cpx> csr = mmarket::read_entries<size_t, cpx>(
+      file, header, threads, [](mmarket::Cursor& in, mmarket::Field f) {
+        cpx value(1, 0);
+        if (f != mmarket::Field::Pattern) value.real(in.number());
+        if (f == mmarket::Field::Complex) value.imag(in.number());
+        return value;
+      });
+  return CRS_Matrix(std::move(csr.val), std::move(csr.col_index),
+                    std::move(csr.row_index), csr.cols, csr.rows);
+}
+
+void writeMatrixMarket(const CRS_Matrix& mat, const std::string& path) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out) throw std::runtime_error("Cannot create " + path);
+  out << "%%MatrixMarket matrix coordinate complex general\n"
+      << mat.row << ' ' << mat.col << ' ' << mat.val.size() << '\n';
+  char line[128];
+  for (size_t i = 0; i < mat.row; ++i) {
+    for (size_t k = mat.rowIndex[i]; k < mat.rowIndex[i + 1]; ++k) {
+      int n = std::snprintf(line, sizeof(line), "%zu %zu %.17g %.17g\n",
+                            i + 1, mat.colIndex[k] + 1, mat.val[k].real(),
+                            mat.val[k].imag());
+      out.write(line, n);
+    }
+  }
+  if (!out) throw std::runtime_error("Cannot write " + path);
+}
+
+void writeBinaryCRS(const CRS_Matrix& mat, const std::string& path) {
+  if (mat.rowIndex.size() != mat.row + 1)
+    throw std::runtime_error("Row index does not match the row count");
+  BinaryHeader header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.row = mat.row;
+  header.col = mat.col;
+  header.nonZeros = mat.val.size();
+  header.rowOffset = align64(sizeof(header));
+  header.colOffset = align64(header.rowOffset + 8 * (header.row + 1));
+  header.valOffset = align64(header.colOffset + 8 * header.nonZeros);
+
+  std::ofstream out(path, std::ios::binary);
+  if (!out) throw std::runtime_error("Cannot create " + path);
+  auto put = [&out](uint64_t offset, const void* data, size_t bytes) {
+    static const char zeros[64] = {};
+    out.write(zeros, offset - static_cast<uint64_t>(out.tellp()));
+    out.write(static_cast<const char*>(data), bytes);
+  };
+  put(0, &header, sizeof(header));
+  put(header.rowOffset, mat.rowIndex.data(), 8 * (header.row + 1));
+  put(header.colOffset, mat.colIndex.data(), 8 * header.nonZeros);
+  put(header.valOffset, mat.val.data(), sizeof(cpx) * header.nonZeros);
+  if (!out) throw std::runtime_error("Cannot write " + path);
+}
+
+MappedCRS::MappedCRS(const std::string& path) : file_(path) {
+  BinaryHeader header;
+  if (file_.size() < sizeof(header))
+    throw std::runtime_error(path + " is not a binary CRS file");
+  std::memcpy(&header, file_.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+    throw std::runtime_error(path + " is not a binary CRS file");
+  const uint64_t size = file_.size();
+  if (header.row >= size / 8 || header.nonZeros > size / sizeof(cpx) ||
+      header.rowOffset % 8 || header.colOffset % 8 || header.valOffset % 8 ||
+      header.rowOffset + 8 * (header.row + 1) > size ||
+      header.colOffset + 8 * header.nonZeros > size ||
+      header.valOffset + sizeof(cpx) * header.nonZeros > size)
+    throw std::runtime_error(path + " is truncated");
+  row_ = header.row;
+  col_ = header.col;
+  nonZeros_ = header.nonZeros;
+  rowIndex_ = reinterpret_cast<const size_t*>(file_.data() + header.rowOffset);
+  colIndex_ = reinterpret_cast<const size_t*>(file_.data() + header.colOffset);
+  val_ = reinterpret_cast<const cpx*>(file_.data() + header.valOffset);
+  if (rowIndex_[row_] != nonZeros_)
+    throw std::runtime_error(path + " has a broken row index");
+}
+
+CRS_Matrix MappedCRS::toMatrix() const {
+  return CRS_Matrix(std::vector<cpx>(val_, val_ + nonZeros_),
+                    std::vector<size_t>(colIndex_, colIndex_ + nonZeros_),
+                    std::vector<size_t>(rowIndex_, rowIndex_ + row_ + 1),
+                    col_, row_);
+}
+
+std::vector<cpx> MappedCRS::multiply(const std::vector<cpx>& x,
+                                     unsigned threads) const {
+  if (x.size() != col_) throw std::runtime_error("Different numbers of cols");
+  std::vector<cpx> y(row_);
+  const unsigned threadNum = mmarket::thread_count(threads);
+  std::vector<size_t> first = mmarket::split_rows(rowIndex_, row_, threadNum);
+  mmarket::run_threads(threadNum, [&](unsigned t) {
+    for (size_t i = first[t]; i < first[t + 1]; ++i) {
+      cpx sum = 0;
+      for (size_t k = rowIndex_[i]; k < rowIndex_[i + 1]; ++k)
+        sum += val_[k] * x[colIndex_[k]];
+      y[i] = sum;
+    }
+  });
+  return y;
+}
@@ -0,0 +1,55 @@
+// Copyright 2022 Zharkov Andrey
+#ifndef MODULES_TASK_4_ZHARKOV_A_MULT_CRS_CRS_IO_H_
+#define MODULES_TASK_4_ZHARKOV_A_MULT_CRS_CRS_IO_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../../../3rdparty/unapproved/matrix_market.h"
+#include "../../../modules/task_4/zharkov_a_mult_crs/zharkov_a_mult_crs.h"
+
+// Reads a Matrix Market coordinate file (real, integer, complex or
+// pattern; general, symmetric, skew-symmetric or hermitian) without
+// building a dense matrix, with the parallel reader of
+// 3rdparty/unapproved/matrix_market.h (mmap, one piece of the file per
+// thread, a counting sort into rows). The mirrored half of a symmetric
+// file is added; duplicate entries are kept as they are.
+// threads == 0 means std::thread::hardware_concurrency()
+CRS_Matrix readMatrixMarket(const std::string& path, unsigned threads = 0);
+
+// "coordinate complex general", 1-based, one entry per line
+void writeMatrixMarket(const CRS_Matrix& mat, const std::string& path);
+
+// Binary CRS file in the byte order of the machine: a 64-byte header
+// (magic, rows, cols, nonzeros and the offsets of the three arrays), then
+// rowIndex (rows + 1 uint64), colIndex (nonzeros uint64) and the values
+// (nonzeros complex doubles), every array aligned to 64 bytes
+void writeBinaryCRS(const CRS_Matrix& mat, const std::string& path);
+
+// A binary CRS file mapped read-only: the arrays point into the mapping,
+// nothing is copied or parsed. Only the header and the file size are
+// checked, the arrays are trusted
+class MappedCRS {
+  mmarket::FileMap file_;
+  size_t row_, col_, nonZeros_;
+  const size_t* rowIndex_;
+  const size_t* colIndex_;
+  const cpx* val_;
+
+ public:
+  explicit MappedCRS(const std::string& path);
+  size_t getRow() const { return row_; }
+  size_t getCol() const { return col_; }
+  size_t getNonZeros() const { return nonZeros_; }
+  const size_t* rowIndex() const { return rowIndex_; }
+  const size_t* colIndex() const { return colIndex_; }
+  const cpx* val() const { return val_; }
+  // an owning copy
+  CRS_Matrix toMatrix() const;
+  // this * x, the rows split between threads (0: hardware_concurrency)
+  std::vector<cpx> multiply(const std::vector<cpx>& x,
+                            unsigned threads = 0) const;
+};
+
+#endif  // MODULES_TASK_4_ZHARKOV_A_MULT_CRS_CRS_IO_H_
@@ -1,10 +1,41 @@
 // Copyright 2022 Zharkov Andrey
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>  // NOLINT [build/c++11]
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
 #include <vector>
 
+#include "../../../3rdparty/unapproved/parallel_transpose.h"
+#include "./crs_io.h"
 #include "./zharkov_a_mult_crs.h"
 
+#define USE_EFFICIENCY_TESTS 0
+
+namespace {
+// rows of the speed tests: by default they only check the results; with
+// USE_EFFICIENCY_TESTS the Matrix Market file takes about 90 MB and the
+// transposed matrix has 10M nonzeros
+#if USE_EFFICIENCY_TESTS == 1
+const size_t kLoadRows = 100000, kTransposeRows = 500000;
+#else
+const size_t kLoadRows = 5000, kTransposeRows = 20000;
+#endif
+
+void writeText(const std::string& path, const std::string& text) {
+  std::ofstream(path, std::ios::binary) << text;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+}  // namespace
+
 TEST(Sparce_Matrix_Multiplication, Test_Matrix_Create) {
   CRS_Matrix matrix({
       {cpx(10, -0.2), cpx(20, 1), cpx(0, 0), cpx(0, 0), cpx(0, 0), cpx(0, 0)},
@@ -34,6 +65,47 @@ TEST(Sparce_Matrix_Multiplication, Test_Matrix_Transpose) {
   EXPECT_EQ(trans, resMatrix);
 }
 
+TEST(Sparce_Matrix_Multiplication, Test_Transpose_and_Dense) {
+  CRS_Matrix rand = getRandomCRSMatrix(130, 170, 0.05);
+  std::vector<std::vector<cpx>> dense = rand.getSparseMatrix();
+  std::vector<std::vector<cpx>> denseTrans(130, std::vector<cpx>(170));
+  for (size_t i = 0; i < 170; ++i)
+    for (size_t j = 0; j < 130; ++j) denseTrans[j][i] = dense[i][j];
+  CRS_Matrix trans = rand.transpose();
+  EXPECT_EQ(trans, CRS_Matrix(denseTrans));
+  EXPECT_EQ(trans.transpose(), rand);
+}
+
+TEST(Sparce_Matrix_Multiplication, Test_Transpose_Threads) {
+  // enough nonzeros for four ranges, some rows and columns left empty
+  const size_t rows = 3000, cols = 2500;
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<size_t> anyCol(0, cols / 2 - 1);
+  std::vector<cpx> val;
+  std::vector<size_t> colIndex, rowIndex(1, 0);
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t k = 0; i % 7 != 0 && k < 60; ++k) {
+      colIndex.push_back(2 * anyCol(gen));
+      val.push_back(cpx(static_cast<double>(i), static_cast<double>(k)));
+    }
+    rowIndex.push_back(colIndex.size());
+  }
+  std::vector<size_t> seqPtr(cols + 1), thrPtr(cols + 1);
+  std::vector<size_t> seqIdx(val.size()), thrIdx(val.size());
+  std::vector<cpx> seqVal(val.size()), thrVal(val.size());
+  ptranspose::transpose_seq(rows, cols, rowIndex.data(), colIndex.data(),
+                            val.data(), seqPtr.data(), seqIdx.data(),
+                            seqVal.data());
+  ptranspose::transpose_chunks(rows, cols, rowIndex.data(), colIndex.data(),
+                               val.data(), thrPtr.data(), thrIdx.data(),
+                               thrVal.data(), 4, pscan::for_each_std());
+  EXPECT_EQ(seqPtr, thrPtr);
+  EXPECT_EQ(seqIdx, thrIdx);
+  EXPECT_EQ(seqVal, thrVal);
+  EXPECT_TRUE(std::is_sorted(seqIdx.begin() + seqPtr[10],
+                             seqIdx.begin() + seqPtr[11]));
+}
+
 TEST(Sparce_Matrix_Multiplication, Test_Matrix_Multiplication) {
   CRS_Matrix matrix1({
       {cpx(0, 9), cpx(0, 0), cpx(0, 0), cpx(3, 9)},
@@ -93,3 +165,193 @@ TEST(Sparce_Matrix_Multiplication, Test_Big_Matrix) {
   std::cout << "Seq = " << seqTime << std::endl;
   std::cout << "Boost = " << seqTime / parallTime << std::endl;
 }
+TEST(Sparce_Matrix_Multiplication, Test_Gustavson_and_Naive) {
+  CRS_Matrix rand1 = getRandomCRSMatrix(37, 23, 0.2);
+  CRS_Matrix rand2 = getRandomCRSMatrix(41, 37, 0.2);
+  CRS_Matrix multNaive(
+      naiveMultiplication(rand1.getSparseMatrix(), rand2.getSparseMatrix()));
+  EXPECT_EQ(rand1.multiply(rand2), multNaive);
+}
+TEST(Sparce_Matrix_Multiplication, Test_Heavy_and_Light_Rows) {
+  // rows 0 and 1 of the product are full (dense accumulator), the rest
+  // have at most two products each (hash accumulator)
+  const size_t n = 300;
+  std::vector<std::vector<cpx>> mat1(n, std::vector<cpx>(n)),
+      mat2(n, std::vector<cpx>(n));
+  for (size_t j = 0; j < n; ++j) {
+    mat1[0][j] = cpx(1, static_cast<double>(j % 3));
+    mat1[1][j] = cpx(static_cast<double>(j % 5), -1);
+    mat2[j][j] = cpx(2, 1);
+    mat2[j][(j * 7) % n] += cpx(-1, 3);
+  }
+  for (size_t i = 2; i < n; ++i) mat1[i][(i * 11) % n] = cpx(3, -2);
+  CRS_Matrix multCRS = CRS_Matrix(mat1).multiply(CRS_Matrix(mat2));
+  EXPECT_EQ(multCRS, CRS_Matrix(naiveMultiplication(mat1, mat2)));
+}
+TEST(Sparce_Matrix_Multiplication, Test_Parallel_and_Seq_Equal) {
+  CRS_Matrix rand1 = getRandomCRSMatrix(150, 120, 0.05);
+  CRS_Matrix rand2 = getRandomCRSMatrix(150, 150, 0.05);
+  CRS_Matrix trans = rand2.transpose();
+  EXPECT_EQ(rand1.parallelMultiply(trans), rand1 * trans);
+}
+TEST(Sparce_Matrix_Multiplication, Test_Matrix_Market_Round_Trip) {
+  CRS_Matrix rand = getRandomCRSMatrix(70, 90, 0.1);
+  writeMatrixMarket(rand, "zharkov_round_trip.mtx");
+  EXPECT_EQ(readMatrixMarket("zharkov_round_trip.mtx", 1), rand);
+  EXPECT_EQ(readMatrixMarket("zharkov_round_trip.mtx", 4), rand);
+  std::remove("zharkov_round_trip.mtx");
+}
+TEST(Sparce_Matrix_Multiplication, Test_Matrix_Market_Symmetric_Fields) {
+  writeText("zharkov_symmetric.mtx",
+            "%%MatrixMarket matrix coordinate real symmetric\n"
+            "% lower triangle only\n"
+            "\n"
+            "3 3 4\n"
+            "1 1 2.5\n"
+            "3 1 -1e1\n"
+            "2 2 4\n"
+            "3 2 0.5\n");
+  writeText("zharkov_hermitian.mtx",
+            "%%MatrixMarket matrix coordinate complex hermitian\n"
+            "2 2 2\n"
+            "1 1 1 0\n"
+            "2 1 3 -4\n");
+  writeText("zharkov_pattern.mtx",
+            "%%MatrixMarket matrix coordinate pattern general\n"
+            "2 3 2\n"
+            "1 3\r\n"
+            "2 1\r\n");
+  std::vector<std::vector<cpx>> symmetric = {{2.5, 0, -10}, {0, 4, 0.5},
+                                             {-10, 0.5, 0}};
+  std::vector<std::vector<cpx>> hermitian = {{1, cpx(3, 4)},
+                                             {cpx(3, -4), 0}};
+  std::vector<std::vector<cpx>> pattern = {{0, 0, 1}, {1, 0, 0}};
+  EXPECT_EQ(readMatrixMarket("zharkov_symmetric.mtx", 3),
+            CRS_Matrix(symmetric));
+  EXPECT_EQ(readMatrixMarket("zharkov_hermitian.mtx"), CRS_Matrix(hermitian));
+  EXPECT_EQ(readMatrixMarket("zharkov_pattern.mtx", 2), CRS_Matrix(pattern));
+  std::remove("zharkov_symmetric.mtx");
+  std::remove("zharkov_hermitian.mtx");
+  std::remove("zharkov_pattern.mtx");
+}
+TEST(Sparce_Matrix_Multiplication, Test_Matrix_Market_Bad_Files) {
+  const std::string path = "zharkov_bad.mtx";
+  EXPECT_ANY_THROW(readMatrixMarket("zharkov_missing.mtx"));
+  writeText(path, "%%MatrixMarket matrix array real general\n1 1\n2\n");
+  EXPECT_ANY_THROW(readMatrixMarket(path));
+  writeText(path, "%%MatrixMarket matrix coordinate real general\n"
+                  "2 2 1\n3 1 1.0\n");
+  EXPECT_ANY_THROW(readMatrixMarket(path));
+  writeText(path, "%%MatrixMarket matrix coordinate real general\n"
+                  "2 2 2\n1 1 1.0\n");
+  EXPECT_ANY_THROW(readMatrixMarket(path));
+  writeText(path, "%%MatrixMarket matrix coordinate real general\n"
+                  "2 2 1\n1 1 x\n");
+  EXPECT_ANY_THROW(readMatrixMarket(path, 2));
+  writeText(path, "%%MatrixMarket matrix coordinate real symmetric\n"
+                  "3 2 1\n2 1 1.0\n");
+  EXPECT_ANY_THROW(readMatrixMarket(path));
+  std::remove(path.c_str());
+}
+TEST(Sparce_Matrix_Multiplication, Test_Binary_Mapped_View) {
+  CRS_Matrix rand = getRandomCRSMatrix(80, 60, 0.1);
+  writeBinaryCRS(rand, "zharkov_view.crs");
+  {
+    MappedCRS view("zharkov_view.crs");
+    ASSERT_EQ(view.getRow(), rand.getRow());
+    ASSERT_EQ(view.getNonZeros(), rand.getVal().size());
+    EXPECT_EQ(view.toMatrix(), rand);
+
+    std::vector<cpx> x(rand.getCol());
+    for (size_t j = 0; j < x.size(); ++j) x[j] = cpx(j % 7, -1.0);
+    std::vector<std::vector<cpx>> column(x.size(), std::vector<cpx>(1));
+    for (size_t j = 0; j < x.size(); ++j) column[j][0] = x[j];
+    std::vector<std::vector<cpx>> expected =
+        naiveMultiplication(rand.getSparseMatrix(), column);
+    std::vector<cpx> y = view.multiply(x, 3);
+    for (size_t i = 0; i < y.size(); ++i) EXPECT_EQ(expected[i][0], y[i]);
+  }
+  std::remove("zharkov_view.crs");
+
+  writeText("zharkov_view.crs", "not a binary CRS file");
+  EXPECT_ANY_THROW(MappedCRS("zharkov_view.crs"));
+  std::remove("zharkov_view.crs");
+}
+TEST(Sparce_Matrix_Multiplication, Test_Load_Speed) {
+  // 20 entries a row, about 45 bytes of Matrix Market text each
+  const size_t rows = kLoadRows, perRow = 20;
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<size_t> anyCol(0, rows - 1);
+  std::uniform_real_distribution<double> value(-1, 1);
+  std::vector<cpx> val;
+  std::vector<size_t> colIndex, rowIndex(1, 0);
+  for (size_t i = 0; i < rows; ++i) {
+    std::vector<size_t> cols;
+    while (cols.size() < perRow) {
+      cols.push_back(anyCol(gen));
+      std::sort(cols.begin(), cols.end());
+      cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    }
+    for (size_t c : cols) {
+      colIndex.push_back(c);
+      val.push_back(cpx(value(gen), value(gen)));
+    }
+    rowIndex.push_back(colIndex.size());
+  }
+  CRS_Matrix mat(std::move(val), std::move(colIndex), std::move(rowIndex),
+                 rows, rows);
+  writeMatrixMarket(mat, "zharkov_speed.mtx");
+  writeBinaryCRS(mat, "zharkov_speed.crs");
+
+  auto start = std::chrono::steady_clock::now();
+  CRS_Matrix parsed = readMatrixMarket("zharkov_speed.mtx");
+  double parseTime = secondsSince(start);
+  start = std::chrono::steady_clock::now();
+  MappedCRS view("zharkov_speed.crs");
+  double mapTime = secondsSince(start);
+  std::ifstream text("zharkov_speed.mtx", std::ios::ate | std::ios::binary);
+  double megabytes = static_cast<double>(text.tellg()) / 1e6;
+  std::cout << "Matrix Market: " << megabytes / parseTime << " MB/s, mmap: "
+            << mapTime << " s" << std::endl;
+
+  EXPECT_EQ(parsed, mat);
+  EXPECT_EQ(view.toMatrix(), mat);
+  std::remove("zharkov_speed.mtx");
+  std::remove("zharkov_speed.crs");
+}
+TEST(Sparce_Matrix_Multiplication, Test_Transpose_Speed) {
+  // 20 nonzeros a row, 24 bytes each
+  const size_t rows = kTransposeRows, perRow = 20;
+  std::mt19937 gen(9);
+  std::uniform_int_distribution<size_t> anyCol(0, rows - 1);
+  std::vector<cpx> val;
+  std::vector<size_t> colIndex, rowIndex(1, 0);
+  val.reserve(rows * perRow);
+  colIndex.reserve(rows * perRow);
+  for (size_t i = 0; i < rows; ++i) {
+    size_t first = colIndex.size();
+    for (size_t k = 0; k < perRow; ++k) {
+      colIndex.push_back(anyCol(gen));
+      val.push_back(cpx(static_cast<double>(k), 1));
+    }
+    std::sort(colIndex.begin() + first, colIndex.end());
+    rowIndex.push_back(colIndex.size());
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<size_t> seqPtr(rows + 1), seqIdx(val.size());
+  std::vector<cpx> seqVal(val.size());
+  ptranspose::transpose_seq(rows, rows, rowIndex.data(), colIndex.data(),
+                            val.data(), seqPtr.data(), seqIdx.data(),
+                            seqVal.data());
+  double seqTime = secondsSince(start);
+  CRS_Matrix mat(std::move(val), std::move(colIndex), std::move(rowIndex),
+                 rows, rows);
+  start = std::chrono::steady_clock::now();
+  CRS_Matrix trans = mat.transpose();
+  double parTime = secondsSince(start);
+  std::cout << "Seq = " << seqTime << " Parall = " << parTime
+            << " Boost = " << seqTime / parTime << std::endl;
+
+  EXPECT_EQ(trans, CRS_Matrix(std::move(seqVal), std::move(seqIdx),
+                              std::move(seqPtr), rows, rows));
+}
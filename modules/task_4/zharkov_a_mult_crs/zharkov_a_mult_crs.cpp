@@ -1,12 +1,15 @@
 // Copyright 2022 Zharkov Andrey
 
-#include <atomic>
+#include <algorithm>
 #include <random>
 #include <set>
 #include <stdexcept>
 #include <utility>
 #include <vector>
 
+#include "../../../3rdparty/unapproved/parallel_scan.h"
+#include "../../../3rdparty/unapproved/parallel_transpose.h"
+#include "../../../3rdparty/unapproved/row_accumulator.h"
 #include "../../../3rdparty/unapproved/unapproved.h"
 #include "../../../modules/task_4/zharkov_a_mult_crs/zharkov_a_mult_crs.h"
 
@@ -79,78 +82,109 @@ CRS_Matrix CRS_Matrix::operator*(const CRS_Matrix& mat) const& {
   return res;
 }
 
-CRS_Matrix CRS_Matrix::parallelMultiply(const CRS_Matrix& mat) const& {
+CRS_Matrix CRS_Matrix::multiply(const CRS_Matrix& mat) const& {
+  if (col != mat.row) throw std::runtime_error("Different numbers of cols");
+  const size_t rows = rowIndex.empty() ? 0 : rowIndex.size() - 1;
+
+  // values of the right matrix split into re/im so that the products of
+  // one of our values with a whole row of mat are computed by vector code
+  std::vector<double> matRe(mat.val.size()), matIm(mat.val.size());
+  for (size_t j = 0; j < mat.val.size(); ++j) {
+    matRe[j] = mat.val[j].real();
+    matIm[j] = mat.val[j].imag();
+  }
+
+  // rows are split between the threads by their product counts
+  std::vector<size_t> products(rows + 1, 0);
+  for (size_t i = 0; i < rows; ++i)
+    for (size_t k = rowIndex[i]; k < rowIndex[i + 1]; ++k)
+      products[i] += mat.rowIndex[colIndex[k] + 1] - mat.rowIndex[colIndex[k]];
+  std::vector<size_t> productStart(rows + 1);
+  const size_t total = pscan::exclusive_scan_std(
+      products.data(), productStart.data(), rows + 1);
+  size_t threadNum = std::max(1u, std::thread::hardware_concurrency());
+  threadNum = std::max<size_t>(1, std::min(threadNum, rows));
+  std::vector<size_t> firstRow(threadNum + 1, rows);
+  firstRow[0] = 0;
+  for (size_t t = 1; t < threadNum; ++t)
+    firstRow[t] = std::lower_bound(productStart.begin(),
+                                   productStart.end() - 1,
+                                   total / threadNum * t) -
+                  productStart.begin();
+
+  // every thread collects its rows in its own arrays, the row counts
+  // become rowIndex through a prefix sum and the arrays are copied out
+  std::vector<size_t> rowNonZeros(rows + 1, 0);
+  std::vector<std::vector<size_t>> threadCol(threadNum);
+  std::vector<std::vector<cpx>> threadVal(threadNum);
+  auto worker = [&](size_t t) {
+    rowacc::RowAccumulator<size_t, double> acc(mat.col);
+    std::vector<double> re, im;
+    for (size_t i = firstRow[t]; i < firstRow[t + 1]; ++i) {
+      acc.begin(products[i]);
+      for (size_t k = rowIndex[i]; k < rowIndex[i + 1]; ++k) {
+        const double ar = val[k].real(), ai = val[k].imag();
+        const size_t begin = mat.rowIndex[colIndex[k]];
+        const size_t n = mat.rowIndex[colIndex[k] + 1] - begin;
+        if (re.size() < n) {
+          re.resize(n);
+          im.resize(n);
+        }
+        const double* br = matRe.data() + begin;
+        const double* bi = matIm.data() + begin;
+        for (size_t j = 0; j < n; ++j) {
+          re[j] = ar * br[j] - ai * bi[j];
+          im[j] = ar * bi[j] + ai * br[j];
+        }
+        acc.add(mat.colIndex.data() + begin, re.data(), im.data(), n);
+      }
+      size_t before = threadCol[t].size();
+      acc.finish([&](size_t c, double re, double im) {
+        threadCol[t].push_back(c);
+        threadVal[t].push_back(cpx(re, im));
+      });
+      rowNonZeros[i] = threadCol[t].size() - before;
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < threadNum; ++t) threads.emplace_back(worker, t);
+  worker(0);
+  for (auto& thread : threads) thread.join();
+
   CRS_Matrix res;
-  res.rowIndex.push_back(0);
   res.row = row;
-  res.col = mat.row;
-  if (col != mat.col) throw std::runtime_error("Different numbers of cols");
-  std::atomic<size_t> NonZeroCounter(0);
-  int threadNum = std::thread::hardware_concurrency();
-  int blockSize = (mat.rowIndex.size() - 1) / (threadNum);
-  int remainder = (mat.rowIndex.size() - 1) % (threadNum);
-  std::vector<std::thread> threads(threadNum);
-  for (size_t i = 1; i < rowIndex.size(); ++i) {
-    std::vector<cpx> tmpVec(mat.rowIndex.size(), cpx(0, 0));
-    for (int threadIter = 0; threadIter < threadNum; ++threadIter) {
-      threads[threadIter] = std::thread(
-          [&](int begin, int end, const int threadId) {
-            if (threadId == threadNum - 1) end += remainder;
-            for (int j = begin; j < end; ++j) {
-              cpx sum = 0;
-              size_t lhsIter = rowIndex[i - 1], rhsIter = mat.rowIndex[j - 1];
-              while ((lhsIter < rowIndex[i]) && (rhsIter < mat.rowIndex[j])) {
-                if (colIndex[lhsIter] == mat.colIndex[rhsIter]) {
-                  sum += val[lhsIter++] * mat.val[rhsIter++];
-                } else {
-                  if (colIndex[lhsIter] < mat.colIndex[rhsIter])
-                    lhsIter++;
-                  else
-                    rhsIter++;
-                }
-              }
-              if (sum.real() != 0 || sum.imag() != 0) {
-                tmpVec[j - 1] = sum;
-                NonZeroCounter++;
-              }
-            }
-          },
-          threadIter * blockSize + 1, threadIter * blockSize + blockSize + 1,
-          threadIter);
-    }
-    for (int threadIter = 0; threadIter < threadNum; ++threadIter)
-      threads[threadIter].join();
-    for (size_t iter = 0; iter < mat.rowIndex.size(); ++iter)
-      if (tmpVec[iter].real() != 0 || tmpVec[iter].imag() != 0) {
-        res.val.push_back(tmpVec[iter]);
-        res.colIndex.push_back(iter);
-      }
-    res.rowIndex.push_back(NonZeroCounter);
-  }
+  res.col = mat.col;
+  res.rowIndex.resize(rows + 1);
+  const size_t nonZeros = pscan::exclusive_scan_std(
+      rowNonZeros.data(), res.rowIndex.data(), rows + 1);
+  res.colIndex.resize(nonZeros);
+  res.val.resize(nonZeros);
+  auto copier = [&](size_t t) {
+    size_t at = res.rowIndex[firstRow[t]];
+    std::copy(threadCol[t].begin(), threadCol[t].end(),
+              res.colIndex.begin() + at);
+    std::copy(threadVal[t].begin(), threadVal[t].end(), res.val.begin() + at);
+  };
+  threads.clear();
+  for (size_t t = 1; t < threadNum; ++t) threads.emplace_back(copier, t);
+  copier(0);
+  for (auto& thread : threads) thread.join();
   return res;
 }
 
+CRS_Matrix CRS_Matrix::parallelMultiply(const CRS_Matrix& mat) const& {
+  // mat is the transposed right factor, as for operator*
+  if (col != mat.col) throw std::runtime_error("Different numbers of cols");
+  return multiply(CRS_Matrix(mat).transpose());
+}
+
 CRS_Matrix CRS_Matrix::transpose() {
-  std::vector<std::vector<size_t>> index(col);
-  std::vector<std::vector<cpx>> values(col);
-  for (size_t i = 1; i < rowIndex.size(); ++i)
-    for (size_t j = rowIndex[i - 1]; j < rowIndex[i]; ++j) {
-      index[colIndex[j]].push_back(i - 1);
-      values[colIndex[j]].push_back(val[j]);
-    }
-  CRS_Matrix res;
-  res.col = row;
-  res.row = col;
-  size_t size = 0;
-  res.rowIndex.push_back(0);
-  for (size_t i = 0; i < col; ++i) {
-    for (size_t j = 0; j < index[i].size(); ++j) {
-      res.val.push_back(values[i][j]);
-      res.colIndex.push_back(index[i][j]);
-    }
-    size += index[i].size();
-    res.rowIndex.push_back(size);
-  }
+  CRS_Matrix res(val.size(), val.size(), col + 1, row, col);
+  // a default-constructed matrix has no row pointers at all
+  if (rowIndex.empty()) return res;
+  ptranspose::transpose_std(row, col, rowIndex.data(), colIndex.data(),
+                            val.data(), res.rowIndex.data(),
+                            res.colIndex.data(), res.val.data());
   return res;
 }
 
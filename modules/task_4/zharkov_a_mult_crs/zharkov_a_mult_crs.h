@@ -5,6 +5,8 @@
 #include <cmath>
 #include <complex>
 #include <iostream>
+#include <string>
+#include <utility>
 #include <vector>
 
 using cpx = std::complex<double>;
@@ -17,12 +19,13 @@ class CRS_Matrix {
 
  public:
   explicit CRS_Matrix(const std::vector<std::vector<cpx>>& matrix);
-  CRS_Matrix(const std::vector<cpx>& _val, const std::vector<size_t>& _colIndex,
-             const std::vector<size_t>& _rowIndex, const size_t& _col,
+  // the arrays are taken by value, pass them with std::move to avoid a copy
+  CRS_Matrix(std::vector<cpx> _val, std::vector<size_t> _colIndex,
+             std::vector<size_t> _rowIndex, const size_t& _col,
              const size_t& _row)
-      : val(_val),
-        colIndex(_colIndex),
-        rowIndex(_rowIndex),
+      : val(std::move(_val)),
+        colIndex(std::move(_colIndex)),
+        rowIndex(std::move(_rowIndex)),
         row(_row),
         col(_col) {}
   explicit CRS_Matrix(const size_t& valSize = 0, const size_t& colSize = 0,
@@ -35,13 +38,21 @@ class CRS_Matrix {
         col(_col) {}
   bool operator==(const CRS_Matrix& mat) const&;
   CRS_Matrix operator*(const CRS_Matrix& mat) const&;
+  // this * mat^T, mat is passed transposed like for operator*
   CRS_Matrix parallelMultiply(const CRS_Matrix& mat) const&;
+  // this * mat by Gustavson's method: row i of the result accumulates the
+  // rows of mat picked by row i of this. Each row goes to a dense or a
+  // hash accumulator depending on its product count
+  CRS_Matrix multiply(const CRS_Matrix& mat) const&;
   CRS_Matrix transpose();
-  std::vector<cpx> getVal() { return val; }
-  std::vector<size_t> getColIndex() { return colIndex; }
-  std::vector<size_t> getRowIndex() { return rowIndex; }
-  size_t getRow() { return row; }
-  size_t getCol() { return col; }
+  friend void writeMatrixMarket(const CRS_Matrix& mat,
+                                const std::string& path);
+  friend void writeBinaryCRS(const CRS_Matrix& mat, const std::string& path);
+  std::vector<cpx> getVal() const { return val; }
+  std::vector<size_t> getColIndex() const { return colIndex; }
+  std::vector<size_t> getRowIndex() const { return rowIndex; }
+  size_t getRow() const { return row; }
+  size_t getCol() const { return col; }
   std::vector<std::vector<cpx>> getSparseMatrix();
   void print();
 };